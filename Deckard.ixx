@@ -39,22 +39,27 @@ export import deckard.bigint;
 export import deckard.commandline;
 export import deckard.colors;
 export import deckard.cpuid;
+export import deckard.flat_map;
 export import deckard.function_ref;
 export import deckard.grid;
 export import deckard.helpers;
 export import deckard.hmac;
 export import deckard.lru;
+export import deckard.cache;
 export import deckard.random;
 export import deckard.ringbuffer;
 export import deckard.sbo;
 export import deckard.scope_exit;
 export import deckard.serializer;
+export import deckard.slot_map;
 export import deckard.sha;
 export import deckard.stringhelper;
 export import deckard.platform;
 export import deckard.threadutil;
 export import deckard.timers;
 export import deckard.utils.hash;
+export import deckard.utils.hash_batch;
+export import deckard.utils.tree_hash;
 export import deckard.uuid;
 export import deckard.logger;
 export import deckard.bytepool;
@@ -10,6 +10,7 @@ import deckard.stringhelper;
 import deckard.as;
 import deckard.net;
 import deckard.utils.hash;
+import deckard.flat_map;
 
 namespace fs = std::filesystem;
 using namespace std::string_view_literals;
@@ -97,14 +98,20 @@ namespace deckard
 		explicit operator double() const;
 	};
 
+	// Index keys are already utils::hash values
+	struct key_hash_passthrough
+	{
+		u64 operator()(u64 hash) const noexcept { return hash; }
+	};
+
 	export class config
 	{
 	private:
-		utf8::string                              m_data;
-		std::vector<TokenValue>                   tokens;
-		std::unordered_map<u64, std::vector<u64>> key_hash_to_token_index;
-		std::vector<parse_error>                  m_errors;
-		fs::path                                  filename;
+		utf8::string                                               m_data;
+		std::pmr::vector<TokenValue>                               tokens;
+		flat_map<u64, std::pmr::vector<u64>, key_hash_passthrough> key_hash_to_token_index;
+		std::pmr::vector<parse_error>                              m_errors;
+		fs::path                                                   filename;
 
 		void skip_until_newline(utf8::scanner& scan)
 		{
@@ -478,22 +485,33 @@ namespace deckard
 	public:
 		config() = default;
 
-		explicit config(fs::path file)
+		// Token and index storage comes from resource, the source text itself is not
+		explicit config(std::pmr::memory_resource* resource)
+			: tokens(resource)
+			, key_hash_to_token_index(resource)
+			, m_errors(resource)
+		{
+		}
+
+		explicit config(fs::path file, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+			: config(resource)
 		{
 			filename = file;
 			m_data   = file::read_text_file_as_utf8(file);
 			parse();
 		}
 
-		config(std::string_view input)
-			: m_data(input)
+		config(std::string_view input, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+			: config(resource)
 		{
+			m_data = utf8::string(input);
 			parse();
 		}
 
-		config(const utf8::string& input)
-			: m_data(input)
+		config(const utf8::string& input, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+			: config(resource)
 		{
+			m_data = input;
 			parse();
 		}
 
@@ -14,6 +14,8 @@ import deckard.helpers;
 import deckard.stringhelper;
 import deckard.random;
 import deckard.utils.hash;
+import deckard.utils.tree_hash;
+import deckard.taskpool;
 import deckard.utf8;
 
 namespace fs = std::filesystem;
@@ -923,12 +925,28 @@ namespace deckard::file
 	// ##################################################################################################################
 	// ##################################################################################################################
 
+	// utils::tree_xxh64 of the mapped file, leaves are hashed on the pool. Empty or missing files hash to 0
+	export u64 hash_file_contents(fs::path file, taskpool::taskpool& pool)
+	{
+		if (filesize(file).value_or(0) == 0)
+			return 0;
+
+		const auto view = map(file);
+		if (view.empty())
+			return 0;
+		return utils::tree_xxh64(view.data(), pool);
+	}
+
+	// Same value as above, computed on the calling thread
 	export u64 hash_file_contents(fs::path file)
 	{
-		auto contents = read(file);
-		if (contents.size() == 0)
+		if (filesize(file).value_or(0) == 0)
+			return 0;
+
+		const auto view = map(file);
+		if (view.empty())
 			return 0;
-		return utils::chibihash64(contents);
+		return utils::tree_xxh64(view.data());
 	}
 
 	// ##################################################################################################################
@@ -1,16 +1,9 @@
 module;
 
 export module deckard.filemonitor;
-import deckard.utils.hash;
+import deckard.flat_map;
 import std;
 
-struct MonitorHash
-{
-	using is_transparent = void;
-
-	std::size_t operator()(const std::string_view r) const { return deckard::utils::hash_values(r); }
-};
-
 export namespace deckard
 {
 	export enum class StatusFlag {
@@ -150,17 +143,17 @@ export namespace deckard
 		void update_deleted_files()
 		{
 			// Delete files
-			std::erase_if(m_files,
-						  [&](auto& it)
-						  {
-							  if (!std::filesystem::exists(it.first))
-							  {
-								  it.second.statuscode = StatusFlag::Deleted;
-								  callback(it.second);
-								  return true;
-							  }
-							  return false;
-						  });
+			erase_if(m_files,
+					 [&](auto& it)
+					 {
+						 if (!std::filesystem::exists(it.first))
+						 {
+							 it.second.statuscode = StatusFlag::Deleted;
+							 callback(it.second);
+							 return true;
+						 }
+						 return false;
+					 });
 		}
 
 		void update_files()
@@ -191,11 +184,11 @@ export namespace deckard
 			update_deleted_files();
 		}
 
-		std::unordered_map<std::string, MonitorData, MonitorHash, std::equal_to<>> m_files;
-		std::filesystem::path                                                      m_current_path;
-		std::jthread                                                               m_monitor_thread;
-		UserFunction*                                                              m_callback{nullptr};
-		unsigned int                                                               m_filter{0};
+		flat_map<std::string, MonitorData> m_files;
+		std::filesystem::path              m_current_path;
+		std::jthread                       m_monitor_thread;
+		UserFunction*                      m_callback{nullptr};
+		unsigned int                       m_filter{0};
 	};
 
 } // namespace deckard
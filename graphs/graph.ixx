@@ -10,6 +10,7 @@ import deckard.assert;
 import deckard.as;
 import deckard.debug;
 import deckard.arrays;
+import deckard.flat_map;
 
 namespace deckard::graph
 {
@@ -24,10 +25,12 @@ namespace deckard::graph
 	private:
 		using WeightedEdge = weighted_edge_t<T, Weight>;
 
-		std::vector<std::unordered_set<u64>>         adjacent_list{};
-		std::unordered_map<T, u64>                   index_map{};
-		std::vector<T>                               reverse_index{};
-		std::vector<std::unordered_map<u64, Weight>> edge_weights{};
+		// Neighbour order is observable through neighbors(), edges and traversals, so the
+		// adjacency sets stay node based, the lookup-only indices are flat
+		std::pmr::vector<std::pmr::unordered_set<u64>> adjacent_list{};
+		flat_map<T, u64>                               index_map{};
+		std::pmr::vector<T>                            reverse_index{};
+		std::pmr::vector<flat_map<u64, Weight>>        edge_weights{};
 
 		bool has_edge(u64 u, u64 v) const { return adjacent_list[u].find(v) != adjacent_list[u].end(); }
 
@@ -48,6 +51,15 @@ namespace deckard::graph
 	public:
 		graph() = default;
 
+		// Every node, edge and index allocation goes through resource
+		explicit graph(std::pmr::memory_resource* resource)
+			: adjacent_list(resource)
+			, index_map(resource)
+			, reverse_index(resource)
+			, edge_weights(resource)
+		{
+		}
+
 		u64 degree(const T& node) const
 		{
 			if (not index_map.contains(node))
@@ -178,4 +178,241 @@ namespace deckard::memory
 		[[nodiscard]] auto data() const { return std::span<const std::byte>(m_buffer.get(), m_offset); }
 	};
 
+	// ###########################################################################
+
+	// Arena that chains new blocks instead of failing, block sizes double up to max_block.
+	// Blocks never move, pointers stay valid until the memory is rewound or the arena destroyed.
+	//
+	//  auto& scratch = memory::thread_arena();
+	//  auto  scope   = scratch.scope(); // rewinds when it goes out of scope
+	//  auto  tokens  = scratch.allocate<token>(count);
+	//
+	// Rewinding keeps the blocks, so steady-state use does not touch the heap.
+
+	export class growing_arena
+	{
+	private:
+		struct block
+		{
+			bytearray data;
+			u64       capacity{0};
+			u64       offset{0};
+		};
+
+		std::vector<block> m_blocks;
+		u64                m_current{0};
+		u64                m_initial_block{0};
+		u64                m_max_block{0};
+
+		[[nodiscard]] static void* bump(block& b, u64 size_in_bytes, u64 align)
+		{
+			void* base  = b.data.get() + b.offset;
+			u64   space = b.capacity - b.offset;
+
+			void* aligned = std::align(align, size_in_bytes, base, space);
+			if (not aligned)
+				return nullptr;
+
+			b.offset = static_cast<std::byte*>(aligned) - b.data.get() + size_in_bytes;
+			return aligned;
+		}
+
+		[[nodiscard]] void* raw_allocate(u64 size_in_bytes, u64 align = alignof(std::max_align_t))
+		{
+			assert::check(std::has_single_bit(align), "Alignment must be a power of two");
+
+			if (not m_blocks.empty())
+			{
+				if (void* mem = bump(m_blocks[m_current], size_in_bytes, align))
+					return mem;
+
+				// blocks after the current one are empty, left over from an earlier rewind
+				while (m_current + 1 < m_blocks.size())
+				{
+					m_current++;
+					if (void* mem = bump(m_blocks[m_current], size_in_bytes, align))
+						return mem;
+				}
+			}
+
+			const u64 doubled  = m_blocks.empty() ? m_initial_block : std::min(m_blocks.back().capacity * 2, m_max_block);
+			const u64 capacity = std::max(doubled, size_in_bytes + align);
+
+			m_blocks.push_back({make_bytearray(capacity), capacity, 0});
+			m_current = m_blocks.size() - 1;
+
+			void* mem = bump(m_blocks[m_current], size_in_bytes, align);
+			assert::check(mem != nullptr, "New arena block too small for the allocation");
+			return mem;
+		}
+
+	public:
+		struct marker
+		{
+			u64 block{0};
+			u64 offset{0};
+		};
+
+		// Rewinds the arena to where it was when the scope was created
+		class scope_guard
+		{
+		private:
+			growing_arena* m_arena{nullptr};
+			marker         m_marker;
+
+		public:
+			explicit scope_guard(growing_arena& arena)
+				: m_arena(&arena)
+				, m_marker(arena.mark())
+			{
+			}
+
+			scope_guard(const scope_guard&)            = delete;
+			scope_guard& operator=(const scope_guard&) = delete;
+
+			~scope_guard()
+			{
+				if (m_arena)
+					m_arena->rewind(m_marker);
+			}
+		};
+
+		explicit growing_arena(u64 initial_block_in_bytes = 64_KiB, u64 max_block_in_bytes = 16_MiB)
+			: m_initial_block(initial_block_in_bytes)
+			, m_max_block(std::max(initial_block_in_bytes, max_block_in_bytes))
+		{
+			assert::check(initial_block_in_bytes > 0, "Arena block size must be non-zero");
+		}
+
+		growing_arena(const growing_arena&)            = delete;
+		growing_arena& operator=(const growing_arena&) = delete;
+
+		growing_arena(growing_arena&&)            = default;
+		growing_arena& operator=(growing_arena&&) = default;
+
+		template<trivially_destructible T = std::byte>
+		[[nodiscard]] std::span<T> allocate(u64 count = 1, u64 alignment = alignof(T))
+		{
+			void* mem = raw_allocate(sizeof(T) * count, alignment);
+
+			assert::check(is_pointer_aligned(mem, alignment), "Aligned pointer is not aligned to the requested alignment");
+
+			return {static_cast<T*>(mem), count};
+		}
+
+		template<trivially_destructible T, typename... Args>
+		[[nodiscard]] T* create(Args&&... args)
+		{
+			void* mem = raw_allocate(sizeof(T), alignof(T));
+			return std::construct_at(static_cast<T*>(mem), std::forward<Args>(args)...);
+		}
+
+		template<trivially_destructible T, typename... Args>
+		[[nodiscard]] std::span<T> create_array(u64 count, const Args&... args)
+		{
+			void* mem = raw_allocate(sizeof(T) * count, alignof(T));
+
+			std::span<T> result(static_cast<T*>(mem), count);
+			for (auto& elem : result)
+				std::construct_at(&elem, args...);
+
+			return result;
+		}
+
+		[[nodiscard]] marker mark() const
+		{
+			if (m_blocks.empty())
+				return {};
+			return {m_current, m_blocks[m_current].offset};
+		}
+
+		// Frees everything allocated after m was taken, the blocks are kept for reuse
+		void rewind(marker m)
+		{
+			if (m_blocks.empty())
+				return;
+
+			assert::check(m.block < m_blocks.size(), "Arena marker from a different arena");
+			assert::check(m.block < m_current or (m.block == m_current and m.offset <= m_blocks[m_current].offset), "Arena marker is newer than the arena");
+
+			for (u64 i = m.block + 1; i <= m_current; ++i)
+				m_blocks[i].offset = 0;
+
+			m_current                   = m.block;
+			m_blocks[m_current].offset = m.offset;
+		}
+
+		[[nodiscard]] scope_guard scope() { return scope_guard(*this); }
+
+		void reset() { rewind({}); }
+
+		// Frees all blocks but the first
+		void release()
+		{
+			if (m_blocks.size() > 1)
+				m_blocks.resize(1);
+			reset();
+		}
+
+		[[nodiscard]] u64 capacity() const
+		{
+			u64 total = 0;
+			for (const auto& b : m_blocks)
+				total += b.capacity;
+			return total;
+		}
+
+		[[nodiscard]] u64 used() const
+		{
+			u64 total = 0;
+			for (u64 i = 0; i < m_blocks.size() and i <= m_current; ++i)
+				total += m_blocks[i].offset;
+			return total;
+		}
+
+		[[nodiscard]] u64 block_count() const { return m_blocks.size(); }
+	};
+
+	// Per-thread scratch arena, taskpool workers each get their own
+	export [[nodiscard]] growing_arena& thread_arena()
+	{
+		static thread_local growing_arena arena;
+		return arena;
+	}
+
+	// ###########################################################################
+
+	// std::pmr adapter for stackarena, arena and growing_arena
+	//
+	//  memory::arena          frame(64_KiB);
+	//  memory::arena_resource resource(frame);
+	//  std::pmr::vector<token> tokens(&resource);
+	//
+	// Deallocation is a no-op, the memory comes back when the arena is reset or rewound,
+	// so containers must not outlive that. Throws std::bad_alloc when a fixed arena is full.
+	export template<typename Arena>
+	class arena_resource final : public std::pmr::memory_resource
+	{
+	private:
+		Arena* m_arena{nullptr};
+
+		void* do_allocate(std::size_t bytes, std::size_t alignment) override
+		{
+			auto mem = m_arena->template allocate<std::byte>(std::max<std::size_t>(bytes, 1), alignment);
+			if (mem.empty())
+				throw std::bad_alloc();
+			return mem.data();
+		}
+
+		void do_deallocate(void*, std::size_t, std::size_t) override { }
+
+		bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+	public:
+		explicit arena_resource(Arena& source)
+			: m_arena(&source)
+		{
+		}
+	};
+
 } // namespace deckard::memory
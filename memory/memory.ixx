@@ -2,6 +2,7 @@ export module deckard.memory;
 
 export import :arena;
 export import :pool;
+export import :tracking;
 
 import std;
 
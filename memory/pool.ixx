@@ -2,20 +2,343 @@ export module deckard.memory:pool;
 
 import std;
 import deckard.types;
+import deckard.assert;
 
 namespace deckard::memory
 {
+	// Size-class pool allocator for small, short-lived objects
 	//
-	constexpr u32   BLOCK_SIZE_IN_BYTES = 16; // bytes
+	//  auto* node = static_cast<node_t*>(memory::allocate(sizeof(node_t), alignof(node_t)));
+	//  memory::deallocate(node, sizeof(node_t), alignof(node_t));
+	//
+	//  std::pmr::vector<token> tokens(memory::pool_memory_resource());
+	//
+	// Requests are rounded up to one of class_count size classes, 16 byte steps up to 128 bytes
+	// and four classes per power of two above that, up to MAX_SMALL_SIZE. Each thread keeps a free
+	// list per class, refilled and drained in batches through a shared depot, so allocate and
+	// deallocate are O(1) and only take a lock once per batch. Larger requests go to operator new.
+	//
+	// Memory freed to the pool is kept for reuse and never returned to the system.
+
+	constexpr u32 BLOCK_SIZE_IN_BYTES    = 16; // bytes
 	constexpr u64 ABSOLUTE_MAX_ALLOCATED = 256_MiB;
 
-	std::vector<u8> global_memory_pool;
+	export constexpr u64 MAX_SMALL_SIZE = 16_KiB;
+	constexpr u64        CHUNK_SIZE     = 1_MiB;
+	constexpr u64        CHUNK_ALIGN    = 4_KiB;
+	constexpr u64        BATCH_BYTES    = 32_KiB;
+
+	export constexpr u32 class_count = 8 + (std::bit_width(MAX_SMALL_SIZE - 1) - 7) * 4;
+
+	// Smallest class that fits size, size must be in [1, MAX_SMALL_SIZE]
+	export [[nodiscard]] constexpr u32 size_class(u64 size) noexcept
+	{
+		if (size <= 128)
+			return static_cast<u32>((std::max<u64>(size, 1) + BLOCK_SIZE_IN_BYTES - 1) / BLOCK_SIZE_IN_BYTES - 1);
+
+		const u32 exponent = static_cast<u32>(std::bit_width(size - 1));
+		const u64 base     = 1ull << (exponent - 1);
+		return 8 + (exponent - 8) * 4 + static_cast<u32>((size - 1 - base) >> (exponent - 3));
+	}
 
-	export void initialize([[maybe_unused]]u64 max_size_in_kibibytes) 
+	export [[nodiscard]] constexpr u64 class_size(u32 index) noexcept
 	{
+		if (index < 8)
+			return (index + 1) * BLOCK_SIZE_IN_BYTES;
 
+		const u32 exponent = 8 + (index - 8) / 4;
+		const u64 step     = (index - 8) % 4 + 1;
+		return (1ull << (exponent - 1)) + step * (1ull << (exponent - 3));
 	}
 
+	static_assert(class_size(class_count - 1) == MAX_SMALL_SIZE);
+	static_assert(size_class(MAX_SMALL_SIZE) == class_count - 1);
+
+	export struct pool_stats
+	{
+		u64 reserved{0};    // bytes held in chunks for the size classes
+		u64 budget{0};      // limit for reserved, set with initialize()
+		u64 large_bytes{0}; // bytes currently allocated past MAX_SMALL_SIZE
+	};
+
+	namespace detail
+	{
+		struct free_node
+		{
+			free_node* next{nullptr};
+		};
+
+		struct chain
+		{
+			free_node* head{nullptr};
+			u32        count{0};
+		};
+
+		// Blocks of at least align bytes alignment, small requests only
+		[[nodiscard]] constexpr bool is_small(u64 size, u64 align) noexcept
+		{
+			return std::bit_ceil(std::max(size, align)) <= MAX_SMALL_SIZE and align <= CHUNK_ALIGN;
+		}
+
+		// Over-aligned requests use the power of two class, its blocks are aligned to their size
+		[[nodiscard]] constexpr u32 class_for(u64 size, u64 align) noexcept
+		{
+			if (align <= BLOCK_SIZE_IN_BYTES)
+				return size_class(size);
+			return size_class(std::bit_ceil(std::max(size, align)));
+		}
+
+		[[nodiscard]] constexpr u32 batch_size(u32 index) noexcept
+		{
+			return static_cast<u32>(std::clamp<u64>(BATCH_BYTES / class_size(index), 2, 64));
+		}
+
+		// Shared between threads, holds full chains per class and carves new ones from chunks
+		class depot
+		{
+		private:
+			struct size_bin
+			{
+				std::mutex         mutex;
+				std::vector<chain> chains;
+			};
+
+			std::array<size_bin, class_count> m_bins;
+
+			std::mutex              m_chunk_mutex;
+			std::vector<std::byte*> m_chunks;
+			u64                     m_chunk_offset{CHUNK_SIZE};
+
+			std::atomic<u64> m_reserved{0};
+			std::atomic<u64> m_budget{ABSOLUTE_MAX_ALLOCATED};
+			std::atomic<u64> m_large{0};
+
+			chain carve(u32 index)
+			{
+				const u64 size  = class_size(index);
+				const u32 count = batch_size(index);
+				const u64 align = std::has_single_bit(size) ? std::min(size, CHUNK_ALIGN) : BLOCK_SIZE_IN_BYTES;
+
+				std::scoped_lock lock(m_chunk_mutex);
+
+				u64 offset = (m_chunk_offset + align - 1) & ~(align - 1);
+				if (offset + size * count > CHUNK_SIZE)
+				{
+					if (m_reserved.load(std::memory_order_relaxed) + CHUNK_SIZE > m_budget.load(std::memory_order_relaxed))
+						throw std::bad_alloc();
+
+					m_chunks.push_back(static_cast<std::byte*>(::operator new(CHUNK_SIZE, std::align_val_t{CHUNK_ALIGN})));
+					m_reserved.fetch_add(CHUNK_SIZE, std::memory_order_relaxed);
+					offset = 0;
+				}
+
+				std::byte* base = m_chunks.back() + offset;
+				m_chunk_offset  = offset + size * count;
+
+				chain result{nullptr, count};
+				for (u32 i = count; i-- > 0;)
+				{
+					auto* node  = std::construct_at(reinterpret_cast<free_node*>(base + i * size));
+					node->next  = result.head;
+					result.head = node;
+				}
+				return result;
+			}
+
+		public:
+			[[nodiscard]] chain take(u32 index)
+			{
+				auto& bin = m_bins[index];
+				{
+					std::scoped_lock lock(bin.mutex);
+					if (not bin.chains.empty())
+					{
+						const chain result = bin.chains.back();
+						bin.chains.pop_back();
+						return result;
+					}
+				}
+				return carve(index);
+			}
+
+			void give(u32 index, chain returned)
+			{
+				if (returned.count == 0)
+					return;
+
+				auto&            bin = m_bins[index];
+				std::scoped_lock lock(bin.mutex);
+				bin.chains.push_back(returned);
+			}
+
+			void set_budget(u64 bytes) noexcept { m_budget.store(bytes, std::memory_order_relaxed); }
+
+			void add_large(i64 bytes) noexcept { m_large.fetch_add(static_cast<u64>(bytes), std::memory_order_relaxed); }
+
+			[[nodiscard]] pool_stats stats() const noexcept
+			{
+				return {
+				  .reserved    = m_reserved.load(std::memory_order_relaxed),
+				  .budget      = m_budget.load(std::memory_order_relaxed),
+				  .large_bytes = m_large.load(std::memory_order_relaxed),
+				};
+			}
+		};
+
+		// Never destroyed, thread caches flush into it when their threads exit
+		depot& global_depot()
+		{
+			static depot* instance = new depot;
+			return *instance;
+		}
+
+		// Frees from thread_local destructors that run after the cache is gone go to the depot directly
+		enum class cache_state : u8 {
+			unborn,
+			alive,
+			dead,
+		};
+
+		thread_local cache_state local_cache_state = cache_state::unborn;
 
+		class thread_cache
+		{
+		private:
+			std::array<chain, class_count> m_lists{};
+
+		public:
+			thread_cache() { local_cache_state = cache_state::alive; }
+
+			~thread_cache()
+			{
+				local_cache_state = cache_state::dead;
+				for (u32 i = 0; i < class_count; ++i)
+					global_depot().give(i, std::exchange(m_lists[i], {}));
+			}
+
+			[[nodiscard]] void* pop(u32 index)
+			{
+				auto& list = m_lists[index];
+				if (list.head == nullptr)
+					list = global_depot().take(index);
+
+				free_node* node = list.head;
+				list.head       = node->next;
+				list.count--;
+				return node;
+			}
+
+			void push(u32 index, void* ptr)
+			{
+				auto& list = m_lists[index];
+				auto* node = std::construct_at(static_cast<free_node*>(ptr));
+				node->next = list.head;
+				list.head  = node;
+				list.count++;
+
+				// keep one batch cached, hand the rest back so other threads can reuse it
+				const u32 batch = batch_size(index);
+				if (list.count >= batch * 2)
+				{
+					chain      returned{list.head, batch};
+					free_node* last = list.head;
+					for (u32 i = 1; i < batch; ++i)
+						last = last->next;
+
+					list.head  = last->next;
+					list.count -= batch;
+					last->next = nullptr;
+					global_depot().give(index, returned);
+				}
+			}
+		};
+
+		thread_cache& local_cache()
+		{
+			static thread_local thread_cache cache;
+			return cache;
+		}
+
+	} // namespace detail
+
+	// Limits the memory reserved for the size classes, clamped to ABSOLUTE_MAX_ALLOCATED.
+	// Once reached, small allocations that need a new chunk throw std::bad_alloc.
+	export void initialize(u64 max_size_in_kibibytes)
+	{
+		const u64 bytes = max_size_in_kibibytes * 1_KiB;
+		detail::global_depot().set_budget(bytes == 0 ? ABSOLUTE_MAX_ALLOCATED : std::min(bytes, ABSOLUTE_MAX_ALLOCATED));
+	}
+
+	export [[nodiscard]] void* allocate(u64 size_in_bytes, u64 alignment = alignof(std::max_align_t))
+	{
+		assert::check(std::has_single_bit(alignment), "Alignment must be a power of two");
+
+		if (not detail::is_small(size_in_bytes, alignment))
+		{
+			detail::global_depot().add_large(static_cast<i64>(size_in_bytes));
+			return ::operator new(size_in_bytes, std::align_val_t{alignment});
+		}
+
+		const u32 index = detail::class_for(size_in_bytes, alignment);
+
+		if (detail::local_cache_state == detail::cache_state::dead)
+		{
+			auto  spare = detail::global_depot().take(index);
+			void* mem   = std::exchange(spare.head, spare.head->next);
+			spare.count--;
+			detail::global_depot().give(index, spare);
+			return mem;
+		}
+
+		return detail::local_cache().pop(index);
+	}
+
+	// size_in_bytes and alignment must match the allocate call
+	export void deallocate(void* ptr, u64 size_in_bytes, u64 alignment = alignof(std::max_align_t))
+	{
+		if (ptr == nullptr)
+			return;
+
+		if (not detail::is_small(size_in_bytes, alignment))
+		{
+			::operator delete(ptr, std::align_val_t{alignment});
+			detail::global_depot().add_large(-static_cast<i64>(size_in_bytes));
+			return;
+		}
+
+		const u32 index = detail::class_for(size_in_bytes, alignment);
+
+		if (detail::local_cache_state == detail::cache_state::dead)
+		{
+			detail::global_depot().give(index, {std::construct_at(static_cast<detail::free_node*>(ptr)), 1});
+			return;
+		}
+
+		detail::local_cache().push(index, ptr);
+	}
+
+	export [[nodiscard]] pool_stats stats() noexcept { return detail::global_depot().stats(); }
+
+	// ###########################################################################
+
+	// std::pmr adapter, all instances share the global pool
+	export class pool_resource final : public std::pmr::memory_resource
+	{
+	private:
+		void* do_allocate(std::size_t bytes, std::size_t alignment) override { return memory::allocate(bytes, alignment); }
+
+		void do_deallocate(void* ptr, std::size_t bytes, std::size_t alignment) override { memory::deallocate(ptr, bytes, alignment); }
+
+		bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+		{
+			return dynamic_cast<const pool_resource*>(&other) != nullptr;
+		}
+	};
+
+	export [[nodiscard]] std::pmr::memory_resource* pool_memory_resource()
+	{
+		static pool_resource resource;
+		return &resource;
+	}
 
-}
+} // namespace deckard::memory
@@ -0,0 +1,244 @@
+export module deckard.memory:tracking;
+
+import std;
+import deckard.types;
+import deckard.helpers;
+
+namespace deckard::memory
+{
+	// Per-subsystem memory accounting, enabled with the DECKARD_MEMORY_TRACKING CMake option
+	//
+	//  memory::arena            frame(1_MiB);
+	//  memory::arena_resource   frame_resource(frame);
+	//  memory::tracked_resource lexer_memory("lexer", &frame_resource);
+	//
+	//  bytepool tokens(4096, lexer_memory.get());
+	//  lru_cache<u64, image> images(64, memory::tracked("images"));
+	//  ...
+	//  dbg::println("{}", memory::tracking_report());
+	//
+	// tracked_resource is owned by the caller and must outlive the containers using it, keep it next
+	// to its upstream. tracked(tag) is only for containers that live as long as the program.
+	// When disabled both hand out the upstream resource itself, nothing is wrapped or counted.
+	// tracking_resource can still be used directly to measure one container.
+
+#ifdef DECKARD_MEMORY_TRACKING
+	export constexpr bool tracking = true;
+#else
+	export constexpr bool tracking = false;
+#endif
+
+	export struct allocation_stats
+	{
+		std::string tag;
+		u64         current_bytes{0};
+		u64         peak_bytes{0};
+		u64         total_bytes{0}; // every byte ever allocated
+		u64         allocations{0};
+		u64         deallocations{0};
+
+		[[nodiscard]] u64 live_allocations() const noexcept { return allocations - deallocations; }
+	};
+
+	namespace detail
+	{
+		struct tag_counters
+		{
+			std::atomic<u64> current{0};
+			std::atomic<u64> peak{0};
+			std::atomic<u64> total{0};
+			std::atomic<u64> allocations{0};
+			std::atomic<u64> deallocations{0};
+
+			void on_allocate(u64 bytes) noexcept
+			{
+				const u64 now = current.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+				total.fetch_add(bytes, std::memory_order_relaxed);
+				allocations.fetch_add(1, std::memory_order_relaxed);
+
+				u64 seen = peak.load(std::memory_order_relaxed);
+				while (now > seen and not peak.compare_exchange_weak(seen, now, std::memory_order_relaxed))
+				{
+				}
+			}
+
+			void on_deallocate(u64 bytes) noexcept
+			{
+				current.fetch_sub(bytes, std::memory_order_relaxed);
+				deallocations.fetch_add(1, std::memory_order_relaxed);
+			}
+		};
+
+		// Tags are never removed, counters stay valid for the lifetime of the program
+		class tracking_registry
+		{
+		private:
+			mutable std::mutex                                                m_mutex;
+			std::map<std::string, std::unique_ptr<tag_counters>, std::less<>> m_tags;
+
+		public:
+			[[nodiscard]] tag_counters& counters(std::string_view tag)
+			{
+				std::scoped_lock lock(m_mutex);
+
+				auto it = m_tags.find(tag);
+				if (it == m_tags.end())
+					it = m_tags.emplace(std::string(tag), std::make_unique<tag_counters>()).first;
+				return *it->second;
+			}
+
+			[[nodiscard]] std::vector<allocation_stats> snapshot() const
+			{
+				std::scoped_lock lock(m_mutex);
+
+				std::vector<allocation_stats> result;
+				result.reserve(m_tags.size());
+				for (const auto& [tag, c] : m_tags)
+				{
+					result.push_back({
+					  .tag           = tag,
+					  .current_bytes = c->current.load(std::memory_order_relaxed),
+					  .peak_bytes    = c->peak.load(std::memory_order_relaxed),
+					  .total_bytes   = c->total.load(std::memory_order_relaxed),
+					  .allocations   = c->allocations.load(std::memory_order_relaxed),
+					  .deallocations = c->deallocations.load(std::memory_order_relaxed),
+					});
+				}
+				return result;
+			}
+
+			void reset_peaks()
+			{
+				std::scoped_lock lock(m_mutex);
+				for (auto& [tag, c] : m_tags)
+					c->peak.store(c->current.load(std::memory_order_relaxed), std::memory_order_relaxed);
+			}
+		};
+
+		// Never destroyed, containers may still free memory during static destruction
+		tracking_registry& registry()
+		{
+			static tracking_registry* instance = new tracking_registry;
+			return *instance;
+		}
+
+	} // namespace detail
+
+	// Counts every allocation that passes through it under tag, then forwards to upstream
+	export class tracking_resource final : public std::pmr::memory_resource
+	{
+	private:
+		std::pmr::memory_resource* m_upstream{nullptr};
+		detail::tag_counters*      m_counters{nullptr};
+
+		void* do_allocate(std::size_t bytes, std::size_t alignment) override
+		{
+			void* ptr = m_upstream->allocate(bytes, alignment);
+			m_counters->on_allocate(bytes);
+			return ptr;
+		}
+
+		void do_deallocate(void* ptr, std::size_t bytes, std::size_t alignment) override
+		{
+			m_upstream->deallocate(ptr, bytes, alignment);
+			m_counters->on_deallocate(bytes);
+		}
+
+		bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+		{
+			if (this == &other)
+				return true;
+
+			const auto* tracker = dynamic_cast<const tracking_resource*>(&other);
+			return tracker != nullptr and m_upstream->is_equal(*tracker->m_upstream);
+		}
+
+	public:
+		explicit tracking_resource(std::string_view tag, std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+			: m_upstream(upstream)
+			, m_counters(&detail::registry().counters(tag))
+		{
+		}
+
+		tracking_resource(const tracking_resource&)            = delete;
+		tracking_resource& operator=(const tracking_resource&) = delete;
+
+		[[nodiscard]] std::pmr::memory_resource* upstream() const noexcept { return m_upstream; }
+	};
+
+	// upstream wrapped in a tracking_resource for tag, or upstream itself when tracking is disabled.
+	// get() is valid while this object lives, it must outlive every container allocating through it.
+	export class tracked_resource
+	{
+	private:
+		std::optional<tracking_resource> m_tracker;
+		std::pmr::memory_resource*       m_resource{nullptr};
+
+	public:
+		explicit tracked_resource(std::string_view tag, std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+			: m_resource(upstream)
+		{
+			if constexpr (tracking)
+				m_resource = &m_tracker.emplace(tag, upstream);
+		}
+
+		tracked_resource(const tracked_resource&)            = delete;
+		tracked_resource& operator=(const tracked_resource&) = delete;
+
+		[[nodiscard]] std::pmr::memory_resource* get() const noexcept { return m_resource; }
+	};
+
+	// The default resource wrapped for tag, for containers that live until the program exits.
+	// One wrapper per tag, created around the default resource of the first call and never destroyed.
+	export [[nodiscard]] std::pmr::memory_resource* tracked(std::string_view tag)
+	{
+		if constexpr (not tracking)
+		{
+			(void)tag;
+			return std::pmr::get_default_resource();
+		}
+		else
+		{
+			static std::mutex mutex;
+			static auto*      wrappers = new std::map<std::string, std::unique_ptr<tracking_resource>, std::less<>>;
+
+			std::scoped_lock lock(mutex);
+
+			auto it = wrappers->find(tag);
+			if (it == wrappers->end())
+				it = wrappers->emplace(std::string(tag), std::make_unique<tracking_resource>(tag)).first;
+			return it->second.get();
+		}
+	}
+
+	// Every tag seen so far, sorted by name
+	export [[nodiscard]] std::vector<allocation_stats> tracking_snapshot() { return detail::registry().snapshot(); }
+
+	// Peaks restart from the current usage, e.g. at the start of a frame or request
+	export void reset_tracking_peaks() { detail::registry().reset_peaks(); }
+
+	export [[nodiscard]] std::string tracking_report()
+	{
+		const auto stats = tracking_snapshot();
+
+		u64 width = 3;
+		for (const auto& s : stats)
+			width = std::max<u64>(width, s.tag.size());
+
+		std::string report = std::format("{:<{}}  {:>12}  {:>12}  {:>12}  {:>10}  {:>10}\n", "tag", width, "current", "peak", "total", "allocs", "live");
+		for (const auto& s : stats)
+		{
+			report += std::format(
+			  "{:<{}}  {:>12}  {:>12}  {:>12}  {:>10}  {:>10}\n",
+			  s.tag,
+			  width,
+			  human_readable_bytes(s.current_bytes),
+			  human_readable_bytes(s.peak_bytes),
+			  human_readable_bytes(s.total_bytes),
+			  s.allocations,
+			  s.live_allocations());
+		}
+		return report;
+	}
+
+} // namespace deckard::memory
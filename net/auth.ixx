@@ -98,24 +98,44 @@ namespace deckard::net
 	// Brute-force a counter satisfying the challenge. Returns std::nullopt on
 	// exhaustion (counter wraps past UINT32_MAX without a solution — astronomically
 	// unlikely for difficulty <= 30).
+	// Counters are hashed in batches through sha256::hash_many, the lowest winning
+	// counter is still the one returned.
 	export [[nodiscard]] std::optional<pow_response> solve_challenge(const pow_challenge& challenge)
 	{
-		auto nonce_span = std::span<const u8, 32>{challenge.nonce};
+		constexpr u64 batch_size = 64;
+		constexpr u64 last       = std::numeric_limits<u32>::max();
 
-		for (u32 counter = 0; ; ++counter)
+		std::array<std::array<u8, 36>, batch_size>  messages;
+		std::array<std::span<const u8>, batch_size> spans;
+		std::array<sha256::digest, batch_size>      digests;
+
+		for (u64 i = 0; i < batch_size; ++i)
 		{
-			auto digest = detail::pow_hash(nonce_span, counter);
+			std::copy(challenge.nonce.begin(), challenge.nonce.end(), messages[i].begin());
+			spans[i] = messages[i];
+		}
 
-			if (detail::leading_zero_bits(digest) >= challenge.difficulty)
+		for (u64 first = 0; first <= last; first += batch_size)
+		{
+			const u64 count = std::min(batch_size, last - first + 1);
+			for (u64 i = 0; i < count; ++i)
 			{
-				pow_response r;
-				r.nonce   = challenge.nonce;
-				r.counter = counter;
-				return r;
+				const auto counter_bytes = detail::le32_bytes(as<u32>(first + i));
+				std::copy(counter_bytes.begin(), counter_bytes.end(), messages[i].begin() + 32);
 			}
 
-			if (counter == std::numeric_limits<u32>::max())
-				break;
+			sha256::hash_many(std::span{spans}.first(count), std::span{digests}.first(count));
+
+			for (u64 i = 0; i < count; ++i)
+			{
+				if (detail::leading_zero_bits(digests[i]) >= challenge.difficulty)
+				{
+					pow_response r;
+					r.nonce   = challenge.nonce;
+					r.counter = as<u32>(first + i);
+					return r;
+				}
+			}
 		}
 		return std::nullopt;
 	}
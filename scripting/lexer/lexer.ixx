@@ -449,9 +449,10 @@ namespace deckard::lexer
 	 */
 
 
+	// Shared by every tokenize call, files can be tokenized in parallel
 	export namespace detail
 	{
-		string_pool pool;
+		concurrent_string_pool pool;
 	};
 
 	export std::generator<Token> tokenize(utf8::view buffer, const TokenizeConfig config = {})
@@ -463,11 +464,6 @@ namespace deckard::lexer
 		size_t        id     = limits::max<size_t>;
 		TokenKind     type   = TokenKind::EOF;
 
-		if (detail::pool.empty())
-		{
-			(void)detail::pool.add("__INVALID_TOKEN__"sv);
-		}
-
 		if (not config.single_line_comment_start.empty() and
 			(config.single_line_comment_start == config.block_comment_start or
 			 config.single_line_comment_start == config.block_comment_end))
@@ -1298,7 +1294,7 @@ namespace deckard::lexer
 		  .column = column,
 		  .offset = as<u32>(cursor - buffer),
 		  .length = 0,
-		  .id     = 0,
+		  .id     = limits::max<u64>,
 		  .type   = TokenKind::EOF,
 		  .error  = TokenError::None};
 		co_return;
@@ -0,0 +1,211 @@
+#include <catch2/catch_test_macros.hpp>
+
+import std;
+import deckard.types;
+import deckard.lru;
+import deckard.cache;
+
+using namespace deckard;
+
+static_assert(cache_policy<lru_cache<u64, u64>, u64, u64>);
+static_assert(cache_policy<sieve_cache<u64, u64>, u64, u64>);
+static_assert(cache_policy<clock_cache<u64, u64>, u64, u64>);
+static_assert(cache_policy<tinylfu_cache<u64, u64>, u64, u64>);
+
+namespace
+{
+	// Zipf distributed keys in [0, key_count), rank 0 is the most popular
+	std::vector<u64> zipf_trace(u64 length, u64 key_count, f64 skew, u32 seed)
+	{
+		std::vector<f64> cdf(key_count);
+		f64              sum = 0.0;
+		for (u64 i = 0; i < key_count; ++i)
+		{
+			sum += 1.0 / std::pow(static_cast<f64>(i + 1), skew);
+			cdf[i] = sum;
+		}
+
+		std::mt19937_64                  rng(seed);
+		std::uniform_real_distribution<> uniform(0.0, sum);
+
+		std::vector<u64> trace(length);
+		for (auto& key : trace)
+			key = static_cast<u64>(std::ranges::lower_bound(cdf, uniform(rng)) - cdf.begin());
+		return trace;
+	}
+
+	// Zipf traffic with a one-off sequential scan of never repeated keys every period accesses
+	std::vector<u64> scan_trace(u64 length, u64 key_count, u64 period, u64 scan_length)
+	{
+		auto trace = zipf_trace(length, key_count, 0.9, 7);
+
+		std::vector<u64> result;
+		u64              next_scan_key = key_count;
+		for (u64 i = 0; i < trace.size(); ++i)
+		{
+			result.push_back(trace[i]);
+			if (i % period == period - 1)
+				for (u64 j = 0; j < scan_length; ++j)
+					result.push_back(next_scan_key++);
+		}
+		return result;
+	}
+
+	template<typename Cache>
+	void check_policy_basics()
+	{
+		Cache cache(4);
+
+		cache.put(1, 10);
+		cache.put(2, 20);
+		CHECK(cache.size() == 2);
+		CHECK(*cache.get(1) == 10);
+		CHECK(*cache.peek(2) == 20);
+		CHECK(cache.get(3) == nullptr);
+
+		cache.put(1, 11);
+		CHECK(*cache.get(1) == 11);
+		CHECK(cache.size() == 2);
+
+		for (u64 i = 10; i < 100; ++i)
+			cache.put(i, i);
+		CHECK(cache.size() == cache.capacity());
+
+		const bool had_99 = cache.exists(99);
+		CHECK(cache.erase(99) == had_99);
+		CHECK(cache.exists(99) == false);
+
+		cache.clear();
+		CHECK(cache.size() == 0);
+		CHECK(cache.get(1) == nullptr);
+	}
+} // namespace
+
+TEST_CASE("cache policies", "[cache]")
+{
+	SECTION("interface")
+	{
+		check_policy_basics<sieve_cache<u64, u64>>();
+		check_policy_basics<clock_cache<u64, u64>>();
+		check_policy_basics<tinylfu_cache<u64, u64>>();
+	}
+
+	SECTION("sieve keeps visited entries")
+	{
+		sieve_cache<int, int> cache(3);
+		cache.put(1, 1);
+		cache.put(2, 2);
+		cache.put(3, 3);
+
+		(void)cache.get(1);
+		cache.put(4, 4); // 1 is visited, 2 is the oldest unvisited
+		CHECK(cache.exists(1));
+		CHECK(cache.exists(2) == false);
+
+		cache.put(5, 5); // hand moved on to 3
+		CHECK(cache.exists(3) == false);
+		CHECK(cache.exists(1));
+	}
+
+	SECTION("clock gives a second chance")
+	{
+		clock_cache<int, int> cache(3);
+		cache.put(1, 1);
+		cache.put(2, 2);
+		cache.put(3, 3);
+
+		(void)cache.get(1);
+		(void)cache.get(2);
+		cache.put(4, 4);
+		CHECK(cache.exists(1));
+		CHECK(cache.exists(2));
+		CHECK(cache.exists(3) == false);
+	}
+
+	SECTION("string keys")
+	{
+		tinylfu_cache<std::string, int> cache(16);
+		for (int i = 0; i < 64; ++i)
+			cache.put(std::format("key{}", i % 20), i);
+
+		CHECK(cache.size() <= 16);
+		CHECK(*cache.get("key3") == 63); // newest key is still in the window
+	}
+
+	SECTION("count-min sketch")
+	{
+		count_min_sketch sketch(64);
+
+		for (u64 i = 0; i < 10; ++i)
+			sketch.increment(0x1234'5678'9ABC'DEF0ull);
+		sketch.increment(42);
+
+		CHECK(sketch.frequency(0x1234'5678'9ABC'DEF0ull) >= 10);
+		CHECK(sketch.frequency(42) >= 1);
+		CHECK(sketch.frequency(42) < 10);
+
+		for (u64 i = 0; i < 100; ++i)
+			sketch.increment(0x1234'5678'9ABC'DEF0ull);
+		CHECK(sketch.frequency(0x1234'5678'9ABC'DEF0ull) == 15);
+
+		sketch.clear();
+		CHECK(sketch.frequency(42) == 0);
+	}
+
+	SECTION("scan resistance")
+	{
+		const auto trace = scan_trace(100'000, 10'000, 1'000, 2'000);
+
+		lru_cache<u64, u64>     lru(1'000);
+		sieve_cache<u64, u64>   sieve(1'000);
+		tinylfu_cache<u64, u64> tinylfu(1'000);
+
+		const auto lru_result     = replay(lru, std::span<const u64>(trace));
+		const auto sieve_result   = replay(sieve, std::span<const u64>(trace));
+		const auto tinylfu_result = replay(tinylfu, std::span<const u64>(trace));
+
+		CHECK(lru_result.hits + lru_result.misses == trace.size());
+		CHECK(sieve_result.hit_ratio() > lru_result.hit_ratio());
+		CHECK(tinylfu_result.hit_ratio() > lru_result.hit_ratio());
+	}
+}
+
+// DECKARD_CACHE_TRACE names a recorded trace, one integer key per line
+TEST_CASE("cache policy benchmark", "[cache][.benchmark]")
+{
+	std::vector<std::pair<std::string, std::vector<u64>>> traces;
+
+	if (const char* path = std::getenv("DECKARD_CACHE_TRACE"))
+	{
+		std::ifstream    file(path);
+		std::vector<u64> keys;
+		for (u64 key = 0; file >> key;)
+			keys.push_back(key);
+		traces.emplace_back(path, std::move(keys));
+	}
+	else
+	{
+		traces.emplace_back("zipf 0.8", zipf_trace(2'000'000, 1'000'000, 0.8, 1));
+		traces.emplace_back("zipf 1.0", zipf_trace(2'000'000, 1'000'000, 1.0, 2));
+		traces.emplace_back("zipf + scans", scan_trace(2'000'000, 1'000'000, 20'000, 50'000));
+	}
+
+	for (const auto& [name, trace] : traces)
+	{
+		for (const u64 capacity : {10'000ull, 100'000ull})
+		{
+			std::println("{} ({} accesses), capacity {}", name, trace.size(), capacity);
+
+			auto run = [&]<typename Cache>(std::string_view policy, Cache&& cache)
+			{
+				const auto result = replay(cache, std::span<const u64>(trace));
+				std::println("  {:<8} hit ratio {:6.2f}%  {:8.2f} Mops/s", policy, result.hit_ratio() * 100.0, result.ops_per_second() / 1e6);
+			};
+
+			run("lru", lru_cache<u64, u64>(capacity));
+			run("clock", clock_cache<u64, u64>(capacity));
+			run("sieve", sieve_cache<u64, u64>(capacity));
+			run("tinylfu", tinylfu_cache<u64, u64>(capacity));
+		}
+	}
+}
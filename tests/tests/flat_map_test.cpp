@@ -0,0 +1,235 @@
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+import std;
+import deckard.types;
+import deckard.flat_map;
+
+using namespace deckard;
+
+TEST_CASE("flat_map", "[flat_map]")
+{
+	SECTION("insert and find")
+	{
+		flat_map<u64, u64> map;
+		CHECK(map.empty());
+		CHECK(map.find(1) == map.end());
+
+		for (u64 i = 0; i < 1000; ++i)
+			CHECK(map.try_emplace(i, i * 2).second);
+
+		CHECK(map.size() == 1000);
+		CHECK(map.try_emplace(10, 0).second == false);
+		CHECK(map.at(10) == 20);
+
+		for (u64 i = 0; i < 1000; ++i)
+		{
+			auto it = map.find(i);
+			REQUIRE(it != map.end());
+			CHECK(it->second == i * 2);
+		}
+		CHECK(map.contains(1000) == false);
+		CHECK(map.load_factor() <= 0.875f);
+	}
+
+	SECTION("operator[] and insert_or_assign")
+	{
+		flat_map<u64, std::string> map;
+		map[1] = "one";
+		map[1] += "!";
+		CHECK(map[1] == "one!");
+		CHECK(map[2].empty());
+		CHECK(map.size() == 2);
+
+		CHECK(map.insert_or_assign(2, "two").second == false);
+		CHECK(map.at(2) == "two");
+	}
+
+	SECTION("erase")
+	{
+		flat_map<u64, u64> map;
+		for (u64 i = 0; i < 500; ++i)
+			map[i] = i;
+
+		for (u64 i = 0; i < 500; i += 2)
+			CHECK(map.erase(i) == 1);
+		CHECK(map.erase(0) == 0);
+		CHECK(map.size() == 250);
+
+		for (u64 i = 0; i < 500; ++i)
+			CHECK(map.contains(i) == (i % 2 == 1));
+
+		auto it = map.find(1);
+		it      = map.erase(it);
+		CHECK(map.contains(1) == false);
+		CHECK(map.size() == 249);
+
+		CHECK(erase_if(map, [](const auto& kv) { return kv.first < 100; }) == 49);
+		CHECK(map.size() == 200);
+		CHECK(std::ranges::distance(map) == 200);
+	}
+
+	SECTION("churn keeps lookups working")
+	{
+		// Erase and reinsert far more keys than the capacity, exercises deleted slots
+		flat_map<u64, u64> map;
+		std::map<u64, u64> reference;
+
+		std::mt19937_64 rng(42);
+		for (u32 i = 0; i < 100'000; ++i)
+		{
+			const u64 key = rng() % 2000;
+			if (rng() % 3 == 0)
+				CHECK(map.erase(key) == reference.erase(key));
+			else
+			{
+				map[key]       = i;
+				reference[key] = i;
+			}
+		}
+
+		CHECK(map.size() == reference.size());
+		CHECK(map.capacity() <= 4096);
+		for (const auto& [key, value] : reference)
+			CHECK(map.at(key) == value);
+	}
+
+	SECTION("heterogeneous lookup")
+	{
+		flat_map<std::string, int> map;
+		map.try_emplace("alpha", 1);
+		map["beta"] = 2;
+
+		CHECK(map.contains(std::string_view("alpha")));
+		CHECK(map.find("beta")->second == 2);
+		CHECK(map.count(std::string_view("gamma")) == 0);
+		CHECK(map.erase(std::string_view("alpha")) == 1);
+		CHECK(map.size() == 1);
+	}
+
+	SECTION("copy and move")
+	{
+		flat_map<u64, std::string> map;
+		for (u64 i = 0; i < 100; ++i)
+			map[i] = std::to_string(i);
+
+		flat_map<u64, std::string> copy = map;
+		CHECK(copy.size() == 100);
+		CHECK(copy.at(42) == "42");
+
+		flat_map<u64, std::string> moved = std::move(copy);
+		CHECK(moved.size() == 100);
+		CHECK(copy.empty());
+
+		copy = moved;
+		CHECK(copy.at(99) == "99");
+
+		moved.clear();
+		CHECK(moved.empty());
+		CHECK(moved.find(1) == moved.end());
+		CHECK(copy.size() == 100);
+	}
+
+	SECTION("memory resource")
+	{
+		std::array<std::byte, 64 * 1024>    buffer{};
+		std::pmr::monotonic_buffer_resource resource(buffer.data(), buffer.size(), std::pmr::null_memory_resource());
+
+		flat_map<u64, std::pmr::vector<u64>> map(&resource);
+		for (u64 i = 0; i < 100; ++i)
+			map[i % 10].push_back(i);
+
+		CHECK(map.size() == 10);
+		CHECK(map.at(3).size() == 10);
+		CHECK(map.at(3).get_allocator().resource() == &resource);
+
+		std::pmr::vector<flat_map<u64, f32>> nested(&resource);
+		nested.emplace_back()[1] = 1.0f;
+		CHECK(nested[0].get_allocator().resource() == &resource);
+	}
+}
+
+TEST_CASE("flat_set", "[flat_map]")
+{
+	flat_set<u64> set{1, 2, 3};
+	CHECK(set.size() == 3);
+	CHECK(set.insert(2).second == false);
+	CHECK(set.insert(4).second);
+	CHECK(set.contains(4));
+	CHECK(set.erase(1) == 1);
+	CHECK(set.contains(1) == false);
+
+	u64 sum = 0;
+	for (u64 v : set)
+		sum += v;
+	CHECK(sum == 9);
+
+	flat_set<std::string> names;
+	names.emplace("deckard");
+	CHECK(names.contains("deckard"));
+	CHECK(names.contains(std::string_view("rachael")) == false);
+}
+
+TEST_CASE("flat_map benchmark", "[flat_map][.benchmark]")
+{
+	constexpr u64 count = 100'000;
+
+	std::vector<u64> keys(count);
+	std::vector<u64> missing(count);
+	std::mt19937_64  rng(1);
+	for (u64 i = 0; i < count; ++i)
+	{
+		keys[i]    = rng() | 1;
+		missing[i] = rng() & ~1ull;
+	}
+
+	auto run = [&]<typename Map>(const std::string& name, Map filled)
+	{
+		for (u64 key : keys)
+			filled[key] = key;
+
+		BENCHMARK_ADVANCED(name + " insert")(Catch::Benchmark::Chronometer meter)
+		{
+			std::vector<Map> maps(meter.runs());
+			meter.measure(
+			  [&](int i)
+			  {
+				  for (u64 key : keys)
+					  maps[i][key] = key;
+				  return maps[i].size();
+			  });
+		};
+
+		BENCHMARK(name + " lookup hit")
+		{
+			u64 found = 0;
+			for (u64 key : keys)
+				found += filled.contains(key);
+			return found;
+		};
+
+		BENCHMARK(name + " lookup miss")
+		{
+			u64 found = 0;
+			for (u64 key : missing)
+				found += filled.contains(key);
+			return found;
+		};
+
+		BENCHMARK_ADVANCED(name + " erase")(Catch::Benchmark::Chronometer meter)
+		{
+			std::vector<Map> maps(meter.runs(), filled);
+			meter.measure(
+			  [&](int i)
+			  {
+				  u64 erased = 0;
+				  for (u64 key : keys)
+					  erased += maps[i].erase(key);
+				  return erased;
+			  });
+		};
+	};
+
+	run("std::unordered_map", std::unordered_map<u64, u64>{});
+	run("flat_map", flat_map<u64, u64>{});
+}
@@ -607,6 +607,24 @@ TEST_CASE("Graph/Undirected", "[graph][undirected]")
 	}
 }
 
+TEST_CASE("Graph/memory resource", "[graph]")
+{
+	std::array<std::byte, 64 * 1024>    buffer{};
+	std::pmr::monotonic_buffer_resource resource(buffer.data(), buffer.size(), std::pmr::null_memory_resource());
+
+	undirected<u32> g(&resource);
+	for (u32 i = 0; i < 32; ++i)
+		g.connect(i, (i + 1) % 32);
+
+	CHECK(g.node_count() == 32);
+	CHECK(g.edge_count() == 32);
+	CHECK(g.has_edge(31u, 0u));
+
+	g.remove_node(5);
+	CHECK(g.node_count() == 31);
+	CHECK(not g.has_edge(4u, 5u));
+}
+
 TEST_CASE("Binary Tree", "[binarytree]")
 {
 	SECTION("empty")
@@ -1,10 +1,14 @@
 
+#include <catch2/benchmark/catch_benchmark.hpp>
 #include <catch2/catch_test_macros.hpp>
 
 import deckard;
 import deckard.as;
 import deckard.types;
 import deckard.utils.hash;
+import deckard.utils.hash_batch;
+import deckard.utils.tree_hash;
+import deckard.taskpool;
 import deckard.sha;
 import deckard.hmac;
 import std;
@@ -35,6 +39,89 @@ TEST_CASE("rapidhash", "[hash][rapidhash]")
 	}
 }
 
+TEST_CASE("hash_batch", "[hash][hash_batch]")
+{
+	std::vector<u8> bytes(64 * 128);
+	std::mt19937_64 rng(7);
+	for (auto& b : bytes)
+		b = static_cast<u8>(rng());
+
+	std::vector<std::span<const u8>> keys;
+	for (u64 len = 0; len <= 64; ++len)
+		keys.push_back(std::span<const u8>(bytes).subspan(len * 61, len));
+
+	for (const auto kernel : {hash_kernel::scalar, hash_kernel::avx2, hash_kernel::avx512})
+	{
+		if (not hash_kernel_supported(kernel))
+			continue;
+
+		// Variable length keys, 0..64 bytes covers every short path and the scalar fallback
+		std::vector<u64> out(keys.size());
+
+		hash_batch(keys, out, 0, kernel);
+		for (u64 i = 0; i < keys.size(); ++i)
+			CHECK(out[i] == hash(keys[i]));
+
+		hash_batch(keys, out, 1234, kernel);
+		for (u64 i = 0; i < keys.size(); ++i)
+			CHECK(out[i] == hash(keys[i], 1234));
+
+		rapidhash_batch(keys, out, 1234, kernel);
+		for (u64 i = 0; i < keys.size(); ++i)
+			CHECK(out[i] == rapidhash(keys[i].data(), keys[i].size(), 1234));
+
+		// Fixed width keys
+		for (const u64 width : {1, 3, 4, 8, 13, 16, 24, 32, 33, 48, 49})
+		{
+			std::vector<u64>    fixed(37);
+			std::span<const u8> buffer = std::span<const u8>(bytes).first(width * fixed.size());
+
+			hash_batch(buffer, width, fixed, 0, kernel);
+			for (u64 i = 0; i < fixed.size(); ++i)
+				CHECK(fixed[i] == hash(buffer.subspan(i * width, width)));
+
+			rapidhash_batch(buffer, width, fixed, 99, kernel);
+			for (u64 i = 0; i < fixed.size(); ++i)
+				CHECK(fixed[i] == rapidhash(buffer.data() + i * width, width, 99));
+		}
+	}
+}
+
+TEST_CASE("hash_batch benchmark", "[hash][hash_batch][.benchmark]")
+{
+	constexpr u64 count = 100'000;
+
+	for (const u64 width : {8, 16, 32})
+	{
+		std::vector<u8>  bytes(count * width);
+		std::vector<u64> out(count);
+		std::mt19937_64  rng(1);
+		for (auto& b : bytes)
+			b = static_cast<u8>(rng());
+
+		const auto keys = std::format("{} byte keys", width);
+
+		BENCHMARK("hash loop, " + keys)
+		{
+			for (u64 i = 0; i < count; ++i)
+				out[i] = hash(std::span<const u8>(bytes).subspan(i * width, width));
+			return out[count / 2];
+		};
+
+		for (const auto kernel : {hash_kernel::scalar, hash_kernel::avx2, hash_kernel::avx512})
+		{
+			if (not hash_kernel_supported(kernel))
+				continue;
+
+			BENCHMARK(std::format("batch {}, {}", to_string(kernel), keys))
+			{
+				hash_batch(bytes, width, out, 0, kernel);
+				return out[count / 2];
+			};
+		}
+	}
+}
+
 TEST_CASE("xxhasher", "[hash][xxhash]")
 {
 	SECTION("xxhasher")
@@ -95,6 +182,103 @@ TEST_CASE("xxhasher", "[hash][xxhash]")
 	}
 }
 
+TEST_CASE("streaming hashers", "[hash][wyhash][rapidhash][chibihash]")
+{
+	std::array<u8, 1000> data{};
+	for (u32 i = 0; i < data.size(); ++i)
+		data[i] = static_cast<u8>((i * 251 + 7) & 0xFF);
+
+	// Feeds the first len bytes in chunks of the given size
+	auto feed = [&](auto& hasher, u64 len, u64 chunk)
+	{
+		for (u64 offset = 0; offset < len; offset += chunk)
+			hasher.update(std::span{data}.subspan(offset, std::min(chunk, len - offset)));
+		return hasher.finalize();
+	};
+
+	SECTION("matches one-shot")
+	{
+		// Lengths around the 16/32/48 byte block boundaries and the short paths
+		for (const u64 len : {0, 1, 3, 4, 8, 15, 16, 17, 31, 32, 33, 47, 48, 49, 63, 64, 95, 96, 97, 144, 1000})
+		{
+			const auto bytes = std::span{data}.first(len);
+
+			for (const u64 chunk : {1, 7, 16, 48, 1000})
+			{
+				wyhash_hasher wy(42);
+				CHECK(feed(wy, len, chunk) == wyhash(bytes, 42));
+
+				rapidhash_hasher rapid(len);
+				CHECK(feed(rapid, len, chunk) == rapidhash(bytes));
+
+				chibihash_hasher chibi;
+				CHECK(feed(chibi, len, chunk) == chibihash64(bytes));
+
+				xxhash64_hasher xx;
+				CHECK(feed(xx, len, chunk) == xxh64(bytes));
+			}
+		}
+	}
+
+	SECTION("reset")
+	{
+		wyhash_hasher wy;
+		wy.update("The quick brown fox ");
+		wy.reset();
+		wy.update("The quick brown fox jumps over the lazy dog");
+		CHECK(wy.finalize() == hash("The quick brown fox jumps over the lazy dog"));
+
+		rapidhash_hasher rapid(1);
+		rapid.update("a");
+		CHECK(rapid.finalize() == 0xc113'2847'7bc0'f5d1);
+
+		rapid.reset(43);
+		rapid.update("The quick brown fox ");
+		rapid.update("jumps over the lazy dog");
+		CHECK(rapid.finalize() == rapidhash("The quick brown fox jumps over the lazy dog"));
+
+		chibihash_hasher chibi;
+		chibi.update("The quick brown fox jumps over the lazy dog");
+		chibi.reset();
+		CHECK(chibi.finalize() == chibihash64(std::span<const u8>{}));
+	}
+}
+
+TEST_CASE("tree hash", "[hash][tree_hash]")
+{
+	std::vector<u8> data(100'000);
+	for (u32 i = 0; i < data.size(); ++i)
+		data[i] = static_cast<u8>((i * 251 + 7) & 0xFF);
+
+	taskpool::taskpool pool(4);
+
+	SECTION("parallel matches serial")
+	{
+		for (const u64 leaf_size : {1, 100, 4096, 65536})
+		{
+			CHECK(tree_xxh64(data, pool, leaf_size) == tree_xxh64(data, leaf_size));
+			CHECK(tree_sha256(data, pool, leaf_size) == tree_sha256(data, leaf_size));
+		}
+		CHECK(tree_xxh64(data, 1000) != tree_xxh64(data, 1001));
+	}
+
+	SECTION("single leaf")
+	{
+		CHECK(tree_xxh64(data, pool) == xxh64(data));
+		CHECK(tree_xxh64({}) == xxh64(std::span<const u8>{}));
+
+		// SHA-256(0x00)
+		CHECK(tree_sha256({}).to_string() == "6e340b9cffb37a989ca544e6bb780a2c78901d3fb33738768511a30617afa01d");
+	}
+
+	SECTION("stable format")
+	{
+		// RFC 6962 tree over 16 byte leaves, 3 leaves: node(node(l0, l1), l2)
+		constexpr std::string_view fox = "The quick brown fox jumps over the lazy dog";
+		CHECK(tree_sha256({as<const u8*>(fox.data()), fox.size()}, pool, 16).to_string() == "dfacab3024710c8c89f0d94e3cc2076c6c9f4194854ed82ba2a9d1d5186a4b52");
+	}
+}
+
 TEST_CASE("HMAC-SHA1 digests", "[hmac][sha1][hash]")
 {
 	SECTION("null key")
@@ -409,6 +593,85 @@ TEST_CASE("SHA512 Cryptographic Hash Function", "[sha512][sha][hash]")
 #endif
 }
 
+TEST_CASE("SHA kernels", "[sha1][sha256][sha512][sha][hash]")
+{
+	SECTION("padding boundaries")
+	{
+		CHECK(sha1::quickhash(std::string(56, 'a')) == "c2db330f6083854c99d4b5bfb6e8f29f201be699"s);
+
+		CHECK(sha256::quickhash(std::string(56, 'a')) == "b35439a4ac6f0948b6d6f9e3c6af0f5f590ce20f1bde7090ef7970686ec6738a"s);
+		CHECK(sha256::quickhash(std::string(60, 'a')) == "11ee391211c6256460b6ed375957fadd8061cafbb31daf967db875aebd5aaad4"s);
+		CHECK(sha256::quickhash(std::string(64, 'a')) == "ffe054fe7ae0cb6dc65c3af9b61d5209f439851db43d0ba5997337df154668eb"s);
+
+		CHECK(
+		  sha512::quickhash(std::string(112, 'a')) ==
+		  "c01d080efd492776a1c43bd23dd99d0a2e626d481e16782e75d54c2503b5dc32bd05f0f1ba33e568b88fd2d970929b719ecbb152f58f130a407c8830604b70ca"s);
+		CHECK(
+		  sha512::quickhash(std::string(119, 'a')) ==
+		  "130396a75cb483f2eee8c56d8a668bb3d2641f5243212c0bee2bd33da096ad9eb8179fe18f9eaacf76e09fae9de4c3f14ba13341e345be05bf76c182cc3468cb"s);
+		CHECK(
+		  sha512::quickhash(std::string(128, 'a')) ==
+		  "b73d1929aa615934e61a871596b3f3b33359f42b8175602e89f7e06e5f658a243667807ed300314b95cacdd579f3e33abdfbe351909519a846d465c59582f321"s);
+	}
+
+	std::vector<u8> data(300);
+	for (u32 i = 0; i < data.size(); ++i)
+		data[i] = static_cast<u8>(i * 131 + 7);
+
+	SECTION("every supported kernel matches scalar")
+	{
+		for (auto kernel : {sha_kernel::scalar, sha_kernel::sha_ni})
+		{
+			if (not sha_kernel_supported(kernel))
+				continue;
+
+			for (u64 len = 0; len <= data.size(); ++len)
+			{
+				const std::span<const u8> input{data.data(), len};
+
+				sha1::hasher   h1(kernel), s1(sha_kernel::scalar);
+				sha256::hasher h2(kernel), s2(sha_kernel::scalar);
+
+				// Split updates exercise the partial block path
+				h1.update(input.first(len / 3));
+				h1.update(input.subspan(len / 3));
+				h2.update(input.first(len / 3));
+				h2.update(input.subspan(len / 3));
+				s1.update(input);
+				s2.update(input);
+
+				CHECK(h1.finalize() == s1.finalize());
+				CHECK(h2.finalize() == s2.finalize());
+			}
+		}
+	}
+
+	SECTION("hash_many")
+	{
+		std::vector<std::span<const u8>> messages;
+		for (u64 len = 0; len <= data.size(); len += 7)
+			messages.emplace_back(data.data(), len);
+
+		std::vector<sha256::digest> expected(messages.size());
+		for (u64 i = 0; i < messages.size(); ++i)
+		{
+			sha256::hasher hasher(sha_kernel::scalar);
+			hasher.update(messages[i]);
+			expected[i] = hasher.finalize();
+		}
+
+		for (auto kernel : {sha_kernel::scalar, sha_kernel::sha_ni, sha_kernel::avx2})
+		{
+			if (not sha_kernel_supported(kernel))
+				continue;
+
+			std::vector<sha256::digest> out(messages.size());
+			sha256::hash_many(messages, out, kernel);
+			CHECK(out == expected);
+		}
+	}
+}
+
 TEST_CASE("SHA1/SHA256/SHA512 digest formatting", "[sha1][sha256][sha512][hash]")
 {
 	SECTION("sha1 digest")
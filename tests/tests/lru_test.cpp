@@ -17,13 +17,13 @@ TEST_CASE("lru", "[lru]")
 		cache.put(3, "three");
 
 		CHECK(cache.size() == 3);
-		CHECK(cache.get(1) == "one");
-		CHECK(cache.get(2) == "two");
-		CHECK(cache.get(3) == "three");
+		CHECK(*cache.get(1) == "one");
+		CHECK(*cache.get(2) == "two");
+		CHECK(*cache.get(3) == "three");
 
 		cache.put(4, "four");
 		CHECK(cache.size() == 3);
-		CHECK(cache.get(1) == std::nullopt);
+		CHECK(cache.get(1) == nullptr);
 	}
 
 	SECTION("empty cache")
@@ -31,7 +31,7 @@ TEST_CASE("lru", "[lru]")
 		lru_cache<int, std::string> cache(3);
 
 		CHECK(cache.size() == 0);
-		CHECK(cache.get(1) == std::nullopt);
+		CHECK(cache.get(1) == nullptr);
 		CHECK(cache.exists(1) == false);
 		CHECK(cache.exists(999) == false);
 
@@ -47,20 +47,20 @@ TEST_CASE("lru", "[lru]")
 
 		cache.put(1, "one");
 		CHECK(cache.size() == 1);
-		CHECK(cache.get(1) == "one");
+		CHECK(*cache.get(1) == "one");
 		CHECK(cache.exists(1) == true);
 
 		cache.put(2, "two");
 		CHECK(cache.size() == 1);
-		CHECK(cache.get(1) == std::nullopt);
-		CHECK(cache.get(2) == "two");
+		CHECK(cache.get(1) == nullptr);
+		CHECK(*cache.get(2) == "two");
 		CHECK(cache.exists(2) == true);
 		CHECK(cache.exists(1) == false);
 
 		cache.put(3, "three");
 		CHECK(cache.size() == 1);
-		CHECK(cache.get(2) == std::nullopt);
-		CHECK(cache.get(3) == "three");
+		CHECK(cache.get(2) == nullptr);
+		CHECK(*cache.get(3) == "three");
 	}
 
 	SECTION("repeated access keeps item at front")
@@ -76,7 +76,7 @@ TEST_CASE("lru", "[lru]")
 			keys.push_back(k);
 		CHECK(keys == std::vector<int>{3, 2, 1});
 
-		cache.get(1);
+		(void)cache.get(1);
 
 		keys.clear();
 		for (const auto& [k, v] : cache)
@@ -97,7 +97,7 @@ TEST_CASE("lru", "[lru]")
 			keys.push_back(k);
 		CHECK(keys == std::vector<int>{3, 2, 1});
 
-		cache.get(1);
+		(void)cache.get(1);
 
 		keys.clear();
 		for (const auto& [k, v] : cache)
@@ -124,13 +124,13 @@ TEST_CASE("lru", "[lru]")
 		lru_cache<int, std::string> cache(2);
 		cache.put(1, "one");
 		cache.put(2, "two");
-		CHECK(cache.get(1) == "one");
-		CHECK(cache.get(2) == "two");
+		CHECK(*cache.get(1) == "one");
+		CHECK(*cache.get(2) == "two");
 
 		cache.put(1, "ONE");
-		CHECK(cache.get(1) == "ONE");
-		CHECK(cache.get(2) == "two");
-		CHECK(cache.get(3) == std::nullopt);
+		CHECK(*cache.get(1) == "ONE");
+		CHECK(*cache.get(2) == "two");
+		CHECK(cache.get(3) == nullptr);
 	}
 
 	SECTION("exists")
@@ -185,9 +185,9 @@ TEST_CASE("lru", "[lru]")
 		cache.put(3, "three");
 		cache.put(4, "four");
 
-		cache.get(2);
-		cache.get(4);
-		cache.get(1);
+		(void)cache.get(2);
+		(void)cache.get(4);
+		(void)cache.get(1);
 
 		std::vector<int> keys;
 		for (const auto& [k, v] : cache)
@@ -211,13 +211,27 @@ TEST_CASE("lru", "[lru]")
 		cache.put("b", 200);
 		cache.put("c", 300);
 
-		CHECK(cache.get("a") == 100);
-		CHECK(cache.get("b") == 200);
-		CHECK(cache.get("c") == 300);
+		CHECK(*cache.get("a") == 100);
+		CHECK(*cache.get("b") == 200);
+		CHECK(*cache.get("c") == 300);
 
 		cache.put("d", 400);
-		CHECK(cache.get("a") == std::nullopt);
-		CHECK(cache.get("d") == 400);
+		CHECK(cache.get("a") == nullptr);
+		CHECK(*cache.get("d") == 400);
+	}
+
+	SECTION("memory resource")
+	{
+		std::array<std::byte, 4096>         buffer{};
+		std::pmr::monotonic_buffer_resource resource(buffer.data(), buffer.size(), std::pmr::null_memory_resource());
+
+		lru_cache<int, int> cache(4, &resource);
+		for (int i = 0; i < 16; ++i)
+			cache.put(i, i * 10);
+
+		CHECK(cache.size() == 4);
+		CHECK(*cache.get(15) == 150);
+		CHECK(cache.get(11) == nullptr);
 	}
 
 	SECTION("format")
@@ -229,11 +243,165 @@ TEST_CASE("lru", "[lru]")
 
 		CHECK(std::format("{}", cache) == "{2: two, 1: one}");
 
-		cache.get(1);
+		(void)cache.get(1);
 
 		CHECK(std::format("{}", cache) == "{1: one, 2: two}");
 
 
 	}
 
+	SECTION("get returns a reference")
+	{
+		lru_cache<int, std::string> cache(2);
+		cache.put(1, "one");
+
+		std::string* value = cache.get(1);
+		REQUIRE(value != nullptr);
+		*value += "!";
+		CHECK(*cache.get(1) == "one!");
+	}
+
+	SECTION("peek keeps the order")
+	{
+		lru_cache<int, int> cache(2);
+		cache.put(1, 10);
+		cache.put(2, 20);
+
+		CHECK(*cache.peek(1) == 10);
+		CHECK(cache.peek(3) == nullptr);
+
+		cache.put(3, 30);
+		CHECK(cache.exists(1) == false);
+		CHECK(cache.exists(2) == true);
+	}
+
+	SECTION("erase")
+	{
+		lru_cache<int, int> cache(3);
+		cache.put(1, 10);
+		cache.put(2, 20);
+		cache.put(3, 30);
+
+		CHECK(cache.erase(2) == true);
+		CHECK(cache.erase(2) == false);
+		CHECK(cache.size() == 2);
+		CHECK(cache.exists(2) == false);
+
+		cache.put(4, 40);
+		CHECK(cache.size() == 3);
+		CHECK(cache.exists(1) == true);
+
+		cache.put(5, 50);
+		CHECK(cache.exists(1) == false);
+
+		std::vector<int> keys;
+		for (const auto& [k, v] : cache)
+			keys.push_back(k);
+		CHECK(keys == std::vector<int>{5, 4, 3});
+
+		cache.clear();
+		CHECK(cache.size() == 0);
+		CHECK(cache.get(5) == nullptr);
+	}
+
+	SECTION("matches a list model")
+	{
+		constexpr u64 capacity = 64;
+
+		lru_cache<u32, u32>            cache(capacity);
+		std::list<std::pair<u32, u32>> model;
+
+		std::mt19937 rng(1234);
+		for (u32 i = 0; i < 50'000; ++i)
+		{
+			const u32 key = rng() % 200;
+			auto      it  = std::ranges::find(model, key, &std::pair<u32, u32>::first);
+
+			switch (rng() % 3)
+			{
+				case 0:
+				{
+					if (it != model.end())
+						model.erase(it);
+					model.emplace_front(key, i);
+					if (model.size() > capacity)
+						model.pop_back();
+					cache.put(key, i);
+					break;
+				}
+				case 1:
+				{
+					u32* value = cache.get(key);
+					REQUIRE((value != nullptr) == (it != model.end()));
+					if (it != model.end())
+					{
+						CHECK(*value == it->second);
+						model.splice(model.begin(), model, it);
+					}
+					break;
+				}
+				default:
+				{
+					CHECK(cache.erase(key) == (it != model.end()));
+					if (it != model.end())
+						model.erase(it);
+					break;
+				}
+			}
+		}
+
+		CHECK(cache.size() == model.size());
+		CHECK(std::ranges::equal(cache, model));
+	}
+}
+
+TEST_CASE("concurrent lru", "[lru]")
+{
+	SECTION("basic")
+	{
+		concurrent_lru_cache<std::string, int> cache(64, 4);
+
+		cache.put("one", 1);
+		cache.put("two", 2);
+
+		CHECK(cache.get("one") == 1);
+		CHECK(cache.get("three") == std::nullopt);
+		CHECK(cache.exists("two"));
+		CHECK(cache.size() == 2);
+
+		CHECK(cache.visit("two", [](int& v) { v = 22; }));
+		CHECK(cache.get("two") == 22);
+
+		CHECK(cache.erase("one"));
+		CHECK(cache.size() == 1);
+		CHECK(cache.shard_count() == 4);
+	}
+
+	SECTION("threads")
+	{
+		constexpr u32 threads_count = 4;
+		constexpr u32 keys          = 4096;
+
+		concurrent_lru_cache<u32, u32> cache(keys, 8);
+		std::atomic<u32>               mismatches{0};
+
+		std::vector<std::jthread> threads;
+		for (u32 t = 0; t < threads_count; ++t)
+			threads.emplace_back(
+			  [&, t]
+			  {
+				  for (u32 i = t; i < keys; i += threads_count)
+					  cache.put(i, i * 3);
+
+				  for (u32 i = 0; i < keys; ++i)
+				  {
+					  if (auto value = cache.get(i); value and *value != i * 3)
+						  mismatches++;
+				  }
+			  });
+		threads.clear();
+
+		CHECK(mismatches.load() == 0);
+		CHECK(cache.size() <= keys + 8);
+	}
 }
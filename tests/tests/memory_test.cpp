@@ -362,3 +362,335 @@ TEST_CASE("arena", "[arena][memory]")
 
 	}
 }
+
+TEST_CASE("growing arena", "[arena][memory]")
+{
+	using namespace deckard;
+	using namespace deckard::literals;
+
+	SECTION("grows by chaining blocks")
+	{
+		memory::growing_arena frame(256, 1024);
+		CHECK(frame.block_count() == 0);
+		CHECK(frame.used() == 0);
+
+		auto first = frame.allocate(200);
+		CHECK(first.size() == 200);
+		CHECK(frame.block_count() == 1);
+		CHECK(frame.capacity() == 256);
+
+		auto second = frame.allocate(200);
+		CHECK(second.size() == 200);
+		CHECK(frame.block_count() == 2);
+		CHECK(frame.capacity() == 256 + 512);
+		CHECK(frame.used() == 400);
+
+		// first block is untouched by the growth
+		first[0] = 0xAA_byte;
+		CHECK(first[0] == 0xAA_byte);
+		CHECK(first.data() != second.data());
+	}
+
+	SECTION("oversized allocation gets its own block")
+	{
+		memory::growing_arena frame(256, 1024);
+
+		auto big = frame.allocate<u32>(4096, 64);
+		CHECK(big.size() == 4096);
+		CHECK(is_pointer_aligned(big.data(), 64));
+		CHECK(frame.capacity() >= 4096 * sizeof(u32));
+	}
+
+	SECTION("rewind to marker reuses blocks")
+	{
+		memory::growing_arena frame(256, 1024);
+
+		auto* keep = frame.create<u64>(42u);
+		auto  mark = frame.mark();
+
+		for (int i = 0; i < 16; ++i)
+			(void)frame.allocate(100);
+
+		const auto blocks   = frame.block_count();
+		const auto capacity = frame.capacity();
+		CHECK(blocks > 1);
+
+		frame.rewind(mark);
+		CHECK(frame.used() == sizeof(u64));
+		CHECK(*keep == 42);
+
+		for (int i = 0; i < 16; ++i)
+			(void)frame.allocate(100);
+
+		CHECK(frame.block_count() == blocks);
+		CHECK(frame.capacity() == capacity);
+
+		frame.reset();
+		CHECK(frame.used() == 0);
+		CHECK(frame.block_count() == blocks);
+
+		frame.release();
+		CHECK(frame.block_count() == 1);
+		CHECK(frame.capacity() == 256);
+	}
+
+	SECTION("scope rewinds on exit")
+	{
+		memory::growing_arena frame(1_KiB);
+
+		auto outer = frame.create_array<int>(4, 7);
+		{
+			auto scope = frame.scope();
+			auto inner = frame.create_array<int>(1000, 1);
+			CHECK(inner.size() == 1000);
+			CHECK(frame.used() > 1_KiB);
+		}
+		CHECK(frame.used() == 4 * sizeof(int));
+		CHECK(outer[3] == 7);
+	}
+
+	SECTION("thread arena is per thread")
+	{
+		auto* main_arena = &memory::thread_arena();
+		CHECK(main_arena == &memory::thread_arena());
+
+		memory::growing_arena* other_arena = nullptr;
+		std::thread([&] { other_arena = &memory::thread_arena(); }).join();
+
+		CHECK(other_arena != nullptr);
+		CHECK(other_arena != main_arena);
+	}
+}
+
+TEST_CASE("pool allocator", "[pool][memory]")
+{
+	using namespace deckard;
+
+	SECTION("size classes")
+	{
+		CHECK(memory::size_class(1) == 0);
+		CHECK(memory::size_class(16) == 0);
+		CHECK(memory::size_class(17) == 1);
+		CHECK(memory::size_class(128) == 7);
+		CHECK(memory::class_size(memory::size_class(129)) == 160);
+		CHECK(memory::class_size(memory::size_class(256)) == 256);
+		CHECK(memory::class_size(memory::size_class(1000)) == 1024);
+		CHECK(memory::class_size(memory::size_class(memory::MAX_SMALL_SIZE)) == memory::MAX_SMALL_SIZE);
+
+		for (u64 size = 1; size <= memory::MAX_SMALL_SIZE; ++size)
+		{
+			const u32 index = memory::size_class(size);
+			CHECK(memory::class_size(index) >= size);
+			if (index > 0)
+				CHECK(memory::class_size(index - 1) < size);
+		}
+	}
+
+	SECTION("freed blocks are reused")
+	{
+		void* first = memory::allocate(48);
+		memory::deallocate(first, 48);
+
+		void* second = memory::allocate(40);
+		CHECK(second == first);
+		memory::deallocate(second, 40);
+	}
+
+	SECTION("alignment")
+	{
+		for (u64 alignment : {8u, 16u, 32u, 64u, 256u, 4096u})
+		{
+			std::vector<void*> blocks;
+			for (int i = 0; i < 32; ++i)
+			{
+				void* ptr = memory::allocate(24, alignment);
+				CHECK(is_pointer_aligned(ptr, alignment));
+				blocks.push_back(ptr);
+			}
+			for (void* ptr : blocks)
+				memory::deallocate(ptr, 24, alignment);
+		}
+	}
+
+	SECTION("large allocations")
+	{
+		const auto before = memory::stats().large_bytes;
+
+		void* ptr = memory::allocate(1_MiB);
+		CHECK(ptr != nullptr);
+		CHECK(memory::stats().large_bytes == before + 1_MiB);
+
+		memory::deallocate(ptr, 1_MiB);
+		CHECK(memory::stats().large_bytes == before);
+	}
+
+	SECTION("pmr containers")
+	{
+		std::pmr::vector<u64>            numbers(memory::pool_memory_resource());
+		std::pmr::list<std::pmr::string> names(memory::pool_memory_resource());
+
+		for (u64 i = 0; i < 1000; ++i)
+		{
+			numbers.push_back(i);
+			names.emplace_back(std::format("name that does not fit sso {}", i));
+		}
+
+		CHECK(numbers.size() == 1000);
+		CHECK(numbers[999] == 999);
+		CHECK(names.back() == "name that does not fit sso 999");
+		CHECK(memory::stats().reserved > 0);
+	}
+
+	SECTION("blocks move between threads")
+	{
+		constexpr u64 count = 10'000;
+
+		std::vector<u64*> blocks(count);
+		std::thread producer(
+		  [&]
+		  {
+			  for (u64 i = 0; i < count; ++i)
+			  {
+				  blocks[i]  = static_cast<u64*>(memory::allocate(sizeof(u64) * 4, alignof(u64)));
+				  *blocks[i] = i;
+			  }
+		  });
+		producer.join();
+
+		bool intact = true;
+		std::thread consumer(
+		  [&]
+		  {
+			  for (u64 i = 0; i < count; ++i)
+			  {
+				  intact = intact and *blocks[i] == i;
+				  memory::deallocate(blocks[i], sizeof(u64) * 4, alignof(u64));
+			  }
+		  });
+		consumer.join();
+
+		CHECK(intact);
+	}
+}
+
+TEST_CASE("arena memory resource", "[arena][memory]")
+{
+	using namespace deckard;
+	using namespace deckard::literals;
+
+	SECTION("pmr containers on a fixed arena")
+	{
+		memory::arena          frame(4_KiB);
+		memory::arena_resource resource(frame);
+
+		std::pmr::vector<u32> numbers(&resource);
+		for (u32 i = 0; i < 100; ++i)
+			numbers.push_back(i);
+
+		CHECK(numbers[99] == 99);
+		CHECK(frame.used() >= 100 * sizeof(u32));
+
+		CHECK_THROWS_AS(numbers.resize(10'000), std::bad_alloc);
+	}
+
+	SECTION("stack arena")
+	{
+		memory::stackarena<1024> frame;
+		memory::arena_resource   resource(frame);
+
+		std::pmr::string text("a string too long for the small buffer", &resource);
+		CHECK(text.size() == 38);
+		CHECK(frame.used() > 38);
+	}
+
+	SECTION("nested containers stay on the arena")
+	{
+		memory::growing_arena  frame(1_KiB);
+		memory::arena_resource resource(frame);
+
+		auto* previous = std::pmr::set_default_resource(std::pmr::null_memory_resource());
+
+		std::pmr::unordered_map<u32, std::pmr::vector<u32>> buckets(&resource);
+		for (u32 i = 0; i < 1000; ++i)
+			buckets[i % 7].push_back(i);
+
+		std::pmr::set_default_resource(previous);
+
+		CHECK(buckets.size() == 7);
+		CHECK(buckets[0].size() == 143);
+		CHECK(frame.block_count() > 1);
+
+		const auto mark = frame.mark();
+		frame.reset();
+		CHECK(frame.used() == 0);
+		CHECK(mark.offset > 0);
+	}
+}
+
+TEST_CASE("memory tracking", "[tracking][memory]")
+{
+	using namespace deckard;
+
+	auto stats_for = [](std::string_view tag)
+	{
+		for (const auto& stats : memory::tracking_snapshot())
+			if (stats.tag == tag)
+				return stats;
+		return memory::allocation_stats{};
+	};
+
+	SECTION("counts bytes and allocations per tag")
+	{
+		// Counters are process-wide and never reset, compare against the state before
+		memory::tracking_resource resource("test.vector");
+		memory::reset_tracking_peaks();
+		const auto before = stats_for("test.vector");
+		CHECK(before.current_bytes == 0);
+		{
+			std::pmr::vector<u64> numbers(&resource);
+			numbers.reserve(100);
+			numbers.reserve(200);
+
+			const auto stats = stats_for("test.vector");
+			CHECK(stats.current_bytes == 200 * sizeof(u64));
+			CHECK(stats.peak_bytes == 300 * sizeof(u64));
+			CHECK(stats.allocations - before.allocations == 2);
+			CHECK(stats.live_allocations() == 1);
+		}
+
+		const auto stats = stats_for("test.vector");
+		CHECK(stats.current_bytes == 0);
+		CHECK(stats.total_bytes - before.total_bytes == 300 * sizeof(u64));
+		CHECK(stats.live_allocations() == 0);
+
+		CHECK(memory::tracking_report().contains("test.vector"));
+	}
+
+	SECTION("wraps arenas")
+	{
+		memory::growing_arena     frame;
+		memory::arena_resource    frame_resource(frame);
+		memory::tracking_resource resource("test.arena", &frame_resource);
+
+		std::pmr::string text("long enough to need an allocation from the arena", &resource);
+		CHECK(stats_for("test.arena").current_bytes > text.size());
+		CHECK(frame.used() == stats_for("test.arena").current_bytes);
+	}
+
+	SECTION("tracked is a passthrough when disabled")
+	{
+		auto*                    upstream = std::pmr::new_delete_resource();
+		memory::tracked_resource resource("test.tracked", upstream);
+		if constexpr (memory::tracking)
+			CHECK(resource.get() != upstream);
+		else
+			CHECK(resource.get() == upstream);
+	}
+
+	SECTION("tracked(tag) is one wrapper per tag")
+	{
+		auto* resource = memory::tracked("test.global");
+		CHECK(memory::tracked("test.global") == resource);
+		CHECK((memory::tracked("test.other") != resource) == memory::tracking);
+	}
+}
@@ -157,10 +157,260 @@ TEST_CASE("ringbuffer", "[ringbuffer]")
 		CHECK(last == 127);
 
 		auto last4 = rb.last(4);
-		CHECK(last4 == std::vector<u32>{127, 126, 125, 124});
+		CHECK(std::ranges::equal(last4, std::array{127u, 126u, 125u, 124u}));
 
 
 		CHECK(rb.size() == 16);
 		CHECK(rb.capacity() == 16);
 	}
+
+	SECTION("ringbuffer last before full")
+	{
+		ringbuffer<u32> rb(6);
+
+		rb.push(1);
+		rb.push(2);
+		rb.push(3);
+
+		CHECK(rb.last() == 3);
+		CHECK(std::ranges::equal(rb.last(2), std::array{3u, 2u}));
+	}
+
+	SECTION("ringbuffer iterators")
+	{
+		ringbuffer<u32> rb(5);
+
+		for (u32 i = 0; i < 8; i++)
+			rb.push(i);
+
+		static_assert(std::random_access_iterator<ringbuffer<u32>::iterator>);
+		static_assert(std::random_access_iterator<ringbuffer<u32>::const_iterator>);
+
+		CHECK(std::ranges::equal(rb, std::array{3u, 4u, 5u, 6u, 7u}));
+		CHECK(rb.end() - rb.begin() == 5);
+		CHECK(rb.begin()[2] == 5);
+
+		for (auto& value : rb)
+			value *= 2;
+		CHECK(rb.front() == 6);
+		CHECK(rb.back() == 14);
+
+		const auto& crb = rb;
+		CHECK(std::ranges::max(crb) == 14);
+	}
+
+	SECTION("ringbuffer as_spans")
+	{
+		ringbuffer<u32> rb(4);
+
+		rb.push(1);
+		rb.push(2);
+		auto [first, second] = rb.as_spans();
+		CHECK(std::ranges::equal(first, std::array{1u, 2u}));
+		CHECK(second.empty());
+
+		rb.push(3);
+		rb.push(4);
+		rb.push(5);
+		rb.push(6);
+		auto [older, newer] = rb.as_spans();
+		CHECK(std::ranges::equal(older, std::array{3u, 4u}));
+		CHECK(std::ranges::equal(newer, std::array{5u, 6u}));
+	}
+
+	SECTION("ringbuffer push_range/pop_range")
+	{
+		ringbuffer<u32> rb(5);
+
+		rb.push(100);
+		rb.push_range(std::array{1u, 2u, 3u});
+		CHECK(std::ranges::equal(rb, std::array{100u, 1u, 2u, 3u}));
+
+		// wraps and drops the oldest
+		rb.push_range(std::array{4u, 5u, 6u});
+		CHECK(std::ranges::equal(rb, std::array{2u, 3u, 4u, 5u, 6u}));
+
+		// longer than capacity
+		rb.push_range(std::array{10u, 11u, 12u, 13u, 14u, 15u, 16u});
+		CHECK(std::ranges::equal(rb, std::array{12u, 13u, 14u, 15u, 16u}));
+
+		std::array<u32, 3> out{};
+		CHECK(rb.pop_range(out) == 3);
+		CHECK(out == std::array{12u, 13u, 14u});
+		CHECK(rb.pop_range(out) == 2);
+		CHECK(out[0] == 15);
+		CHECK(out[1] == 16);
+		CHECK(rb.empty());
+
+		ringbuffer<std::string> strings(3);
+		strings.push_range(std::array<std::string, 4>{"a", "b", "c", "d"});
+		std::array<std::string, 4> popped{};
+		CHECK(strings.pop_range(popped) == 3);
+		CHECK(popped[0] == "b");
+		CHECK(popped[2] == "d");
+	}
+}
+
+TEST_CASE("atomic_ringbuffer", "[ringbuffer]")
+{
+	SECTION("push/pop")
+	{
+		atomic_ringbuffer<u32, 4> rb;
+
+		CHECK(rb.empty());
+		CHECK(rb.try_push(1));
+		CHECK(rb.try_push(2));
+		CHECK(rb.try_push(3));
+		CHECK(rb.try_push(4));
+		CHECK(rb.full());
+		CHECK(rb.try_push(5) == false);
+
+		CHECK(rb.try_pop() == 1u);
+		CHECK(rb.try_push(5));
+		CHECK(rb.size() == 4);
+
+		CHECK(rb.try_pop() == 2u);
+		CHECK(rb.try_pop() == 3u);
+		CHECK(rb.try_pop() == 4u);
+		CHECK(rb.try_pop() == 5u);
+		CHECK(rb.try_pop().has_value() == false);
+		CHECK(rb.empty());
+	}
+
+	SECTION("batch")
+	{
+		atomic_ringbuffer<u32, 8> rb;
+
+		std::array<u32, 6> in{1, 2, 3, 4, 5, 6};
+		CHECK(rb.try_push_n(in) == 6);
+		CHECK(rb.try_push_n(in) == 2);
+		CHECK(rb.full());
+
+		std::array<u32, 5> out{};
+		CHECK(rb.try_pop_n(out) == 5);
+		CHECK(out == std::array<u32, 5>{1, 2, 3, 4, 5});
+		CHECK(rb.try_pop_n(out) == 3);
+		CHECK(out[0] == 6);
+		CHECK(out[1] == 1);
+		CHECK(out[2] == 2);
+		CHECK(rb.try_pop_n(out) == 0);
+	}
+
+	SECTION("move-only and destruction")
+	{
+		auto counter = std::make_shared<int>(0);
+		{
+			atomic_ringbuffer<std::unique_ptr<std::shared_ptr<int>>, 4> rb;
+			CHECK(rb.try_push(std::make_unique<std::shared_ptr<int>>(counter)));
+			CHECK(rb.try_push(std::make_unique<std::shared_ptr<int>>(counter)));
+			CHECK(counter.use_count() == 3);
+
+			auto value = rb.try_pop();
+			REQUIRE(value.has_value());
+			CHECK(**value == counter);
+		}
+		CHECK(counter.use_count() == 1);
+	}
+
+	SECTION("multiple producers and consumers")
+	{
+		constexpr u64 per_producer = 20'000;
+		constexpr u64 producers    = 4;
+		constexpr u64 consumers    = 4;
+
+		atomic_ringbuffer<u64, 64> rb;
+		std::atomic<u64>           sum{0};
+		std::atomic<u64>           popped{0};
+
+		std::vector<std::jthread> threads;
+		for (u64 p = 0; p < producers; ++p)
+			threads.emplace_back(
+			  [&, p]
+			  {
+				  for (u64 i = 1; i <= per_producer; ++i)
+					  rb.push(p * per_producer + i);
+			  });
+
+		for (u64 c = 0; c < consumers; ++c)
+			threads.emplace_back(
+			  [&]
+			  {
+				  std::array<u64, 8> batch{};
+				  while (popped.load() < producers * per_producer)
+				  {
+					  const u64 count = rb.try_pop_n(batch);
+					  for (u64 i = 0; i < count; ++i)
+						  sum += batch[i];
+					  popped += count;
+				  }
+			  });
+
+		threads.clear();
+
+		const u64 n = producers * per_producer;
+		CHECK(popped.load() == n);
+		CHECK(sum.load() == n * (n + 1) / 2);
+		CHECK(rb.empty());
+	}
+}
+
+TEST_CASE("spsc_ringbuffer", "[ringbuffer]")
+{
+	SECTION("push/pop")
+	{
+		spsc_ringbuffer<u32, 2> rb;
+
+		CHECK(rb.try_push(1));
+		CHECK(rb.try_push(2));
+		CHECK(rb.try_push(3) == false);
+		CHECK(rb.try_pop() == 1u);
+		CHECK(rb.try_push(3));
+		CHECK(rb.try_pop() == 2u);
+		CHECK(rb.try_pop() == 3u);
+		CHECK(rb.try_pop().has_value() == false);
+	}
+
+	SECTION("ordered hand-off")
+	{
+		constexpr u32 count = 100'000;
+
+		spsc_ringbuffer<u32, 128> rb;
+		bool                      ordered = true;
+
+		std::jthread consumer(
+		  [&]
+		  {
+			  std::array<u32, 16> batch{};
+			  u32                 expected = 0;
+			  while (expected < count)
+			  {
+				  if (expected % 2 == 0)
+				  {
+					  ordered &= rb.pop() == expected++;
+					  continue;
+				  }
+
+				  const u64 n = rb.try_pop_n(batch);
+				  for (u64 i = 0; i < n; ++i)
+					  ordered &= batch[i] == expected++;
+			  }
+		  });
+
+		for (u32 i = 0; i < count;)
+		{
+			if (i % 3 == 0)
+			{
+				rb.push(i++);
+				continue;
+			}
+
+			std::array<u32, 4> values{i, i + 1, i + 2, i + 3};
+			const u64          n = rb.try_push_n(std::span(values).first(std::min<u32>(4, count - i)));
+			i += static_cast<u32>(n);
+		}
+
+		consumer.join();
+		CHECK(ordered);
+		CHECK(rb.empty());
+	}
 }
@@ -0,0 +1,140 @@
+#include <catch2/catch_test_macros.hpp>
+
+import std;
+import deckard.types;
+import deckard.slot_map;
+
+TEST_CASE("slot_map", "[slot_map]")
+{
+	using namespace deckard;
+
+	SECTION("insert and get")
+	{
+		slot_map<std::string> names;
+
+		auto a = names.insert("alpha");
+		auto b = names.emplace(3, 'b');
+
+		CHECK(names.size() == 2);
+		CHECK(names[a] == "alpha");
+		CHECK(names[b] == "bbb");
+		CHECK(names.contains(a));
+		CHECK(a != b);
+	}
+
+	SECTION("stale handles")
+	{
+		slot_map<int> values;
+
+		auto first = values.insert(1);
+		CHECK(values.erase(first));
+		CHECK(not values.contains(first));
+		CHECK(values.get(first) == nullptr);
+		CHECK(not values.erase(first));
+
+		// reuses the slot with a new generation
+		auto second = values.insert(2);
+		CHECK(second.index == first.index);
+		CHECK(second.generation != first.generation);
+		CHECK(values.get(first) == nullptr);
+		CHECK(*values.get(second) == 2);
+
+		slot_map<int>::handle none;
+		CHECK(not none.valid());
+		CHECK(not values.contains(none));
+	}
+
+	SECTION("erase keeps values dense")
+	{
+		slot_map<u32> values;
+
+		std::vector<slot_map<u32>::handle> handles;
+		for (u32 i = 0; i < 100; ++i)
+			handles.push_back(values.insert(i));
+
+		for (u32 i = 0; i < 100; i += 2)
+			CHECK(values.erase(handles[i]));
+
+		CHECK(values.size() == 50);
+
+		u32 sum = 0;
+		for (u32 v : values)
+			sum += v;
+		CHECK(sum == 2500); // 1 + 3 + ... + 99
+
+		for (u32 i = 1; i < 100; i += 2)
+			CHECK(values[handles[i]] == i);
+
+		for (u64 i = 0; i < values.size(); ++i)
+			CHECK(values[values.handle_at(i)] == values.values()[i]);
+	}
+
+	SECTION("clear invalidates every handle")
+	{
+		slot_map<int> values;
+		auto          a = values.insert(10);
+		auto          b = values.insert(20);
+
+		values.clear();
+		CHECK(values.empty());
+		CHECK(not values.contains(a));
+		CHECK(not values.contains(b));
+
+		auto c = values.insert(30);
+		CHECK(values.size() == 1);
+		CHECK(values[c] == 30);
+		CHECK(not values.contains(a));
+		CHECK(not values.contains(b));
+	}
+
+	SECTION("move-only values")
+	{
+		slot_map<std::unique_ptr<int>> owned;
+
+		auto a = owned.emplace(std::make_unique<int>(1));
+		auto b = owned.emplace(std::make_unique<int>(2));
+		owned.erase(a);
+
+		CHECK(owned.size() == 1);
+		CHECK(*owned[b] == 2);
+	}
+
+	SECTION("throwing constructor leaves the map unchanged")
+	{
+		struct fragile
+		{
+			int value{0};
+
+			explicit fragile(int v)
+				: value(v)
+			{
+				if (v < 0)
+					throw std::invalid_argument("negative");
+			}
+		};
+
+		slot_map<fragile> values;
+
+		auto a = values.emplace(1);
+		auto b = values.emplace(2);
+		values.erase(a);
+
+		CHECK_THROWS_AS(values.emplace(-1), std::invalid_argument);
+		CHECK(values.size() == 1);
+		CHECK(values[b].value == 2);
+
+		// The freed slot is still at the head of the free list
+		auto c = values.emplace(3);
+		CHECK(c.index == a.index);
+		CHECK(c.generation != a.generation);
+		CHECK(values.size() == 2);
+
+		CHECK_THROWS_AS(values.emplace(-1), std::invalid_argument);
+		CHECK(values.size() == 2);
+
+		int sum = 0;
+		for (const auto& v : values)
+			sum += v.value;
+		CHECK(sum == 5);
+	}
+}
@@ -0,0 +1,690 @@
+#include <catch2/catch_test_macros.hpp>
+
+import std;
+import deckard.types;
+import deckard.taskpool;
+import deckard.threadutil;
+
+using namespace deckard;
+
+TEST_CASE("chase_lev_deque", "[taskpool][deque]")
+{
+	SECTION("owner push/pop is LIFO")
+	{
+		taskpool::chase_lev_deque<u64> deque(4);
+
+		deque.push(1);
+		deque.push(2);
+		deque.push(3);
+
+		CHECK(deque.size() == 3);
+		CHECK(deque.pop() == 3);
+		CHECK(deque.pop() == 2);
+		CHECK(deque.pop() == 1);
+		CHECK(deque.pop() == std::nullopt);
+		CHECK(deque.empty());
+	}
+
+	SECTION("steal is FIFO")
+	{
+		taskpool::chase_lev_deque<u64> deque(4);
+
+		deque.push(1);
+		deque.push(2);
+		deque.push(3);
+
+		CHECK(deque.steal() == 1);
+		CHECK(deque.steal() == 2);
+		CHECK(deque.pop() == 3);
+		CHECK(deque.steal() == std::nullopt);
+	}
+
+	SECTION("grows past initial capacity")
+	{
+		taskpool::chase_lev_deque<u64> deque(2);
+
+		for (u64 i = 0; i < 100; ++i)
+			deque.push(i);
+
+		CHECK(deque.size() == 100);
+		CHECK(deque.capacity() >= 100);
+
+		CHECK(deque.steal() == 0);
+		for (u64 i = 99; i > 0; --i)
+			CHECK(deque.pop() == i);
+		CHECK(deque.empty());
+	}
+
+	SECTION("concurrent thieves take every item once")
+	{
+		constexpr u64                  count = 100'000;
+		taskpool::chase_lev_deque<u64> deque(64);
+		std::atomic<u64>               sum{0};
+		std::atomic<u64>               taken{0};
+		std::atomic<bool>              done{false};
+
+		std::vector<std::thread> thieves;
+		for (int t = 0; t < 3; ++t)
+		{
+			thieves.emplace_back(
+			  [&]
+			  {
+				  while (not done.load() or not deque.empty())
+				  {
+					  if (auto v = deque.steal(); v)
+					  {
+						  sum += *v;
+						  taken++;
+					  }
+				  }
+			  });
+		}
+
+		for (u64 i = 1; i <= count; ++i)
+		{
+			deque.push(i);
+			if (i % 3 == 0)
+			{
+				if (auto v = deque.pop(); v)
+				{
+					sum += *v;
+					taken++;
+				}
+			}
+		}
+
+		while (auto v = deque.pop())
+		{
+			sum += *v;
+			taken++;
+		}
+		done = true;
+
+		for (auto& t : thieves)
+			t.join();
+
+		CHECK(taken == count);
+		CHECK(sum == count * (count + 1) / 2);
+	}
+}
+
+TEST_CASE("taskpool", "[taskpool]")
+{
+	SECTION("enqueue returns result")
+	{
+		taskpool::taskpool pool(4);
+
+		auto f1 = pool.enqueue([] { return 42; });
+		auto f2 = pool.enqueue([](int a, int b) { return a + b; }, 1, 2);
+
+		CHECK(f1.get() == 42);
+		CHECK(f2.get() == 3);
+	}
+
+	SECTION("tasks spawned from workers")
+	{
+		taskpool::taskpool pool(4);
+		std::atomic<u32>   counter{0};
+
+		std::vector<std::future<void>> outer;
+		for (int i = 0; i < 16; ++i)
+		{
+			outer.emplace_back(pool.enqueue(
+			  [&]
+			  {
+				  for (int j = 0; j < 16; ++j)
+					  (void)pool.enqueue([&] { counter++; });
+			  }));
+		}
+
+		for (auto& f : outer)
+			f.get();
+
+		pool.join();
+		CHECK(counter == 16 * 16);
+	}
+}
+
+TEST_CASE("task_group", "[taskpool][task_group]")
+{
+	taskpool::taskpool pool(4);
+
+	SECTION("run and wait")
+	{
+		std::atomic<u32>     counter{0};
+		taskpool::task_group group(pool);
+
+		for (int i = 0; i < 10'000; ++i)
+			group.run([&] { counter++; });
+
+		group.wait();
+		CHECK(counter == 10'000);
+		CHECK(group.finished());
+	}
+
+	SECTION("nested groups")
+	{
+		std::atomic<u32>     counter{0};
+		taskpool::task_group outer(pool);
+
+		for (int i = 0; i < 32; ++i)
+		{
+			outer.run(
+			  [&]
+			  {
+				  taskpool::task_group inner(pool);
+				  for (int j = 0; j < 32; ++j)
+					  inner.run([&] { counter++; });
+				  inner.wait();
+			  });
+		}
+
+		outer.wait();
+		CHECK(counter == 32 * 32);
+	}
+
+	SECTION("wait rethrows first exception")
+	{
+		taskpool::task_group group(pool);
+		group.run([] { throw std::runtime_error("fail"); });
+		group.run([] { });
+
+		CHECK_THROWS_AS(group.wait(), std::runtime_error);
+		CHECK_NOTHROW(group.wait());
+	}
+
+	SECTION("submit oversized callable")
+	{
+		std::array<u8, taskpool::job_inline_size * 2> payload{};
+		payload.back() = 7;
+
+		std::atomic<u32>     result{0};
+		taskpool::task_group group(pool);
+		group.run([&result, payload] { result = payload.back(); });
+		group.wait();
+
+		CHECK(result == 7);
+	}
+}
+
+TEST_CASE("taskpool algorithms", "[taskpool][algorithms]")
+{
+	taskpool::taskpool pool(4);
+
+	SECTION("parallel_for")
+	{
+		std::vector<u64> data(100'003);
+		taskpool::parallel_for(pool, u64{0}, u64{data.size()}, [&](u64 i) { data[i] = i * 2; });
+
+		bool ok = true;
+		for (u64 i = 0; i < data.size(); ++i)
+			ok &= data[i] == i * 2;
+		CHECK(ok);
+	}
+
+	SECTION("parallel_for range")
+	{
+		std::vector<u32> data(10'000, 1);
+		taskpool::parallel_for(pool, data, [](u32& v) { v += 1; }, 64);
+
+		CHECK(std::ranges::all_of(data, [](u32 v) { return v == 2; }));
+	}
+
+	SECTION("parallel_for nested")
+	{
+		std::atomic<u32> counter{0};
+		taskpool::parallel_for(pool, 0, 64, [&](int) { taskpool::parallel_for(pool, 0, 256, [&](int) { counter++; }); });
+
+		CHECK(counter == 64 * 256);
+	}
+
+	SECTION("parallel_for rethrows")
+	{
+		CHECK_THROWS(taskpool::parallel_for(
+		  pool,
+		  0,
+		  1000,
+		  [](int i)
+		  {
+			  if (i == 500)
+				  throw std::runtime_error("fail");
+		  }));
+	}
+
+	SECTION("parallel_reduce")
+	{
+		std::vector<u64> data(100'000);
+		std::iota(data.begin(), data.end(), u64{1});
+
+		CHECK(taskpool::parallel_reduce(pool, data, u64{0}) == 100'000ull * 100'001ull / 2);
+		CHECK(taskpool::parallel_reduce(pool, std::vector<u64>{}, u64{7}) == 7);
+	}
+
+	SECTION("parallel_reduce keeps order")
+	{
+		std::vector<std::string> words(1000, "a");
+		words[0]   = "first";
+		words[999] = "last";
+
+		auto joined = taskpool::parallel_reduce(pool, words, std::string{}, std::plus<>{}, 16);
+		CHECK(joined.starts_with("first"));
+		CHECK(joined.ends_with("last"));
+		CHECK(joined.size() == 5 + 998 + 4);
+	}
+
+	SECTION("parallel_transform")
+	{
+		std::vector<u32> in(5000);
+		std::iota(in.begin(), in.end(), 0u);
+		std::vector<u64> out(in.size());
+
+		taskpool::parallel_transform(pool, in, out, [](u32 v) { return u64{v} * v; });
+
+		CHECK(out[0] == 0);
+		CHECK(out[10] == 100);
+		CHECK(out[4999] == 4999ull * 4999ull);
+	}
+
+	SECTION("parallel_scan")
+	{
+		std::vector<u64> in(10'007);
+		std::iota(in.begin(), in.end(), u64{0});
+
+		std::vector<u64> out(in.size());
+		std::vector<u64> expected(in.size());
+
+		taskpool::parallel_scan(pool, in, out, u64{5});
+		std::inclusive_scan(in.begin(), in.end(), expected.begin(), std::plus<>{}, u64{5});
+
+		CHECK(out == expected);
+	}
+
+	SECTION("parallel_sort")
+	{
+		std::vector<u32> data(200'000);
+		u32              x = 12345;
+		for (auto& v : data)
+		{
+			x ^= x << 13;
+			x ^= x >> 17;
+			x ^= x << 5;
+			v = x % 1000;
+		}
+
+		auto expected = data;
+		std::ranges::sort(expected);
+
+		taskpool::parallel_sort(pool, data);
+		CHECK(data == expected);
+
+		taskpool::parallel_sort(pool, data, std::ranges::greater{});
+		CHECK(std::ranges::is_sorted(data, std::ranges::greater{}));
+	}
+}
+
+TEST_CASE("task_graph", "[taskpool][graph]")
+{
+	taskpool::taskpool pool(4);
+
+	SECTION("dependencies run in order")
+	{
+		taskpool::task_graph graph;
+		std::atomic<u32>     stamp{0};
+		std::array<u32, 5>   when{};
+
+		auto read       = graph.add([&] { when[0] = stamp++; });
+		auto decompress = graph.add([&] { when[1] = stamp++; }, {read});
+		auto decode     = graph.add([&] { when[2] = stamp++; }, {decompress});
+		auto hash       = graph.add([&] { when[3] = stamp++; }, {decompress});
+		graph.add([&] { when[4] = stamp++; }, {decode, hash});
+
+		CHECK(graph.size() == 5);
+
+		for (int frame = 0; frame < 3; ++frame)
+		{
+			stamp = 0;
+			graph.run(pool);
+
+			CHECK(stamp == 5);
+			CHECK(when[0] < when[1]);
+			CHECK(when[1] < when[2]);
+			CHECK(when[1] < when[3]);
+			CHECK(when[2] < when[4]);
+			CHECK(when[3] < when[4]);
+		}
+	}
+
+	SECTION("wide fan-out and join")
+	{
+		taskpool::task_graph graph;
+		std::atomic<u64>     count{0};
+		bool                 joined_after_all = false;
+
+		auto root = graph.add([] { });
+		auto join = graph.add([&] { joined_after_all = count == 1000; });
+		for (int i = 0; i < 1000; ++i)
+		{
+			auto mid = graph.add([&] { count++; }, {root});
+			graph.precede(mid, join);
+		}
+
+		graph.run(pool);
+		CHECK(count == 1000);
+		CHECK(joined_after_all);
+	}
+
+	SECTION("rethrow skips remaining nodes")
+	{
+		taskpool::task_graph graph;
+		std::atomic<u32>     ran{0};
+
+		auto failing = graph.add([] { throw std::runtime_error("task_graph"); });
+		graph.add([&] { ran++; }, {failing});
+
+		CHECK_THROWS_AS(graph.run(pool), std::runtime_error);
+		CHECK(ran == 0);
+	}
+
+	SECTION("empty graph")
+	{
+		taskpool::task_graph graph;
+		graph.run(pool);
+		CHECK(graph.empty());
+	}
+}
+
+namespace
+{
+	taskpool::task<u64> sum_on(taskpool::taskpool& pool, u64 n)
+	{
+		co_await taskpool::schedule_on(pool);
+
+		u64 sum = 0;
+		for (u64 i = 0; i < n; ++i)
+			sum += i;
+		co_return sum;
+	}
+
+	taskpool::task<> fail_on(taskpool::taskpool& pool)
+	{
+		co_await pool.schedule();
+		throw std::runtime_error("coroutine");
+	}
+
+	taskpool::task<u64> chained(taskpool::taskpool& pool)
+	{
+		const u64 a = co_await sum_on(pool, 10);
+		const u64 b = co_await sum_on(pool, 100);
+		co_return a + b;
+	}
+} // namespace
+
+TEST_CASE("taskpool coroutines", "[taskpool][coro]")
+{
+	taskpool::taskpool pool(4);
+
+	SECTION("sync_wait and chaining")
+	{
+		CHECK(taskpool::sync_wait(pool, sum_on(pool, 10)) == 45);
+		CHECK(taskpool::sync_wait(pool, chained(pool)) == 45 + 4950);
+	}
+
+	SECTION("exceptions propagate")
+	{
+		CHECK_THROWS_AS(taskpool::sync_wait(pool, fail_on(pool)), std::runtime_error);
+	}
+
+	SECTION("when_all variadic")
+	{
+		auto [a, b, c] = taskpool::sync_wait(pool, taskpool::when_all(sum_on(pool, 10), sum_on(pool, 5), chained(pool)));
+		CHECK(a == 45);
+		CHECK(b == 10);
+		CHECK(c == 4995);
+
+		CHECK_THROWS_AS(taskpool::sync_wait(pool, taskpool::when_all(sum_on(pool, 10), fail_on(pool))), std::runtime_error);
+	}
+
+	SECTION("when_all vector")
+	{
+		std::vector<taskpool::task<u64>> tasks;
+		for (u64 i = 0; i < 1000; ++i)
+			tasks.push_back(sum_on(pool, i));
+
+		auto results = taskpool::sync_wait(pool, taskpool::when_all(std::move(tasks)));
+		REQUIRE(results.size() == 1000);
+		for (u64 i = 0; i < results.size(); ++i)
+			CHECK(results[i] == i * (i - 1) / 2);
+
+		CHECK(taskpool::sync_wait(pool, taskpool::when_all(std::vector<taskpool::task<u64>>{})).empty());
+	}
+
+	SECTION("when_any")
+	{
+		std::vector<taskpool::task<u64>> tasks;
+		tasks.push_back(sum_on(pool, 10));
+
+		auto first = taskpool::sync_wait(pool, taskpool::when_any(std::move(tasks)));
+		CHECK(first.index == 0);
+		CHECK(first.value == 45);
+	}
+}
+
+TEST_CASE("taskpool placement", "[taskpool][placement]")
+{
+	SECTION("topology")
+	{
+		const auto topology = thread::query_topology();
+		REQUIRE_FALSE(topology.cpus.empty());
+		CHECK_FALSE(topology.nodes.empty());
+		CHECK(topology.cores >= 1);
+		CHECK(topology.cores <= topology.cpus.size());
+
+		u64 on_nodes = 0;
+		for (u32 node : topology.nodes)
+			on_nodes += topology.cpus_on_node(node).size();
+		CHECK(on_nodes == topology.cpus.size());
+	}
+
+	SECTION("pinned workers")
+	{
+		taskpool::taskpool pool({.pin = true});
+		CHECK(pool.size() == pool.topology().cpus.size());
+
+		for (u64 i = 0; i < pool.size(); ++i)
+			CHECK(pool.placement(i).affinity.size() == 1);
+
+		std::atomic<u64> count{0};
+		taskpool::parallel_for(pool, 0, 10'000, [&](int) { count++; });
+		CHECK(count == 10'000);
+	}
+
+	SECTION("numa grouping")
+	{
+		taskpool::taskpool pool({.threads = 4, .numa = true});
+		CHECK(pool.size() == 4);
+
+		for (u64 i = 1; i < pool.size(); ++i)
+			CHECK(pool.placement(i - 1).node <= pool.placement(i).node);
+
+		std::atomic<u64> count{0};
+		taskpool::parallel_for(pool, 0, 10'000, [&](int) { count++; });
+		CHECK(count == 10'000);
+	}
+
+	SECTION("reserved cpus")
+	{
+		const auto topology = thread::query_topology();
+		if (topology.cpus.size() > 1)
+		{
+			const u32          reserved = topology.cpus.front().id;
+			taskpool::taskpool pool({.reserved_cpus = {reserved}});
+
+			CHECK(pool.size() == topology.cpus.size() - 1);
+			for (u64 i = 0; i < pool.size(); ++i)
+				CHECK(std::ranges::find(pool.placement(i).affinity, reserved) == pool.placement(i).affinity.end());
+		}
+	}
+}
+
+TEST_CASE("taskpool priority lanes", "[taskpool][lanes]")
+{
+	using namespace std::chrono_literals;
+
+	taskpool::taskpool pool(1);
+
+	std::atomic<bool>        release{false};
+	std::atomic<u32>         done{0};
+	std::mutex               mutex;
+	std::vector<std::string> order;
+
+	auto record = [&](std::string name)
+	{
+		std::lock_guard lock(mutex);
+		order.push_back(std::move(name));
+		done++;
+	};
+
+	// keeps the only worker busy until every task below is queued
+	auto block_worker = [&]
+	{
+		release = false;
+		done    = 0;
+		order.clear();
+		pool.submit([&] { while (not release) std::this_thread::yield(); });
+		while (pool.stats(taskpool::priority::normal).depth > 0)
+			std::this_thread::yield();
+	};
+
+	auto run_until = [&](u32 count)
+	{
+		release = true;
+		while (done < count)
+			std::this_thread::yield();
+	};
+
+	SECTION("lanes and deadlines")
+	{
+		block_worker();
+
+		const auto now = std::chrono::steady_clock::now();
+		pool.submit([&] { record("background"); }, {.lane = taskpool::priority::background});
+		pool.submit([&] { record("normal"); });
+		pool.submit([&] { record("late"); }, {.deadline = now + 20s});
+		pool.submit([&] { record("early"); }, {.deadline = now + 10s});
+		pool.submit([&] { record("realtime"); }, {.lane = taskpool::priority::realtime});
+
+		run_until(5);
+		CHECK(order == std::vector<std::string>{"realtime", "early", "late", "normal", "background"});
+
+		const auto stats = pool.stats(taskpool::priority::normal);
+		CHECK(stats.depth == 0);
+		CHECK(stats.executed == stats.submitted);
+		CHECK(stats.max_wait >= stats.average_wait());
+	}
+
+	SECTION("background is not starved")
+	{
+		block_worker();
+
+		pool.submit([&] { record("background"); }, {.lane = taskpool::priority::background});
+		for (int i = 0; i < 40; ++i)
+			pool.submit([&] { record("realtime"); }, {.lane = taskpool::priority::realtime});
+
+		run_until(41);
+		const auto position = std::ranges::find(order, "background") - order.begin();
+		CHECK(position < 40);
+	}
+
+	SECTION("missed deadlines")
+	{
+		pool.reset_stats();
+		done = 0;
+		pool.submit([&] { done++; }, {.deadline = std::chrono::steady_clock::now() - 1s});
+		pool.wait_until([&] { return done > 0; });
+
+		CHECK(pool.stats(taskpool::priority::normal).missed_deadlines == 1);
+	}
+}
+
+TEST_CASE("taskpool idle strategy", "[taskpool][idle]")
+{
+	// parks immediately, every submit after the first has to find and wake a sleeping worker
+	for (auto idle : {taskpool::idle_options{.spins = 0, .yields = 0}, taskpool::idle_options{}})
+	{
+		taskpool::taskpool pool({.threads = 4, .idle = idle});
+
+		for (int i = 0; i < 2'000; ++i)
+		{
+			std::atomic<bool> ran{false};
+			pool.submit(
+			  [&]
+			  {
+				  ran = true;
+				  ran.notify_one();
+			  });
+			ran.wait(false);
+		}
+
+		CHECK(pool.idle_workers() <= pool.size());
+	}
+}
+
+TEST_CASE("taskpool profiling", "[taskpool][profile]")
+{
+	SECTION("latency_histogram")
+	{
+		using histogram = taskpool::latency_histogram;
+
+		for (u64 v = 0; v < 1'000'000'000; v = v * 3 / 2 + 1)
+		{
+			const u32 index = histogram::index_of(v);
+			CHECK(histogram::bucket_floor(index) <= v);
+			CHECK(histogram::bucket_floor(index + 1) > v);
+		}
+		CHECK(histogram::index_of(std::numeric_limits<u64>::max()) == histogram::bucket_count - 1);
+
+		histogram h;
+		CHECK(h.percentile(50.0) == 0);
+
+		for (u64 v = 1; v <= 1000; ++v)
+			h.record(v);
+
+		CHECK(h.count() == 1000);
+		CHECK(h.min() == 1);
+		CHECK(h.max() == 1000);
+		CHECK(h.mean() == 500.5);
+		CHECK(h.percentile(0.0) == 1);
+		CHECK(h.percentile(100.0) <= 1000);
+		CHECK(h.percentile(50.0) >= 480);
+		CHECK(h.percentile(50.0) <= 500);
+
+		histogram copy(h);
+		copy.merge(h);
+		CHECK(copy.count() == 2000);
+	}
+
+	SECTION("snapshot and trace")
+	{
+		taskpool::taskpool pool({.threads = 2, .trace_events = 1024});
+		pool.start_trace();
+
+		std::atomic<u64> count{0};
+		taskpool::parallel_for(pool, 0, 10'000, [&](int) { count++; }, 100);
+		pool.stop_trace();
+
+		const auto snapshot = pool.snapshot();
+		const auto trace    = pool.chrome_trace();
+		CHECK(trace.starts_with(R"({"traceEvents":[)"));
+
+		if constexpr (taskpool::profiling)
+		{
+			CHECK(snapshot.workers.size() == pool.size());
+			CHECK(trace.contains(R"("ph":"M")"));
+		}
+		else
+		{
+			CHECK(snapshot.workers.empty());
+			CHECK(snapshot.latency.count() == 0);
+		}
+	}
+}
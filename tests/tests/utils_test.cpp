@@ -1,6 +1,7 @@
 #include <catch2/catch_test_macros.hpp>
 
 
+import std;
 import deckard.types;
 import deckard.uuid;
 import deckard.utf8;
@@ -198,6 +199,54 @@ TEST_CASE("bytepool", "[bytepool]")
 		CHECK(pool.contains(data));
 		CHECK_FALSE(pool.contains(std::array<u8, 5>{5, 6, 7, 8, 9}));
 	}
+
+	SECTION("deduplicates past the initial capacity")
+	{
+		bytepool pool(16);
+
+		auto key = [](u32 i)
+		{
+			std::array<u8, 4> bytes{};
+			std::memcpy(bytes.data(), &i, sizeof(i));
+			return bytes;
+		};
+
+		for (u32 i = 0; i < 10'000; ++i)
+			CHECK(pool.add(key(i)) == i);
+
+		CHECK(pool.size() == 10'000);
+		CHECK(pool.size_in_bytes() == 10'000 * sizeof(u32));
+
+		for (u32 i = 0; i < 10'000; ++i)
+		{
+			CHECK(pool.add(key(i)) == i);
+			CHECK(pool.find(key(i)) == i);
+		}
+		CHECK(pool.size() == 10'000);
+	}
+
+	SECTION("freeze")
+	{
+		bytepool          pool(1024);
+		std::array<u8, 5> data{1, 2, 3, 4, 5};
+		std::array<u8, 3> data2{7, 8, 9};
+
+		auto first  = pool.add(data);
+		auto second = pool.add(data2);
+
+		const frozen_bytepool frozen = pool.freeze();
+		pool.reset();
+
+		CHECK(frozen.size() == 2);
+		CHECK(frozen.find(data) == first);
+		CHECK(frozen.find(data2) == second);
+		CHECK(is_equal(frozen.get(second), data2));
+		CHECK_FALSE(frozen.contains(std::array<u8, 2>{1, 2}));
+
+		// copies share the same storage
+		const frozen_bytepool copy = frozen;
+		CHECK(copy.get(first).data() == frozen.get(first).data());
+	}
 }
 
 TEST_CASE("stringpool", "[stringpool]")
@@ -303,4 +352,84 @@ TEST_CASE("stringpool", "[stringpool]")
 		CHECK(pool.contains("привет мир"sv));
 		CHECK_FALSE(pool.contains("hello world"sv));
 	}
+
+	SECTION("freeze")
+	{
+		string_pool pool(1024);
+		auto        hello = pool.add("hello"sv);
+		auto        world = pool.add("world"sv);
+
+		const frozen_string_pool frozen = pool.freeze();
+
+		CHECK(frozen.size() == 2);
+		CHECK(frozen.get(hello) == "hello"sv);
+		CHECK(frozen.find("world"sv) == world);
+		CHECK(frozen.find("missing"sv) == frozen_string_pool::invalid_handle);
+
+		std::vector<std::thread> readers;
+		std::atomic<u32>         found{0};
+		for (int i = 0; i < 4; ++i)
+			readers.emplace_back([&] { found += frozen.contains("hello"sv) ? 1 : 0; });
+		for (auto& reader : readers)
+			reader.join();
+
+		CHECK(found == 4);
+	}
+}
+
+TEST_CASE("concurrent stringpool", "[stringpool]")
+{
+	SECTION("add and retrieve")
+	{
+		concurrent_string_pool pool(4);
+		CHECK(pool.empty());
+
+		auto hello = pool.add("hello"sv);
+		auto world = pool.add("привет мир"sv);
+
+		CHECK(pool.size() == 2);
+		CHECK(pool.add("hello"sv) == hello);
+		CHECK(pool.get(hello) == "hello"sv);
+		CHECK(pool.get(world) == "привет мир"sv);
+		CHECK(pool.find("world"sv) == concurrent_string_pool::invalid_handle);
+		CHECK(pool.add(""sv) == concurrent_string_pool::invalid_handle);
+	}
+
+	SECTION("threads agree on handles")
+	{
+		constexpr u32 thread_count = 8;
+		constexpr u32 word_count   = 5'000;
+
+		concurrent_string_pool pool;
+
+		std::vector<std::string> words;
+		for (u32 i = 0; i < word_count; ++i)
+			words.push_back(std::format("identifier_{}", i));
+
+		std::vector<std::vector<u32>> handles(thread_count);
+		std::vector<std::thread>      threads;
+		for (u32 t = 0; t < thread_count; ++t)
+		{
+			threads.emplace_back(
+			  [&, t]
+			  {
+				  // every thread interns every word, in a different order
+				  handles[t].resize(word_count);
+				  for (u32 i = 0; i < word_count; ++i)
+				  {
+					  const u32 w   = (i * 7919 + t * 613) % word_count;
+					  handles[t][w] = pool.add(std::string_view{words[w]});
+				  }
+			  });
+		}
+		for (auto& thread : threads)
+			thread.join();
+
+		CHECK(pool.size() == word_count);
+		for (u32 t = 1; t < thread_count; ++t)
+			CHECK(handles[t] == handles[0]);
+
+		for (u32 i = 0; i < word_count; ++i)
+			CHECK(pool.get(handles[0][i]) == std::string_view{words[i]});
+	}
 }
@@ -0,0 +1,257 @@
+export module deckard.taskpool:algorithms;
+
+import :taskpool;
+
+import std;
+import deckard.types;
+
+namespace deckard::taskpool
+{
+	// Fork/join algorithms on top of taskpool
+	//
+	//  taskpool::taskpool pool;
+	//  taskpool::parallel_for(pool, 0uz, data.size(), [&](size_t i) { data[i] *= 2; });
+	//  auto sum = taskpool::parallel_reduce(pool, data, 0ull);
+	//
+	// Ranges are split recursively in halves, the right half is pushed to the pool and the left
+	// is kept. Splitting is lazy: a worker only splits again once its own deque has been stolen
+	// empty, otherwise it just runs grain-sized chunks. The calling thread runs tasks while it waits
+	// on a task_group, so chunks are plain slab jobs without futures.
+	//
+	// grain == 0 picks roughly 8 chunks per worker.
+
+	namespace detail
+	{
+		constexpr u64 chunks_per_worker = 8;
+
+		[[nodiscard]] inline u64 auto_grain(const taskpool& pool, u64 count, u64 grain) noexcept
+		{
+			if (grain > 0)
+				return grain;
+			return std::max<u64>(1, count / (pool.size() * chunks_per_worker));
+		}
+
+		// Calls chunk(first, last) for sub-ranges of at most grain elements
+		template<std::integral I, typename Chunk>
+		void split(task_group& group, I first, I last, u64 grain, Chunk& chunk)
+		{
+			while (first < last)
+			{
+				const u64 count = static_cast<u64>(last - first);
+
+				if (count > grain and group.pool().local_size() == 0)
+				{
+					const I mid = first + static_cast<I>(count / 2);
+
+					group.run([&group, &chunk, mid, last, grain] { split(group, mid, last, grain, chunk); });
+
+					last = mid;
+					continue;
+				}
+
+				const I stop = first + static_cast<I>(std::min(count, grain));
+				chunk(first, stop);
+				first = stop;
+			}
+		}
+
+		template<std::integral I, typename Chunk>
+		void fork_join(taskpool& pool, I first, I last, u64 grain, Chunk&& chunk)
+		{
+			if (first >= last)
+				return;
+
+			task_group group(pool);
+			split(group, first, last, grain, chunk);
+			group.wait();
+		}
+
+		template<std::random_access_iterator It, typename Compare>
+		It median_of_three(It a, It b, It c, Compare& comp)
+		{
+			if (comp(*a, *b))
+			{
+				if (comp(*b, *c))
+					return b;
+				return comp(*a, *c) ? c : a;
+			}
+			if (comp(*a, *c))
+				return a;
+			return comp(*b, *c) ? c : b;
+		}
+
+		template<std::random_access_iterator It, typename Compare>
+		void sort_split(task_group& group, It first, It last, u64 grain, Compare& comp)
+		{
+			while (static_cast<u64>(last - first) > grain)
+			{
+				// three-way partition around median-of-three, pivot parked at first
+				std::iter_swap(first, median_of_three(first, first + (last - first) / 2, last - 1, comp));
+
+				auto less = std::partition(first + 1, last, [&](const auto& e) { return comp(e, *first); });
+				std::iter_swap(first, less - 1);
+				auto pivot   = less - 1;
+				auto greater = std::partition(less, last, [&](const auto& e) { return not comp(*pivot, e); });
+
+				if (greater != last)
+					group.run([&group, &comp, greater, last, grain] { sort_split(group, greater, last, grain, comp); });
+
+				last = pivot;
+			}
+
+			std::sort(first, last, comp);
+		}
+
+	} // namespace detail
+
+	// ###########################################################################
+
+	export template<std::integral I, typename F>
+	requires std::invocable<F&, I>
+	void parallel_for(taskpool& pool, I first, I last, F&& body, u64 grain = 0)
+	{
+		if (first >= last)
+			return;
+
+		grain = detail::auto_grain(pool, static_cast<u64>(last - first), grain);
+		detail::fork_join(
+		  pool,
+		  first,
+		  last,
+		  grain,
+		  [&body](I from, I to)
+		  {
+			  for (I i = from; i < to; ++i)
+				  body(i);
+		  });
+	}
+
+	export template<std::ranges::random_access_range R, typename F>
+	requires std::invocable<F&, std::ranges::range_reference_t<R>>
+	void parallel_for(taskpool& pool, R&& range, F&& body, u64 grain = 0)
+	{
+		auto begin = std::ranges::begin(range);
+		parallel_for(pool, u64{0}, static_cast<u64>(std::ranges::size(range)), [&](u64 i) { body(begin[i]); }, grain);
+	}
+
+	// out[i] = op(in[i]), out must be at least as large as in
+	export template<std::ranges::random_access_range In, std::ranges::random_access_range Out, typename Op>
+	void parallel_transform(taskpool& pool, In&& in, Out&& out, Op&& op, u64 grain = 0)
+	{
+		auto in_begin  = std::ranges::begin(in);
+		auto out_begin = std::ranges::begin(out);
+
+		parallel_for(pool, u64{0}, static_cast<u64>(std::ranges::size(in)), [&](u64 i) { out_begin[i] = op(in_begin[i]); }, grain);
+	}
+
+	// Op must be associative, chunks are combined left to right so it does not need to be commutative
+	export template<std::ranges::random_access_range R, typename T, typename Op = std::plus<>>
+	[[nodiscard]] T parallel_reduce(taskpool& pool, R&& range, T init, Op op = {}, u64 grain = 0)
+	{
+		const u64 count = static_cast<u64>(std::ranges::size(range));
+		if (count == 0)
+			return init;
+
+		grain            = detail::auto_grain(pool, count, grain);
+		const u64 chunks = (count + grain - 1) / grain;
+		auto      begin  = std::ranges::begin(range);
+
+		std::vector<std::optional<T>> partials(chunks);
+
+		parallel_for(
+		  pool,
+		  u64{0},
+		  chunks,
+		  [&](u64 c)
+		  {
+			  const u64 from = c * grain;
+			  const u64 to   = std::min(count, from + grain);
+
+			  T acc = static_cast<T>(begin[from]);
+			  for (u64 i = from + 1; i < to; ++i)
+				  acc = op(std::move(acc), begin[i]);
+			  partials[c] = std::move(acc);
+		  },
+		  1);
+
+		for (auto& partial : partials)
+			init = op(std::move(init), std::move(*partial));
+
+		return init;
+	}
+
+	// Inclusive scan, out[i] = init op in[0] op ... op in[i]
+	export template<std::ranges::random_access_range In, std::ranges::random_access_range Out, typename T, typename Op = std::plus<>>
+	void parallel_scan(taskpool& pool, In&& in, Out&& out, T init, Op op = {}, u64 grain = 0)
+	{
+		const u64 count = static_cast<u64>(std::ranges::size(in));
+		if (count == 0)
+			return;
+
+		grain            = detail::auto_grain(pool, count, grain);
+		const u64 chunks = (count + grain - 1) / grain;
+		auto      src    = std::ranges::begin(in);
+		auto      dst    = std::ranges::begin(out);
+
+		// 1. reduce each chunk
+		std::vector<std::optional<T>> carry(chunks);
+		parallel_for(
+		  pool,
+		  u64{0},
+		  chunks,
+		  [&](u64 c)
+		  {
+			  const u64 from = c * grain;
+			  const u64 to   = std::min(count, from + grain);
+
+			  T acc = static_cast<T>(src[from]);
+			  for (u64 i = from + 1; i < to; ++i)
+				  acc = op(std::move(acc), src[i]);
+			  carry[c] = std::move(acc);
+		  },
+		  1);
+
+		// 2. exclusive scan of chunk sums
+		for (auto& c : carry)
+		{
+			T next = op(init, std::move(*c));
+			c      = std::move(init);
+			init   = std::move(next);
+		}
+
+		// 3. scan each chunk seeded with its carry
+		parallel_for(
+		  pool,
+		  u64{0},
+		  chunks,
+		  [&](u64 c)
+		  {
+			  const u64 from = c * grain;
+			  const u64 to   = std::min(count, from + grain);
+
+			  T acc = std::move(*carry[c]);
+			  for (u64 i = from; i < to; ++i)
+			  {
+				  acc    = op(std::move(acc), src[i]);
+				  dst[i] = acc;
+			  }
+		  },
+		  1);
+	}
+
+	export template<std::ranges::random_access_range R, typename Compare = std::ranges::less>
+	requires std::sortable<std::ranges::iterator_t<R>, Compare>
+	void parallel_sort(taskpool& pool, R&& range, Compare comp = {}, u64 grain = 0)
+	{
+		const u64 count = static_cast<u64>(std::ranges::size(range));
+		if (count < 2)
+			return;
+
+		grain = std::max<u64>(detail::auto_grain(pool, count, grain), 2);
+
+		task_group group(pool);
+		detail::sort_split(group, std::ranges::begin(range), std::ranges::begin(range) + count, grain, comp);
+		group.wait();
+	}
+
+} // namespace deckard::taskpool
@@ -0,0 +1,414 @@
+export module deckard.taskpool:coro;
+
+import :taskpool;
+
+import std;
+import deckard.types;
+import deckard.assert;
+
+namespace deckard::taskpool
+{
+	// Coroutines on top of taskpool
+	//
+	//  taskpool::task<u64> checksum(taskpool::taskpool& pool, std::span<const u8> data)
+	//  {
+	//      co_await taskpool::schedule_on(pool); // continue on a worker
+	//      co_return utils::hash(data);
+	//  }
+	//
+	//  taskpool::task<> load(taskpool::taskpool& pool)
+	//  {
+	//      auto [a, b] = co_await taskpool::when_all(checksum(pool, first), checksum(pool, second));
+	//      ...
+	//  }
+	//
+	//  taskpool::sync_wait(pool, load(pool));
+	//
+	// task<T> is lazy, it starts when awaited and resumes its awaiter on whichever thread it
+	// finished on (symmetric transfer, no thread is parked). Exceptions propagate to the awaiter.
+	// when_all/when_any start their children on the calling thread in order, children that
+	// begin with co_await schedule_on(pool) run in parallel.
+
+	export template<typename T = void>
+	class task;
+
+	template<typename T>
+	struct task_value
+	{
+		using type = T;
+	};
+
+	template<>
+	struct task_value<void>
+	{
+		using type = std::monostate;
+	};
+
+	export template<typename T>
+	using task_value_t = typename task_value<T>::type;
+
+	export template<typename T>
+	struct when_any_result
+	{
+		u64             index{0};
+		task_value_t<T> value;
+	};
+
+	namespace detail
+	{
+		// Value or exception of a finished coroutine
+		template<typename T>
+		class outcome
+		{
+		private:
+			std::optional<task_value_t<T>> m_value;
+			std::exception_ptr             m_error;
+
+		public:
+			template<typename... Args>
+			void set(Args&&... args)
+			{
+				m_value.emplace(std::forward<Args>(args)...);
+			}
+
+			void fail(std::exception_ptr error) noexcept { m_error = std::move(error); }
+
+			[[nodiscard]] task_value_t<T> take()
+			{
+				if (m_error)
+					std::rethrow_exception(m_error);
+
+				assert::check(m_value.has_value(), "Coroutine finished without a result");
+				return std::move(*m_value);
+			}
+		};
+
+		struct promise_base
+		{
+			std::coroutine_handle<> continuation;
+
+			struct final_awaiter
+			{
+				bool await_ready() const noexcept { return false; }
+
+				template<typename P>
+				std::coroutine_handle<> await_suspend(std::coroutine_handle<P> handle) noexcept
+				{
+					if (auto next = handle.promise().continuation; next)
+						return next;
+					return std::noop_coroutine();
+				}
+
+				void await_resume() const noexcept { }
+			};
+
+			std::suspend_always initial_suspend() const noexcept { return {}; }
+
+			final_awaiter final_suspend() const noexcept { return {}; }
+		};
+
+		template<typename T>
+		struct promise_result : promise_base
+		{
+			outcome<T> result;
+
+			template<typename U = T>
+			requires std::convertible_to<U, T>
+			void return_value(U&& value)
+			{
+				result.set(std::forward<U>(value));
+			}
+
+			void unhandled_exception() noexcept { result.fail(std::current_exception()); }
+		};
+
+		template<>
+		struct promise_result<void> : promise_base
+		{
+			outcome<void> result;
+
+			void return_void() { result.set(); }
+
+			void unhandled_exception() noexcept { result.fail(std::current_exception()); }
+		};
+
+		// Eagerly started, self-destroying coroutine used to drive tasks from non-coroutine code
+		struct detached
+		{
+			struct promise_type
+			{
+				detached get_return_object() const noexcept { return {}; }
+
+				std::suspend_never initial_suspend() const noexcept { return {}; }
+
+				std::suspend_never final_suspend() const noexcept { return {}; }
+
+				void return_void() const noexcept { }
+
+				void unhandled_exception() const noexcept { std::terminate(); }
+			};
+		};
+
+		// Runs t to completion and hands its outcome to finish, on whichever thread t ends
+		template<typename T, typename Finish>
+		detached start(task<T> t, Finish finish)
+		{
+			outcome<T> result;
+			try
+			{
+				if constexpr (std::is_void_v<T>)
+				{
+					co_await std::move(t);
+					result.set();
+				}
+				else
+					result.set(co_await std::move(t));
+			}
+			catch (...)
+			{
+				result.fail(std::current_exception());
+			}
+			finish(std::move(result));
+		}
+
+		// Resumes the awaiting coroutine once count children have arrived
+		struct completion
+		{
+			std::atomic<u64>        count;
+			std::coroutine_handle<> continuation;
+
+			// +1 for the awaiter itself, children may finish before it suspends
+			explicit completion(u64 children)
+				: count(children + 1)
+			{
+			}
+
+			void arrive()
+			{
+				if (count.fetch_sub(1, std::memory_order_acq_rel) == 1)
+					continuation.resume();
+			}
+		};
+
+		template<typename Start>
+		struct completion_awaiter
+		{
+			completion& done;
+			Start       start_children;
+
+			bool await_ready() const noexcept { return false; }
+
+			bool await_suspend(std::coroutine_handle<> handle)
+			{
+				done.continuation = handle;
+				start_children();
+				return done.count.fetch_sub(1, std::memory_order_acq_rel) != 1;
+			}
+
+			void await_resume() const noexcept { }
+		};
+
+		template<typename T>
+		struct any_state
+		{
+			completion       done{1};
+			std::atomic_flag won;
+			u64              index{0};
+			outcome<T>       result;
+		};
+
+	} // namespace detail
+
+	// ###########################################################################
+
+	export template<typename T>
+	class [[nodiscard]] task
+	{
+	public:
+		struct promise_type : detail::promise_result<T>
+		{
+			task get_return_object() noexcept { return task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+		};
+
+	private:
+		std::coroutine_handle<promise_type> m_handle;
+
+		explicit task(std::coroutine_handle<promise_type> handle) noexcept
+			: m_handle(handle)
+		{
+		}
+
+	public:
+		task() = default;
+
+		task(task&& other) noexcept
+			: m_handle(std::exchange(other.m_handle, nullptr))
+		{
+		}
+
+		task& operator=(task&& other) noexcept
+		{
+			if (this != &other)
+			{
+				if (m_handle)
+					m_handle.destroy();
+				m_handle = std::exchange(other.m_handle, nullptr);
+			}
+			return *this;
+		}
+
+		task(const task&)            = delete;
+		task& operator=(const task&) = delete;
+
+		~task()
+		{
+			if (m_handle)
+				m_handle.destroy();
+		}
+
+		[[nodiscard]] bool valid() const noexcept { return m_handle != nullptr; }
+
+		[[nodiscard]] bool done() const noexcept { return m_handle and m_handle.done(); }
+
+		auto operator co_await() && noexcept
+		{
+			struct awaiter
+			{
+				std::coroutine_handle<promise_type> handle;
+
+				bool await_ready() const noexcept { return not handle or handle.done(); }
+
+				std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+				{
+					handle.promise().continuation = awaiting;
+					return handle;
+				}
+
+				T await_resume()
+				{
+					assert::check(handle != nullptr, "Awaiting an empty task");
+
+					if constexpr (std::is_void_v<T>)
+						(void)handle.promise().result.take();
+					else
+						return handle.promise().result.take();
+				}
+			};
+
+			return awaiter{m_handle};
+		}
+	};
+
+	// ###########################################################################
+
+	export [[nodiscard]] inline auto schedule_on(taskpool& pool) noexcept { return pool.schedule(); }
+
+	// Runs t from non-coroutine code, the calling thread executes pool tasks until t finishes
+	export template<typename T>
+	task_value_t<T> sync_wait(taskpool& pool, task<T> t)
+	{
+		std::atomic<bool>  finished{false};
+		detail::outcome<T> result;
+
+		detail::start(
+		  std::move(t),
+		  [&](detail::outcome<T>&& done)
+		  {
+			  result = std::move(done);
+			  finished.store(true, std::memory_order_release);
+		  });
+
+		pool.wait_until([&] { return finished.load(std::memory_order_acquire); });
+		return result.take();
+	}
+
+	// Completes when every task has finished, rethrows the first exception in argument order
+	export template<typename... T>
+	task<std::tuple<task_value_t<T>...>> when_all(task<T>... tasks)
+	{
+		std::tuple<task<T>...>            children(std::move(tasks)...);
+		std::tuple<detail::outcome<T>...> results;
+		detail::completion                done(sizeof...(T));
+
+		auto start_children = [&]
+		{
+			[&]<u64... I>(std::index_sequence<I...>)
+			{
+				(detail::start(
+				   std::move(std::get<I>(children)),
+				   [&](auto&& result)
+				   {
+					   std::get<I>(results) = std::move(result);
+					   done.arrive();
+				   }),
+				 ...);
+			}(std::index_sequence_for<T...>{});
+		};
+
+		co_await detail::completion_awaiter{done, start_children};
+
+		co_return std::apply([](auto&... result) { return std::tuple<task_value_t<T>...>{result.take()...}; }, results);
+	}
+
+	export template<typename T>
+	task<std::vector<task_value_t<T>>> when_all(std::vector<task<T>> tasks)
+	{
+		std::vector<detail::outcome<T>> results(tasks.size());
+		detail::completion              done(tasks.size());
+
+		auto start_children = [&]
+		{
+			for (u64 i = 0; i < tasks.size(); ++i)
+			{
+				detail::start(
+				  std::move(tasks[i]),
+				  [&results, &done, i](detail::outcome<T>&& result)
+				  {
+					  results[i] = std::move(result);
+					  done.arrive();
+				  });
+			}
+		};
+
+		co_await detail::completion_awaiter{done, start_children};
+
+		std::vector<task_value_t<T>> values;
+		values.reserve(results.size());
+		for (auto& result : results)
+			values.emplace_back(result.take());
+		co_return values;
+	}
+
+	// Completes with the first task to finish. The others keep running to completion in the
+	// background, anything they reference must outlive them.
+	export template<typename T>
+	task<when_any_result<T>> when_any(std::vector<task<T>> tasks)
+	{
+		assert::check(not tasks.empty(), "when_any needs at least one task");
+
+		auto state = std::make_shared<detail::any_state<T>>();
+
+		auto start_children = [&]
+		{
+			for (u64 i = 0; i < tasks.size(); ++i)
+			{
+				detail::start(
+				  std::move(tasks[i]),
+				  [state, i](detail::outcome<T>&& result)
+				  {
+					  if (state->won.test_and_set(std::memory_order_acq_rel))
+						  return;
+
+					  state->index  = i;
+					  state->result = std::move(result);
+					  state->done.arrive();
+				  });
+			}
+		};
+
+		co_await detail::completion_awaiter{state->done, start_children};
+
+		co_return when_any_result<T>{state->index, state->result.take()};
+	}
+
+} // namespace deckard::taskpool
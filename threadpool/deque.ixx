@@ -0,0 +1,147 @@
+export module deckard.taskpool:deque;
+
+import std;
+import deckard.types;
+import deckard.assert;
+
+namespace deckard::taskpool
+{
+	// Chase-Lev work-stealing deque
+	//
+	// "Correct and Efficient Work-Stealing for Weak Memory Models", Le, Pop, Cohen, Zappa Nardelli (2013)
+	//
+	// Owner thread pushes and pops at the bottom (LIFO, cache warm), thieves take from the top (FIFO)
+	// with a single CAS. Only the owner may call push/pop, anyone may call steal.
+	//
+	// Grown rings are kept alive until the deque is destroyed, a thief may still be reading the old one.
+
+	export template<typename T>
+	requires std::is_trivially_copyable_v<T>
+	class chase_lev_deque
+	{
+	private:
+		class ring
+		{
+		private:
+			i64                               m_capacity{0};
+			i64                               m_mask{0};
+			std::unique_ptr<std::atomic<T>[]> m_data;
+
+		public:
+			explicit ring(i64 capacity)
+				: m_capacity(capacity)
+				, m_mask(capacity - 1)
+				, m_data(std::make_unique<std::atomic<T>[]>(capacity))
+			{
+			}
+
+			[[nodiscard]] i64 capacity() const noexcept { return m_capacity; }
+
+			[[nodiscard]] T load(i64 index) const noexcept { return m_data[index & m_mask].load(std::memory_order_relaxed); }
+
+			void store(i64 index, T value) noexcept { m_data[index & m_mask].store(value, std::memory_order_relaxed); }
+
+			[[nodiscard]] std::unique_ptr<ring> grow(i64 bottom, i64 top) const
+			{
+				auto bigger = std::make_unique<ring>(m_capacity * 2);
+				for (i64 i = top; i < bottom; ++i)
+					bigger->store(i, load(i));
+				return bigger;
+			}
+		};
+
+		alignas(std::hardware_destructive_interference_size) std::atomic<i64> m_top{0};
+		alignas(std::hardware_destructive_interference_size) std::atomic<i64> m_bottom{0};
+		alignas(std::hardware_destructive_interference_size) std::atomic<ring*> m_ring{nullptr};
+
+		std::vector<std::unique_ptr<ring>> m_rings; // owner only
+
+	public:
+		explicit chase_lev_deque(u64 capacity = 256)
+		{
+			assert::check(std::has_single_bit(capacity), "chase_lev_deque capacity must be a power of two");
+
+			m_rings.emplace_back(std::make_unique<ring>(static_cast<i64>(capacity)));
+			m_ring.store(m_rings.back().get(), std::memory_order_relaxed);
+		}
+
+		chase_lev_deque(const chase_lev_deque&)            = delete;
+		chase_lev_deque& operator=(const chase_lev_deque&) = delete;
+
+		// Owner only
+		void push(T value)
+		{
+			const i64 b = m_bottom.load(std::memory_order_relaxed);
+			const i64 t = m_top.load(std::memory_order_acquire);
+			ring*     r = m_ring.load(std::memory_order_relaxed);
+
+			if (b - t > r->capacity() - 1)
+			{
+				m_rings.emplace_back(r->grow(b, t));
+				r = m_rings.back().get();
+				m_ring.store(r, std::memory_order_release);
+			}
+
+			r->store(b, value);
+			m_bottom.store(b + 1, std::memory_order_release);
+		}
+
+		// Owner only
+		[[nodiscard]] std::optional<T> pop()
+		{
+			const i64 b = m_bottom.load(std::memory_order_relaxed) - 1;
+			ring*     r = m_ring.load(std::memory_order_relaxed);
+			m_bottom.store(b, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			i64 t = m_top.load(std::memory_order_relaxed);
+
+			if (t > b)
+			{
+				// empty
+				m_bottom.store(b + 1, std::memory_order_release);
+				return {};
+			}
+
+			T value = r->load(b);
+			if (t == b)
+			{
+				// last item, race against thieves
+				const bool won = m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+				m_bottom.store(b + 1, std::memory_order_release);
+				if (not won)
+					return {};
+			}
+			return value;
+		}
+
+		// Any thread
+		[[nodiscard]] std::optional<T> steal()
+		{
+			i64 t = m_top.load(std::memory_order_acquire);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			const i64 b = m_bottom.load(std::memory_order_acquire);
+
+			if (t >= b)
+				return {};
+
+			ring* r     = m_ring.load(std::memory_order_acquire);
+			T     value = r->load(t);
+			if (not m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+				return {};
+
+			return value;
+		}
+
+		[[nodiscard]] u64 size() const noexcept
+		{
+			const i64 b = m_bottom.load(std::memory_order_relaxed);
+			const i64 t = m_top.load(std::memory_order_relaxed);
+			return b > t ? static_cast<u64>(b - t) : 0;
+		}
+
+		[[nodiscard]] bool empty() const noexcept { return size() == 0; }
+
+		[[nodiscard]] u64 capacity() const noexcept { return m_ring.load(std::memory_order_relaxed)->capacity(); }
+	};
+
+} // namespace deckard::taskpool
@@ -0,0 +1,212 @@
+export module deckard.taskpool:graph;
+
+import :taskpool;
+
+import std;
+import deckard.types;
+import deckard.assert;
+
+namespace deckard::taskpool
+{
+	// Dependency graph of tasks, built once and run many times
+	//
+	//  taskpool::task_graph graph;
+	//  auto read       = graph.add([&] { compressed = file::read(path); });
+	//  auto decompress = graph.add([&] { raw = zstd::uncompress(compressed); }, {read});
+	//  auto decode     = graph.add([&] { img = image::load(raw); }, {decompress});
+	//  auto hash       = graph.add([&] { digest = utils::hash(raw); }, {decompress});
+	//  graph.add([&] { store(img, digest); }, {decode, hash});
+	//
+	//  graph.run(pool); // every frame, no allocations after the first run
+	//
+	// Each node keeps an atomic count of unfinished predecessors. The worker that drops a count
+	// to zero runs the first ready successor itself and pushes the rest to its own deque,
+	// so data produced by a node stays in that core's cache.
+	//
+	// A graph must not be run concurrently with itself. If a node throws, the remaining node
+	// bodies are skipped and run() rethrows the first exception.
+
+	export class task_graph
+	{
+	public:
+		using node_id                         = u32;
+		static constexpr node_id invalid_node = std::numeric_limits<node_id>::max();
+
+	private:
+		struct node
+		{
+			std::move_only_function<void()> work;
+			std::vector<node_id>            successors;
+			u32                             predecessors{0};
+		};
+
+		std::vector<node>                   m_nodes;
+		std::vector<node_id>                m_roots;
+		std::unique_ptr<std::atomic<u32>[]> m_pending;
+		u64                                 m_pending_capacity{0};
+		bool                                m_dirty{true};
+
+		taskpool*          m_pool{nullptr};
+		std::atomic<u32>   m_remaining{0};
+		std::atomic_flag   m_failed;
+		std::exception_ptr m_error;
+
+		// Finds roots and rejects cycles, only when the shape has changed since the last run
+		void prepare()
+		{
+			if (not m_dirty)
+				return;
+
+			m_roots.clear();
+			std::vector<u32>     indegree(m_nodes.size());
+			std::vector<node_id> ready;
+
+			for (node_id i = 0; i < m_nodes.size(); ++i)
+			{
+				indegree[i] = m_nodes[i].predecessors;
+				if (indegree[i] == 0)
+				{
+					m_roots.push_back(i);
+					ready.push_back(i);
+				}
+			}
+
+			u64 visited = 0;
+			while (not ready.empty())
+			{
+				const node_id id = ready.back();
+				ready.pop_back();
+				visited++;
+
+				for (node_id s : m_nodes[id].successors)
+					if (--indegree[s] == 0)
+						ready.push_back(s);
+			}
+
+			assert::check(visited == m_nodes.size(), "task_graph contains a cycle");
+
+			if (m_pending_capacity < m_nodes.size())
+			{
+				m_pending          = std::make_unique<std::atomic<u32>[]>(m_nodes.size());
+				m_pending_capacity = m_nodes.size();
+			}
+
+			m_dirty = false;
+		}
+
+		void spawn(node_id id)
+		{
+			m_pool->submit([this, id] { execute(id); });
+		}
+
+		void execute(node_id id)
+		{
+			while (id != invalid_node)
+			{
+				node& n = m_nodes[id];
+
+				if (not m_failed.test(std::memory_order_acquire))
+				{
+					try
+					{
+						n.work();
+					}
+					catch (...)
+					{
+						if (not m_failed.test_and_set(std::memory_order_acq_rel))
+							m_error = std::current_exception();
+					}
+				}
+
+				node_id next = invalid_node;
+				for (node_id s : n.successors)
+				{
+					if (m_pending[s].fetch_sub(1, std::memory_order_acq_rel) != 1)
+						continue;
+
+					if (next == invalid_node)
+						next = s;
+					else
+						spawn(s);
+				}
+
+				m_remaining.fetch_sub(1, std::memory_order_release);
+				id = next;
+			}
+		}
+
+	public:
+		task_graph() = default;
+
+		task_graph(const task_graph&)            = delete;
+		task_graph& operator=(const task_graph&) = delete;
+
+		template<typename F>
+		requires std::invocable<std::decay_t<F>&>
+		node_id add(F&& work)
+		{
+			assert::check(m_nodes.size() < invalid_node, "task_graph node limit reached");
+
+			m_nodes.push_back({std::forward<F>(work), {}, 0});
+			m_dirty = true;
+			return static_cast<node_id>(m_nodes.size() - 1);
+		}
+
+		template<typename F>
+		requires std::invocable<std::decay_t<F>&>
+		node_id add(F&& work, std::initializer_list<node_id> predecessors)
+		{
+			const node_id id = add(std::forward<F>(work));
+			for (node_id p : predecessors)
+				precede(p, id);
+			return id;
+		}
+
+		// before must finish before after starts
+		void precede(node_id before, node_id after)
+		{
+			assert::check(before < m_nodes.size() and after < m_nodes.size(), "task_graph node out of range");
+			assert::check(before != after, "task_graph node cannot depend on itself");
+
+			m_nodes[before].successors.push_back(after);
+			m_nodes[after].predecessors++;
+			m_dirty = true;
+		}
+
+		// Blocks until every node has run, the calling thread executes pool tasks meanwhile
+		void run(taskpool& pool)
+		{
+			prepare();
+			if (m_nodes.empty())
+				return;
+
+			m_pool  = &pool;
+			m_error = nullptr;
+			m_failed.clear();
+
+			for (node_id i = 0; i < m_nodes.size(); ++i)
+				m_pending[i].store(m_nodes[i].predecessors, std::memory_order_relaxed);
+			m_remaining.store(static_cast<u32>(m_nodes.size()), std::memory_order_release);
+
+			for (node_id root : m_roots)
+				spawn(root);
+
+			pool.wait_until([this] { return m_remaining.load(std::memory_order_acquire) == 0; });
+
+			if (m_error)
+				std::rethrow_exception(std::exchange(m_error, nullptr));
+		}
+
+		void clear()
+		{
+			m_nodes.clear();
+			m_roots.clear();
+			m_dirty = true;
+		}
+
+		[[nodiscard]] u64 size() const noexcept { return m_nodes.size(); }
+
+		[[nodiscard]] bool empty() const noexcept { return m_nodes.empty(); }
+	};
+
+} // namespace deckard::taskpool
@@ -0,0 +1,188 @@
+export module deckard.taskpool:job;
+
+import std;
+import deckard.types;
+import deckard.assert;
+import deckard.scope_exit;
+
+namespace deckard::taskpool
+{
+	// Type-erased fire-and-forget callable stored inline in a slab slot.
+	// Callables larger than inline_size (or over-aligned) are boxed on the heap as a fallback.
+
+	class job_slab;
+	class job_queue;
+
+	class alignas(std::hardware_destructive_interference_size) job
+	{
+	public:
+		static constexpr u64 inline_size = 96;
+
+		template<typename F>
+		static constexpr bool fits_inline =
+		  sizeof(F) <= inline_size and alignof(F) <= alignof(std::max_align_t) and std::is_nothrow_move_constructible_v<F>;
+
+	private:
+		using invoke_fn  = void (*)(job&);
+		using time_point = std::chrono::steady_clock::time_point;
+
+		alignas(std::max_align_t) std::byte m_storage[inline_size];
+		invoke_fn  m_invoke{nullptr};
+		job_slab*  m_slab{nullptr};
+		job*       m_next{nullptr}; // free list or job_queue link
+		time_point m_queued_at{};
+
+		friend class job_slab;
+		friend class job_queue;
+
+	public:
+		template<typename F>
+		void emplace(F&& f)
+		{
+			using fn_t = std::decay_t<F>;
+
+			if constexpr (fits_inline<fn_t>)
+			{
+				std::construct_at(reinterpret_cast<fn_t*>(m_storage), std::forward<F>(f));
+				m_invoke = [](job& self)
+				{
+					auto* fn = std::launder(reinterpret_cast<fn_t*>(self.m_storage));
+					scope_exit _([fn] { std::destroy_at(fn); });
+					(*fn)();
+				};
+			}
+			else
+			{
+				std::construct_at(reinterpret_cast<fn_t**>(m_storage), new fn_t(std::forward<F>(f)));
+				m_invoke = [](job& self)
+				{
+					std::unique_ptr<fn_t> fn(*std::launder(reinterpret_cast<fn_t**>(self.m_storage)));
+					(*fn)();
+				};
+			}
+		}
+
+		// Runs and destroys the stored callable
+		void operator()()
+		{
+			assert::check(m_invoke != nullptr, "Running an empty job");
+			std::exchange(m_invoke, nullptr)(*this);
+		}
+
+		[[nodiscard]] job_slab* slab() const noexcept { return m_slab; }
+
+		void set_queued_at(time_point when) noexcept { m_queued_at = when; }
+
+		[[nodiscard]] time_point queued_at() const noexcept { return m_queued_at; }
+	};
+
+	// Largest callable, in bytes, that run/submit store without a heap allocation
+	export inline constexpr u64 job_inline_size = job::inline_size;
+
+	// Per-worker job storage. Slots are carved out of fixed blocks and recycled through an
+	// owner-only free list, jobs finished on other threads come back through a lock-free
+	// remote list which the owner drains in one exchange when its local list runs dry.
+	// In steady state acquire/release never touch the heap.
+
+	class job_slab
+	{
+	public:
+		static constexpr u64 block_size = 256;
+
+	private:
+		std::vector<std::unique_ptr<job[]>> m_blocks;
+		job*                                m_free{nullptr}; // owner only
+
+		alignas(std::hardware_destructive_interference_size) std::atomic<job*> m_remote{nullptr};
+
+		void grow()
+		{
+			auto& block = m_blocks.emplace_back(std::make_unique<job[]>(block_size));
+			for (u64 i = 0; i < block_size; ++i)
+			{
+				block[i].m_next = m_free;
+				m_free          = &block[i];
+			}
+		}
+
+	public:
+		job_slab() = default;
+
+		job_slab(const job_slab&)            = delete;
+		job_slab& operator=(const job_slab&) = delete;
+
+		// Owner only
+		[[nodiscard]] job* acquire()
+		{
+			if (m_free == nullptr)
+				m_free = m_remote.exchange(nullptr, std::memory_order_acquire);
+
+			if (m_free == nullptr)
+				grow();
+
+			job* j   = m_free;
+			m_free   = j->m_next;
+			j->m_slab = this;
+			return j;
+		}
+
+		// Owner only
+		void release_local(job* j) noexcept
+		{
+			j->m_next = m_free;
+			m_free    = j;
+		}
+
+		// Any thread
+		void release_remote(job* j) noexcept
+		{
+			job* head = m_remote.load(std::memory_order_relaxed);
+			do
+			{
+				j->m_next = head;
+			} while (not m_remote.compare_exchange_weak(head, j, std::memory_order_release, std::memory_order_relaxed));
+		}
+
+		[[nodiscard]] u64 capacity() const noexcept { return m_blocks.size() * block_size; }
+	};
+
+	// Intrusive FIFO through job::m_next, no allocation per push. Not synchronized.
+
+	class job_queue
+	{
+	private:
+		job* m_head{nullptr};
+		job* m_tail{nullptr};
+		u64  m_size{0};
+
+	public:
+		void push(job* j) noexcept
+		{
+			j->m_next = nullptr;
+			if (m_tail)
+				m_tail->m_next = j;
+			else
+				m_head = j;
+			m_tail = j;
+			++m_size;
+		}
+
+		[[nodiscard]] job* pop() noexcept
+		{
+			job* j = m_head;
+			if (j == nullptr)
+				return nullptr;
+
+			m_head = j->m_next;
+			if (m_head == nullptr)
+				m_tail = nullptr;
+			--m_size;
+			return j;
+		}
+
+		[[nodiscard]] bool empty() const noexcept { return m_head == nullptr; }
+
+		[[nodiscard]] u64 size() const noexcept { return m_size; }
+	};
+
+} // namespace deckard::taskpool
@@ -0,0 +1,134 @@
+export module deckard.taskpool:lanes;
+
+import :job;
+
+import std;
+import deckard.types;
+
+namespace deckard::taskpool
+{
+	// Priority lanes for the taskpool shared queue
+	//
+	//  pool.submit([] { handle_request(); }, {.lane = taskpool::priority::realtime});
+	//  pool.submit([] { compress(); }, {.lane = taskpool::priority::background});
+	//  pool.submit([] { reply(); }, {.deadline = std::chrono::steady_clock::now() + 2ms});
+	//
+	// Lanes are served in priority order. A lower lane that has been passed over starvation_limit
+	// times while non-empty is served next, so background work still makes progress.
+	// Inside a lane, tasks with a deadline run earliest-deadline-first, ahead of FIFO tasks without one.
+
+	export enum class priority : u8 {
+		realtime,
+		normal,
+		background,
+	};
+
+	export constexpr u64 lane_count = 3;
+
+	export struct schedule_options
+	{
+		priority                              lane{priority::normal};
+		std::chrono::steady_clock::time_point deadline{std::chrono::steady_clock::time_point::max()};
+	};
+
+	export struct lane_stats
+	{
+		u64                      depth{0};
+		u64                      submitted{0};
+		u64                      executed{0};
+		u64                      missed_deadlines{0};
+		std::chrono::nanoseconds total_wait{0};
+		std::chrono::nanoseconds max_wait{0};
+
+		[[nodiscard]] std::chrono::nanoseconds average_wait() const noexcept
+		{
+			return executed > 0 ? total_wait / static_cast<i64>(executed) : std::chrono::nanoseconds{0};
+		}
+	};
+
+	// Not synchronized, the taskpool guards its lanes with its mutex
+	class lane_queue
+	{
+	private:
+		using clock = std::chrono::steady_clock;
+
+		struct timed
+		{
+			clock::time_point deadline;
+			u64               sequence{0};
+			job*              task{nullptr};
+		};
+
+		job_queue          m_fifo;
+		std::vector<timed> m_timed; // min-heap on (deadline, sequence)
+		u64                m_sequence{0};
+		lane_stats         m_stats;
+
+		static bool later(const timed& a, const timed& b) noexcept
+		{
+			return std::tie(a.deadline, a.sequence) > std::tie(b.deadline, b.sequence);
+		}
+
+	public:
+		u64 skipped{0}; // times passed over for a higher lane while non-empty
+
+		void push(job* task, clock::time_point deadline, clock::time_point now)
+		{
+			task->set_queued_at(now);
+
+			if (deadline == clock::time_point::max())
+				m_fifo.push(task);
+			else
+			{
+				m_timed.push_back({deadline, m_sequence++, task});
+				std::ranges::push_heap(m_timed, later);
+			}
+
+			m_stats.depth++;
+			m_stats.submitted++;
+		}
+
+		[[nodiscard]] job* pop(clock::time_point now)
+		{
+			job* task = nullptr;
+
+			if (not m_timed.empty())
+			{
+				std::ranges::pop_heap(m_timed, later);
+				const timed next = m_timed.back();
+				m_timed.pop_back();
+
+				if (next.deadline < now)
+					m_stats.missed_deadlines++;
+				task = next.task;
+			}
+			else
+				task = m_fifo.pop();
+
+			if (task == nullptr)
+				return nullptr;
+
+			const auto waited = std::chrono::duration_cast<std::chrono::nanoseconds>(now - task->queued_at());
+
+			m_stats.depth--;
+			m_stats.executed++;
+			m_stats.total_wait += waited;
+			m_stats.max_wait = std::max(m_stats.max_wait, waited);
+			return task;
+		}
+
+		[[nodiscard]] bool empty() const noexcept { return m_timed.empty() and m_fifo.empty(); }
+
+		[[nodiscard]] u64 size() const noexcept { return m_timed.size() + m_fifo.size(); }
+
+		[[nodiscard]] const lane_stats& stats() const noexcept { return m_stats; }
+
+		void reset_stats() noexcept
+		{
+			const u64 depth = m_stats.depth;
+			m_stats         = {};
+			m_stats.depth   = depth;
+		}
+	};
+
+} // namespace deckard::taskpool
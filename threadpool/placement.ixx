@@ -0,0 +1,125 @@
+export module deckard.taskpool:placement;
+
+import std;
+import deckard.types;
+import deckard.threadutil;
+
+namespace deckard::taskpool
+{
+	// Worker placement for threadpool and taskpool
+	//
+	//  taskpool::taskpool pool({.pin = true, .numa = true, .reserved_cpus = {0, 1}});
+	//
+	// pin pins each worker to one logical cpu, physical cores are used before SMT siblings.
+	// numa spreads workers over the NUMA nodes in proportion to their cpus, keeps each worker on
+	// its node's cpus and makes it steal from workers on the same node first.
+	// reserved_cpus are never used by workers, e.g. for the main and render threads.
+
+	// How an idle taskpool worker waits for work: spins with a pause hint, then yields its
+	// time slice, then parks until a submit wakes it. Zero spins and yields parks immediately,
+	// the lowest CPU burn, larger values trade CPU for lower wakeup latency.
+	export struct idle_options
+	{
+		u32 spins{128};
+		u32 yields{8};
+	};
+
+	export struct pool_options
+	{
+		u64              threads{0}; // 0 uses every cpu that is not reserved
+		bool             pin{false};
+		bool             numa{false};
+		std::vector<u32> reserved_cpus;
+		idle_options     idle;
+		u64              trace_events{0}; // per worker trace capacity, needs DECKARD_TASKPOOL_PROFILE
+	};
+
+	export struct worker_placement
+	{
+		std::vector<u32> affinity; // empty is unrestricted
+		u32              node{0};
+	};
+
+	namespace detail
+	{
+		// First SMT sibling of every core before any second sibling, then by node and core
+		std::vector<thread::logical_cpu> spread_order(const thread::cpu_topology& topology, const std::vector<u32>& reserved)
+		{
+			std::vector<thread::logical_cpu> usable;
+			for (const auto& cpu : topology.cpus)
+				if (std::ranges::find(reserved, cpu.id) == reserved.end())
+					usable.push_back(cpu);
+
+			if (usable.empty())
+				usable = topology.cpus;
+
+			std::map<u32, u32>                               siblings;
+			std::vector<std::pair<u32, thread::logical_cpu>> ranked;
+			for (const auto& cpu : usable)
+				ranked.emplace_back(siblings[cpu.core]++, cpu);
+
+			std::ranges::stable_sort(
+			  ranked,
+			  [](const auto& a, const auto& b)
+			  { return std::tie(a.first, a.second.node, a.second.core) < std::tie(b.first, b.second.node, b.second.core); });
+
+			usable.clear();
+			for (const auto& [rank, cpu] : ranked)
+				usable.push_back(cpu);
+			return usable;
+		}
+
+		std::vector<worker_placement> place_workers(const thread::cpu_topology& topology, const pool_options& options)
+		{
+			const auto usable = spread_order(topology, options.reserved_cpus);
+			const u64  count  = options.threads > 0 ? options.threads : usable.size();
+
+			std::vector<u32> usable_ids;
+			for (const auto& cpu : usable)
+				usable_ids.push_back(cpu.id);
+
+			std::map<u32, std::vector<thread::logical_cpu>> by_node;
+			for (const auto& cpu : usable)
+				by_node[cpu.node].push_back(cpu);
+
+			std::map<u32, u64>            assigned;
+			std::vector<worker_placement> placements(count);
+
+			for (u64 i = 0; i < count; ++i)
+			{
+				thread::logical_cpu cpu = usable[i % usable.size()];
+
+				if (options.numa)
+				{
+					// node with the fewest workers per cpu
+					auto best = by_node.begin();
+					for (auto it = by_node.begin(); it != by_node.end(); ++it)
+						if (assigned[it->first] * best->second.size() < assigned[best->first] * it->second.size())
+							best = it;
+
+					cpu = best->second[assigned[best->first]++ % best->second.size()];
+				}
+
+				auto& placement = placements[i];
+				placement.node  = (options.numa or options.pin) ? cpu.node : 0;
+
+				if (options.pin)
+					placement.affinity = {cpu.id};
+				else if (options.numa)
+				{
+					for (const auto& other : by_node[cpu.node])
+						placement.affinity.push_back(other.id);
+				}
+				else if (not options.reserved_cpus.empty())
+					placement.affinity = usable_ids;
+			}
+
+			if (options.numa)
+				std::ranges::stable_sort(placements, {}, &worker_placement::node);
+
+			return placements;
+		}
+
+	} // namespace detail
+
+} // namespace deckard::taskpool
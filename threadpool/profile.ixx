@@ -0,0 +1,263 @@
+export module deckard.taskpool:profile;
+
+import :lanes;
+
+import std;
+import deckard.types;
+
+namespace deckard::taskpool
+{
+	// Taskpool instrumentation, enabled with the DECKARD_TASKPOOL_PROFILE CMake option
+	//
+	//  taskpool::taskpool pool({.trace_events = 1 << 16});
+	//  pool.start_trace();
+	//  ...
+	//  pool.stop_trace();
+	//  auto snapshot = pool.snapshot();
+	//  dbg::println("p99 queue latency {}ns", snapshot.latency.percentile(99.0));
+	//  file::write("pool.json", pool.chrome_trace()); // open in Perfetto or chrome://tracing
+	//
+	// When disabled every recording site is discarded by if constexpr, the pool keeps one null pointer.
+
+#ifdef DECKARD_TASKPOOL_PROFILE
+	export constexpr bool profiling = true;
+#else
+	export constexpr bool profiling = false;
+#endif
+
+	// Log-linear histogram in the spirit of HdrHistogram: values below 16 are exact, above that each
+	// power of two is split into 16 buckets, so any recorded value is within 6.25% of its bucket.
+	// Single writer, any number of concurrent readers.
+	export class latency_histogram
+	{
+	public:
+		static constexpr u32 sub_bits     = 4;
+		static constexpr u32 sub_count    = 1u << sub_bits;
+		static constexpr u32 bucket_count = (64 - sub_bits + 1) * sub_count;
+
+	private:
+		std::array<std::atomic<u64>, bucket_count> m_counts{};
+		std::atomic<u64>                           m_total{0};
+		std::atomic<u64>                           m_sum{0};
+		std::atomic<u64>                           m_min{std::numeric_limits<u64>::max()};
+		std::atomic<u64>                           m_max{0};
+
+		static void add(std::atomic<u64>& counter, u64 value) noexcept
+		{
+			counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+		}
+
+	public:
+		latency_histogram() = default;
+
+		latency_histogram(const latency_histogram& other) { merge(other); }
+
+		latency_histogram& operator=(const latency_histogram& other)
+		{
+			if (this != &other)
+			{
+				clear();
+				merge(other);
+			}
+			return *this;
+		}
+
+		[[nodiscard]] static constexpr u32 index_of(u64 value) noexcept
+		{
+			if (value < sub_count)
+				return static_cast<u32>(value);
+
+			const u32 exponent = static_cast<u32>(std::bit_width(value)) - 1;
+			const u32 sub      = static_cast<u32>(value >> (exponent - sub_bits)) & (sub_count - 1);
+			return (exponent - sub_bits + 1) * sub_count + sub;
+		}
+
+		// Smallest value that lands in bucket index
+		[[nodiscard]] static constexpr u64 bucket_floor(u32 index) noexcept
+		{
+			if (index < sub_count)
+				return index;
+
+			const u32 exponent = index / sub_count + sub_bits - 1;
+			const u64 sub      = index % sub_count;
+			return (sub_count + sub) << (exponent - sub_bits);
+		}
+
+		void record(u64 value) noexcept
+		{
+			add(m_counts[index_of(value)], 1);
+			add(m_total, 1);
+			add(m_sum, value);
+			if (value < m_min.load(std::memory_order_relaxed))
+				m_min.store(value, std::memory_order_relaxed);
+			if (value > m_max.load(std::memory_order_relaxed))
+				m_max.store(value, std::memory_order_relaxed);
+		}
+
+		// Not safe against a concurrent record() on this histogram
+		void merge(const latency_histogram& other) noexcept
+		{
+			for (u32 i = 0; i < bucket_count; ++i)
+				add(m_counts[i], other.m_counts[i].load(std::memory_order_relaxed));
+
+			add(m_total, other.m_total.load(std::memory_order_relaxed));
+			add(m_sum, other.m_sum.load(std::memory_order_relaxed));
+			m_min.store(std::min(min(), other.min()), std::memory_order_relaxed);
+			m_max.store(std::max(max(), other.max()), std::memory_order_relaxed);
+		}
+
+		void clear() noexcept
+		{
+			for (auto& count : m_counts)
+				count.store(0, std::memory_order_relaxed);
+			m_total.store(0, std::memory_order_relaxed);
+			m_sum.store(0, std::memory_order_relaxed);
+			m_min.store(std::numeric_limits<u64>::max(), std::memory_order_relaxed);
+			m_max.store(0, std::memory_order_relaxed);
+		}
+
+		[[nodiscard]] u64 count() const noexcept { return m_total.load(std::memory_order_relaxed); }
+
+		[[nodiscard]] u64 min() const noexcept { return m_min.load(std::memory_order_relaxed); }
+
+		[[nodiscard]] u64 max() const noexcept { return m_max.load(std::memory_order_relaxed); }
+
+		[[nodiscard]] f64 mean() const noexcept
+		{
+			const u64 n = count();
+			return n > 0 ? static_cast<f64>(m_sum.load(std::memory_order_relaxed)) / static_cast<f64>(n) : 0.0;
+		}
+
+		// Bucket floor of the value at percentile p (0-100), clamped to the recorded min/max
+		[[nodiscard]] u64 percentile(f64 p) const noexcept
+		{
+			const u64 n = count();
+			if (n == 0)
+				return 0;
+
+			const u64 rank = std::max<u64>(1, static_cast<u64>(std::ceil(std::clamp(p, 0.0, 100.0) / 100.0 * static_cast<f64>(n))));
+
+			u64 seen = 0;
+			for (u32 i = 0; i < bucket_count; ++i)
+			{
+				seen += m_counts[i].load(std::memory_order_relaxed);
+				if (seen >= rank)
+					return std::clamp(bucket_floor(i), min(), max());
+			}
+			return max();
+		}
+	};
+
+	export enum class trace_kind : u8 {
+		task,
+		park,
+	};
+
+	export struct trace_event
+	{
+		u64        start_ns{0}; // since the pool was created
+		u64        duration_ns{0};
+		trace_kind kind{trace_kind::task};
+	};
+
+	export struct worker_stats
+	{
+		u64                      executed{0};
+		u64                      steals{0};
+		u64                      failed_steals{0};
+		std::chrono::nanoseconds work{0};
+		std::chrono::nanoseconds spin{0};
+		std::chrono::nanoseconds idle{0};
+	};
+
+	export struct pool_snapshot
+	{
+		std::vector<worker_stats>          workers;
+		latency_histogram                  latency; // enqueue to start, nanoseconds
+		std::array<lane_stats, lane_count> lanes;
+	};
+
+	// Per-worker recording state, written by its owner only
+	struct worker_profile
+	{
+		std::atomic<u64> executed{0};
+		std::atomic<u64> steals{0};
+		std::atomic<u64> failed_steals{0};
+		std::atomic<u64> work_ns{0};
+		std::atomic<u64> spin_ns{0};
+		std::atomic<u64> idle_ns{0};
+		u32              depth{0}; // nested tasks run while waiting are not counted twice as work
+
+		latency_histogram latency;
+
+		std::vector<trace_event> trace;
+		std::atomic<u64>         trace_size{0};
+
+		static void add(std::atomic<u64>& counter, u64 value) noexcept
+		{
+			counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+		}
+
+		void record_trace(const trace_event& event) noexcept
+		{
+			const u64 size = trace_size.load(std::memory_order_relaxed);
+			if (size >= trace.size())
+				return;
+
+			trace[size] = event;
+			trace_size.store(size + 1, std::memory_order_release);
+		}
+
+		[[nodiscard]] worker_stats stats() const noexcept
+		{
+			return {
+			  .executed      = executed.load(std::memory_order_relaxed),
+			  .steals        = steals.load(std::memory_order_relaxed),
+			  .failed_steals = failed_steals.load(std::memory_order_relaxed),
+			  .work          = std::chrono::nanoseconds(work_ns.load(std::memory_order_relaxed)),
+			  .spin          = std::chrono::nanoseconds(spin_ns.load(std::memory_order_relaxed)),
+			  .idle          = std::chrono::nanoseconds(idle_ns.load(std::memory_order_relaxed)),
+			};
+		}
+	};
+
+	// Chrome trace-event JSON, one track per worker
+	std::string chrome_trace_json(std::span<const worker_profile> profiles)
+	{
+		std::string json;
+		json.reserve(64 + profiles.size() * 128);
+		json += R"({"traceEvents":[)";
+
+		bool first = true;
+		auto comma = [&]
+		{
+			if (not first)
+				json += ",\n";
+			first = false;
+		};
+
+		for (u64 tid = 0; tid < profiles.size(); ++tid)
+		{
+			comma();
+			json += std::format(R"({{"name":"thread_name","ph":"M","pid":1,"tid":{},"args":{{"name":"deckard-pool-{}"}}}})", tid, tid);
+
+			const auto& profile = profiles[tid];
+			const u64   size    = profile.trace_size.load(std::memory_order_acquire);
+			for (u64 i = 0; i < size; ++i)
+			{
+				const auto& event = profile.trace[i];
+				comma();
+				json += std::format(
+				  R"({{"name":"{}","cat":"taskpool","ph":"X","pid":1,"tid":{},"ts":{:.3f},"dur":{:.3f}}})",
+				  event.kind == trace_kind::task ? "task" : "park",
+				  tid,
+				  static_cast<f64>(event.start_ns) / 1000.0,
+				  static_cast<f64>(event.duration_ns) / 1000.0);
+			}
+		}
+
+		json += "]}\n";
+		return json;
+	}
+
+} // namespace deckard::taskpool
@@ -0,0 +1,627 @@
+export module deckard.taskpool:taskpool;
+
+import :deque;
+import :job;
+import :lanes;
+import :placement;
+import :profile;
+
+import std;
+import deckard.types;
+import deckard.scope_exit;
+import deckard.threadutil;
+
+namespace deckard::taskpool
+{
+	export class taskpool
+	{
+	private:
+		using task_t = job*;
+
+		struct worker
+		{
+			chase_lev_deque<task_t> deque;
+			job_slab                slab;
+			std::vector<u64>        victims;      // same node first
+			u64                     local_streak{0}; // local pops since the lanes were last checked
+		};
+
+		using clock = std::chrono::steady_clock;
+
+		// Lower lanes and the shared lanes behind a worker's own deque are served at least this often
+		static constexpr u64 starvation_limit = 16;
+
+		static inline thread_local taskpool* current_pool{nullptr};
+		static inline thread_local u64       current_index{0};
+
+		std::vector<std::thread>  workers;
+		std::unique_ptr<worker[]> locals;
+		u64                       worker_count{0};
+
+		thread::cpu_topology          cpu_topology;
+		std::vector<worker_placement> placements;
+
+		std::array<lane_queue, lane_count> lanes;    // guarded by mutex
+		job_slab                           external; // guarded by mutex
+		std::atomic<u64>                   global_count{0};
+		std::atomic<u64>                   realtime_count{0};
+		std::atomic<i64>                   queued{0};
+		mutable std::mutex                 mutex;
+
+		idle_options      idle_policy;
+		std::atomic<u32>  sleepers{0};   // workers parked or about to park
+		std::atomic<u32>  wake_epoch{0}; // parked workers wait on this
+		std::atomic<bool> stop{false};
+
+		std::unique_ptr<worker_profile[]> profiles; // only allocated when profiling
+		clock::time_point                 created{clock::now()};
+		std::atomic<bool>                 tracing{false};
+
+	public:
+		explicit taskpool(size_t n = std::thread::hardware_concurrency() - 2)
+			: taskpool(pool_options{.threads = std::max(1ull, n)})
+		{
+		}
+
+		explicit taskpool(const pool_options& options)
+			: cpu_topology(thread::query_topology())
+			, placements(detail::place_workers(cpu_topology, options))
+			, idle_policy(options.idle)
+		{
+			worker_count = placements.size();
+			locals       = std::make_unique<worker[]>(worker_count);
+
+			for (u64 i = 0; i < worker_count; ++i)
+				locals[i].victims = steal_order(i);
+
+			if constexpr (profiling)
+			{
+				profiles = std::make_unique<worker_profile[]>(worker_count);
+				for (u64 i = 0; i < worker_count; ++i)
+					profiles[i].trace.resize(options.trace_events);
+			}
+
+			workers.reserve(worker_count);
+			for (u64 i = 0; i < worker_count; ++i)
+				workers.emplace_back([this, i] { worker_loop(i); });
+		}
+
+		~taskpool() { close(); }
+
+		void join()
+		{
+			if (stop.exchange(true))
+				return;
+
+			wake_epoch.fetch_add(1);
+			wake_epoch.notify_all();
+			for (auto& t : workers)
+				t.join();
+		}
+
+		void close() { join(); }
+
+		[[nodiscard]] u64 size() const noexcept { return worker_count; }
+
+		// Workers currently parked, submissions skip the wakeup entirely while this is 0
+		[[nodiscard]] u32 idle_workers() const noexcept { return sleepers.load(std::memory_order_relaxed); }
+
+		template<typename F, typename... Args>
+		auto enqueue(F&& f, Args&&... args) -> std::future<std::invoke_result_t<F, Args...>>
+		{
+			using ret_t = std::invoke_result_t<F, Args...>;
+
+			std::packaged_task<ret_t()> task(
+			  [fn = std::forward<F>(f), ... args = std::forward<Args>(args)]() mutable -> ret_t
+			  { return std::invoke(std::move(fn), std::move(args)...); });
+
+			auto future = task.get_future();
+			push(std::move(task));
+			return future;
+		}
+
+		// Fire-and-forget, no future shared state. Callables up to job_inline_size bytes are
+		// stored inline in a recycled slab slot, so steady-state submission does not allocate.
+		// Exceptions are not captured, use task_group for that.
+		template<typename F>
+		requires std::invocable<std::decay_t<F>&>
+		void submit(F&& f)
+		{
+			push(std::forward<F>(f));
+		}
+
+		// Submits through the shared priority lanes, also from worker threads, so lane and
+		// deadline ordering hold for every task
+		template<typename F>
+		requires std::invocable<std::decay_t<F>&>
+		void submit(F&& f, const schedule_options& options)
+		{
+			push_lane(std::forward<F>(f), options);
+		}
+
+		// co_await pool.schedule() suspends the coroutine and resumes it on a pool worker
+		[[nodiscard]] auto schedule() noexcept
+		{
+			struct awaiter
+			{
+				taskpool& pool;
+
+				bool await_ready() const noexcept { return false; }
+
+				void await_suspend(std::coroutine_handle<> handle) { pool.submit([handle] { handle.resume(); }); }
+
+				void await_resume() const noexcept { }
+			};
+
+			return awaiter{*this};
+		}
+
+		// Runs one pending task on the calling thread, returns false if nothing was found
+		bool run_one()
+		{
+			std::optional<task_t> task;
+
+			if (current_pool == this)
+				task = find_task(current_index);
+			else if (task = pop_global(); not task)
+				task = steal_task(worker_count);
+
+			if (not task)
+				return false;
+
+			run(*task);
+			return true;
+		}
+
+		// Help-while-waiting: keeps executing tasks until done() returns true
+		template<typename Pred>
+		void wait_until(Pred&& done)
+		{
+			while (not done())
+			{
+				if (not run_one())
+					std::this_thread::yield();
+			}
+		}
+
+		// Processors and NUMA nodes detected when the pool was created
+		[[nodiscard]] const thread::cpu_topology& topology() const noexcept { return cpu_topology; }
+
+		[[nodiscard]] const worker_placement& placement(u64 index) const { return placements[index]; }
+
+		[[nodiscard]] lane_stats stats(priority lane) const
+		{
+			std::lock_guard lock(mutex);
+			return lanes[std::to_underlying(lane)].stats();
+		}
+
+		void reset_stats()
+		{
+			std::lock_guard lock(mutex);
+			for (auto& lane : lanes)
+				lane.reset_stats();
+		}
+
+		// Records task and park spans into the per-worker buffers sized by pool_options::trace_events
+		void start_trace() noexcept { tracing.store(true, std::memory_order_relaxed); }
+
+		void stop_trace() noexcept { tracing.store(false, std::memory_order_relaxed); }
+
+		// Worker counters and queue latency are empty unless built with DECKARD_TASKPOOL_PROFILE
+		[[nodiscard]] pool_snapshot snapshot() const
+		{
+			pool_snapshot ret;
+
+			if constexpr (profiling)
+			{
+				for (u64 i = 0; i < worker_count; ++i)
+				{
+					ret.workers.push_back(profiles[i].stats());
+					ret.latency.merge(profiles[i].latency);
+				}
+			}
+
+			std::lock_guard lock(mutex);
+			for (u64 i = 0; i < lane_count; ++i)
+				ret.lanes[i] = lanes[i].stats();
+			return ret;
+		}
+
+		// Chrome trace-event JSON of the recorded spans, loads in Perfetto and chrome://tracing
+		[[nodiscard]] std::string chrome_trace() const
+		{
+			if constexpr (profiling)
+				return chrome_trace_json({profiles.get(), worker_count});
+			else
+				return chrome_trace_json({});
+		}
+
+		// Tasks queued on the calling worker's own deque, 0 for non-worker threads
+		[[nodiscard]] u64 local_size() const noexcept
+		{
+			if (current_pool != this)
+				return 0;
+			return locals[current_index].deque.size();
+		}
+
+
+	private:
+		template<typename F>
+		static task_t make_job(job_slab& slab, F&& f)
+		{
+			task_t     task = slab.acquire();
+			scope_exit undo([&] { slab.release_local(task); });
+			task->emplace(std::forward<F>(f));
+			undo.release();
+			return task;
+		}
+
+		// Tasks pushed from a worker go to its own deque, everything else through the normal lane
+		template<typename F>
+		void push(F&& f)
+		{
+			if (current_pool != this)
+			{
+				push_lane(std::forward<F>(f), {});
+				return;
+			}
+
+			auto&  local = locals[current_index];
+			task_t task  = make_job(local.slab, std::forward<F>(f));
+			if constexpr (profiling)
+				task->set_queued_at(clock::now());
+			queued.fetch_add(1);
+			local.deque.push(task);
+
+			wake_one();
+		}
+
+		template<typename F>
+		void push_lane(F&& f, const schedule_options& options)
+		{
+			{
+				std::lock_guard lock(mutex);
+
+				// a worker's slab is owner only, the external slab is guarded by mutex
+				auto&  slab = current_pool == this ? locals[current_index].slab : external;
+				task_t task = make_job(slab, std::forward<F>(f));
+
+				queued.fetch_add(1);
+				lanes[std::to_underlying(options.lane)].push(task, options.deadline, clock::now());
+				global_count.fetch_add(1, std::memory_order_relaxed);
+				if (options.lane == priority::realtime)
+					realtime_count.fetch_add(1, std::memory_order_relaxed);
+			}
+
+			wake_one();
+		}
+
+		void wake_one()
+		{
+			// queued was raised before this check and a parking worker re-reads queued after
+			// raising sleepers (both seq_cst), so one of the two always sees the other
+			if (sleepers.load() == 0)
+				return;
+
+			wake_epoch.fetch_add(1);
+			wake_epoch.notify_one();
+		}
+
+		void run(task_t task)
+		{
+			queued.fetch_sub(1, std::memory_order_relaxed);
+			scope_exit _([this, task] { recycle(task); });
+
+			if constexpr (profiling)
+			{
+				if (current_pool == this)
+				{
+					run_profiled(profiles[current_index], task);
+					return;
+				}
+			}
+
+			(*task)();
+		}
+
+		void run_profiled(worker_profile& profile, task_t task)
+		{
+			const auto start = clock::now();
+			profile.latency.record(elapsed_ns(task->queued_at(), start));
+			profile.depth++;
+
+			scope_exit done(
+			  [&]
+			  {
+				  const u64 ns = elapsed_ns(start, clock::now());
+
+				  profile.depth--;
+				  worker_profile::add(profile.executed, 1);
+				  if (profile.depth == 0)
+					  worker_profile::add(profile.work_ns, ns);
+				  if (tracing.load(std::memory_order_relaxed))
+					  profile.record_trace({elapsed_ns(created, start), ns, trace_kind::task});
+			  });
+
+			(*task)();
+		}
+
+		static u64 elapsed_ns(clock::time_point from, clock::time_point to) noexcept
+		{
+			return static_cast<u64>(std::max<i64>(0, std::chrono::duration_cast<std::chrono::nanoseconds>(to - from).count()));
+		}
+
+		static clock::time_point profile_now() noexcept
+		{
+			if constexpr (profiling)
+				return clock::now();
+			else
+				return {};
+		}
+
+		// Adds the time since start to one of the worker's counters, optionally as a trace span
+		void profile_span(u64 index, std::atomic<u64> worker_profile::* counter, clock::time_point start, bool trace)
+		{
+			if constexpr (profiling)
+			{
+				auto&     profile = profiles[index];
+				const u64 ns      = elapsed_ns(start, clock::now());
+
+				worker_profile::add(profile.*counter, ns);
+				if (trace and tracing.load(std::memory_order_relaxed))
+					profile.record_trace({elapsed_ns(created, start), ns, trace_kind::park});
+			}
+		}
+
+		void recycle(task_t task)
+		{
+			job_slab* slab = task->slab();
+			if (current_pool == this and slab == &locals[current_index].slab)
+				slab->release_local(task);
+			else
+				slab->release_remote(task);
+		}
+
+		void worker_loop(u64 index)
+		{
+			current_pool  = this;
+			current_index = index;
+
+			thread::set_thread_affinity(placements[index].affinity);
+			thread::set_thread_name(std::format("deckard-pool-{}", index));
+
+			while (true)
+			{
+				if (auto task = find_task(index); task)
+				{
+					run(*task);
+					continue;
+				}
+
+				if (not idle(index))
+					return;
+			}
+		}
+
+		// Spins, then yields, then parks until work is queued. Returns false once stopped and drained.
+		bool idle(u64 index)
+		{
+			auto has_work = [this] { return queued.load() > 0; };
+
+			const auto spin_start = profile_now();
+			bool       found      = false;
+
+			for (u32 i = 0; i < idle_policy.spins and not found; ++i)
+			{
+				found = has_work();
+				if (not found)
+					thread::cpu_relax();
+			}
+
+			for (u32 i = 0; i < idle_policy.yields and not found; ++i)
+			{
+				found = has_work();
+				if (not found)
+					std::this_thread::yield();
+			}
+
+			profile_span(index, &worker_profile::spin_ns, spin_start, false);
+			if (found)
+				return true;
+
+			const auto park_start = profile_now();
+			scope_exit parked([&] { profile_span(index, &worker_profile::idle_ns, park_start, true); });
+
+			sleepers.fetch_add(1);
+			const u32 epoch = wake_epoch.load();
+
+			if (not has_work() and not stop.load())
+				wake_epoch.wait(epoch);
+
+			sleepers.fetch_sub(1);
+			return has_work() or not stop.load();
+		}
+
+		std::optional<task_t> find_task(u64 index)
+		{
+			auto& local = locals[index];
+
+			// realtime work and a long run of local pops both let the shared lanes go first
+			if (realtime_count.load(std::memory_order_relaxed) > 0 or local.local_streak >= starvation_limit)
+			{
+				local.local_streak = 0;
+				if (auto task = pop_global(); task)
+					return task;
+			}
+
+			if (auto task = pop_task(index); task)
+			{
+				local.local_streak++;
+				return task;
+			}
+
+			local.local_streak = 0;
+			if (auto task = pop_global(); task)
+				return task;
+
+			return steal_task(index);
+		}
+
+		std::optional<task_t> pop_task(u64 index) { return locals[index].deque.pop(); }
+
+		// index == worker_count steals from every worker, used by non-worker threads
+		std::optional<task_t> steal_task(u64 index)
+		{
+			if (index == worker_count)
+			{
+				for (u64 victim = 0; victim < worker_count; ++victim)
+					if (auto task = locals[victim].deque.steal(); task)
+						return task;
+				return {};
+			}
+
+			for (u64 victim : locals[index].victims)
+			{
+				if (auto task = locals[victim].deque.steal(); task)
+				{
+					if constexpr (profiling)
+						worker_profile::add(profiles[index].steals, 1);
+					return task;
+				}
+			}
+
+			if constexpr (profiling)
+				worker_profile::add(profiles[index].failed_steals, 1);
+			return {};
+		}
+
+		// Other workers on the same node first, each group rotated to start after index
+		std::vector<u64> steal_order(u64 index) const
+		{
+			std::vector<u64> order;
+			order.reserve(worker_count - 1);
+
+			for (bool same_node : {true, false})
+			{
+				for (u64 i = 1; i < worker_count; ++i)
+				{
+					const u64 victim = (index + i) % worker_count;
+					if ((placements[victim].node == placements[index].node) == same_node)
+						order.push_back(victim);
+				}
+			}
+			return order;
+		}
+
+		std::optional<task_t> pop_global()
+		{
+			if (global_count.load(std::memory_order_relaxed) == 0)
+				return {};
+
+			std::lock_guard lock(mutex);
+
+			u64 chosen = lane_count;
+			for (u64 i = 0; i < lane_count; ++i)
+			{
+				if (lanes[i].empty())
+					continue;
+
+				if (chosen == lane_count)
+					chosen = i;
+				else if (++lanes[i].skipped >= starvation_limit)
+				{
+					chosen = i;
+					break;
+				}
+			}
+
+			if (chosen == lane_count)
+				return {};
+
+			lanes[chosen].skipped = 0;
+			task_t task           = lanes[chosen].pop(clock::now());
+
+			global_count.fetch_sub(1, std::memory_order_relaxed);
+			if (chosen == std::to_underlying(priority::realtime))
+				realtime_count.fetch_sub(1, std::memory_order_relaxed);
+			return task;
+		}
+	};
+
+	// ###########################################################################
+
+	// Counter-based completion for a batch of fire-and-forget tasks
+	//
+	//  taskpool::task_group group(pool);
+	//  for (auto& part : parts)
+	//      group.run([&part] { process(part); });
+	//  group.wait(); // runs pool tasks while waiting, rethrows the first exception
+	//
+	// Destructor waits too, tasks may safely reference the enclosing scope.
+
+	export class task_group
+	{
+	private:
+		taskpool&          m_pool;
+		std::atomic<u64>   m_pending{0};
+		std::atomic_flag   m_failed;
+		std::exception_ptr m_error;
+
+	public:
+		explicit task_group(taskpool& pool)
+			: m_pool(pool)
+		{
+		}
+
+		task_group(const task_group&)            = delete;
+		task_group& operator=(const task_group&) = delete;
+
+		~task_group() { m_pool.wait_until([this] { return finished(); }); }
+
+		template<typename F>
+		requires std::invocable<std::decay_t<F>&>
+		void run(F&& f)
+		{
+			m_pending.fetch_add(1, std::memory_order_relaxed);
+			m_pool.submit(
+			  [this, fn = std::forward<F>(f)]() mutable
+			  {
+				  guarded(fn);
+				  m_pending.fetch_sub(1, std::memory_order_acq_rel);
+			  });
+		}
+
+		void wait()
+		{
+			m_pool.wait_until([this] { return finished(); });
+
+			if (m_error)
+			{
+				m_failed.clear();
+				std::rethrow_exception(std::exchange(m_error, nullptr));
+			}
+		}
+
+		[[nodiscard]] bool finished() const noexcept { return m_pending.load(std::memory_order_acquire) == 0; }
+
+		[[nodiscard]] u64 pending() const noexcept { return m_pending.load(std::memory_order_relaxed); }
+
+		[[nodiscard]] taskpool& pool() noexcept { return m_pool; }
+
+		// Runs f capturing its exception into the group
+		template<typename F>
+		void guarded(F& f) noexcept
+		{
+			try
+			{
+				f();
+			}
+			catch (...)
+			{
+				if (not m_failed.test_and_set(std::memory_order_acq_rel))
+					m_error = std::current_exception();
+			}
+		}
+	};
+
+} // namespace deckard::taskpool
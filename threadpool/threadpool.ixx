@@ -1,5 +1,15 @@
 export module deckard.taskpool;
 
+export import :deque;
+export import :job;
+export import :taskpool;
+export import :algorithms;
+export import :graph;
+export import :coro;
+export import :placement;
+export import :lanes;
+export import :profile;
+
 import std;
 import deckard.function_ref;
 import deckard.threadutil;
@@ -30,11 +40,20 @@ namespace deckard::taskpool
 		std::condition_variable           cv;
 		bool                              stop = false;
 
+		thread::cpu_topology          cpu_topology;
+		std::vector<worker_placement> placements;
+
 	public:
 		explicit threadpool(size_t n = std::thread::hardware_concurrency())
+			: threadpool(pool_options{.threads = std::max(1ull, n)})
 		{
+		}
 
-			n = std::max(1ull, n);
+		explicit threadpool(const pool_options& options)
+			: cpu_topology(thread::query_topology())
+			, placements(detail::place_workers(cpu_topology, options))
+		{
+			const size_t n = placements.size();
 
 			workers.reserve(n);
 
@@ -43,6 +62,7 @@ namespace deckard::taskpool
 				workers.emplace_back(
 				  [i,this]
 				  {
+					thread::set_thread_affinity(placements[i].affinity);
 					thread::set_thread_name(std::format("deckard-pool-{}", i));
 
 					  while (true)
@@ -75,6 +95,10 @@ namespace deckard::taskpool
 				t.join();
 		}
 
+		[[nodiscard]] const thread::cpu_topology& topology() const noexcept { return cpu_topology; }
+
+		[[nodiscard]] const worker_placement& placement(size_t index) const { return placements[index]; }
+
 		template<typename F, typename... Args>
 		auto enqueue(F&& f, Args&&... args) -> std::future<std::invoke_result_t<F, Args...>>
 		{
@@ -89,135 +113,4 @@ namespace deckard::taskpool
 		}
 	};
 
-	export class taskpool
-	{
-	private:
-		using function_t = std::function<void()>;
-
-
-		std::vector<std::thread>            workers;
-		std::vector<std::deque<function_t>> queues;
-		std::queue<function_t>              global;
-		std::mutex                          mutex;
-		std::condition_variable             cv;
-		bool                                stop;
-
-
-	public:
-		explicit taskpool(size_t n = std::thread::hardware_concurrency() - 2)
-			: stop(false)
-		{
-
-			n = std::max(1ull, n);
-
-			queues.resize(n);
-			for (size_t i = 0; i < n; ++i)
-			{
-				workers.emplace_back(
-				  [this, i]
-				  {
-					  thread::set_thread_name(std::format("deckard-pool-{}", i));
-
-					  while (true)
-					  {
-						  function_t task;
-						  if (pop_task(i, task) || steal_task(i, task) || pop_global(task))
-						  {
-							  task();
-						  }
-						  else
-						  {
-							  std::unique_lock lock(mutex);
-							  cv.wait(lock, [this, i] { return stop || !queues[i].empty() || !global.empty(); });
-							  if (stop && all_empty())
-								  return;
-						  }
-					  }
-				  });
-			}
-		}
-
-		~taskpool() { close(); }
-
-		void join()
-		{
-			{
-				std::lock_guard lock(mutex);
-				stop = true;
-			}
-			cv.notify_all();
-			for (auto& t : workers)
-				t.join();
-		}
-
-		void close() { join(); }
-
-		template<typename F, typename... Args>
-		auto enqueue(F&& f, Args&&... args) -> std::future<std::invoke_result_t<F, Args...>>
-		{
-			using ret_t = std::invoke_result_t<F, Args...>;
-			auto task   = std::make_shared<std::packaged_task<ret_t()>>(std::bind(std::forward<F>(f), std::forward<Args>(args)...));
-			{
-				std::lock_guard lock(mutex);
-				global.emplace([task] { (*task)(); });
-			}
-			cv.notify_one();
-			return task->get_future();
-		}
-
-
-	private:
-		bool pop_task(size_t idx, function_t& task)
-		{
-			std::lock_guard lock(mutex);
-			if (!queues[idx].empty())
-			{
-				task = std::move(queues[idx].front());
-				queues[idx].pop_front();
-				return true;
-			}
-			return false;
-		}
-
-		bool steal_task(size_t idx, function_t& task)
-		{
-
-			std::lock_guard lock(mutex);
-			for (size_t i = 0; i < queues.size(); ++i)
-			{
-				if (i == idx)
-					continue;
-				if (!queues[i].empty())
-				{
-					task = std::move(queues[i].back());
-					queues[i].pop_back();
-					return true;
-				}
-			}
-			return false;
-		}
-
-		bool pop_global(function_t& task)
-		{
-			std::lock_guard lock(mutex);
-			if (!global.empty())
-			{
-				task = std::move(global.front());
-				global.pop();
-				return true;
-			}
-			return false;
-		}
-
-		bool all_empty()
-		{
-
-			for (const auto& q : queues)
-				if (!q.empty())
-					return false;
-			return global.empty();
-		}
-	};
-
-
 } // namespace deckard
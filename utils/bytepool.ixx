@@ -12,7 +12,7 @@ namespace deckard
 	{
 		using is_transparent = void;
 
-		size_t operator()(std::span<const u8> s) const { return utils::hash_values(s); }
+		size_t operator()(std::span<const u8> s) const { return utils::rapidhash(s); }
 	};
 
 	export struct Bytepool_Equal
@@ -22,72 +22,269 @@ namespace deckard
 		bool operator()(std::span<const u8> a, std::span<const u8> b) const { return std::ranges::equal(a, b); }
 	};
 
+	// Interned bytes are appended to large chunks, one allocation per chunk instead of per entry.
+	// Lookups go through an open-addressing table of (hash, handle) with linear probing, the
+	// handle indexes (chunk, offset, length). freeze() compacts everything into one immutable
+	// buffer that can be shared between threads for concurrent lookups.
+
+	namespace detail
+	{
+		struct pool_entry
+		{
+			u32 chunk{0};
+			u32 offset{0};
+			u32 length{0};
+			u32 hash{0};
+		};
+
+		struct pool_slot
+		{
+			u32 hash{0};
+			u32 index{std::numeric_limits<u32>::max()};
+		};
+
+		constexpr u32 empty_slot = std::numeric_limits<u32>::max();
+
+		[[nodiscard]] inline u32 pool_hash(std::span<const u8> data) { return static_cast<u32>(Bytepool_Hash{}(data)); }
+
+		// Slot holding data, or the empty slot where it belongs. The table is never full.
+		template<typename Get>
+		[[nodiscard]] u64 probe(std::span<const pool_slot> table, std::span<const u8> data, u32 hash, Get&& get)
+		{
+			const u64 mask = table.size() - 1;
+			for (u64 i = hash & mask;; i = (i + 1) & mask)
+			{
+				const pool_slot& slot = table[i];
+				if (slot.index == empty_slot)
+					return i;
+				if (slot.hash == hash and Bytepool_Equal{}(get(slot.index), data))
+					return i;
+			}
+		}
+
+		[[nodiscard]] inline u64 table_size_for(u64 entries) { return std::bit_ceil(std::max<u64>(16, entries * 2)); }
+
+	} // namespace detail
+
+	// Read-only snapshot of a bytepool, cheap to copy and safe to read from any number of threads
+	export class frozen_bytepool
+	{
+	public:
+		using byte_span = std::span<const u8>;
+		using handle    = u32;
+
+		static constexpr handle invalid_handle = std::numeric_limits<handle>::max();
+
+	private:
+		struct storage
+		{
+			std::vector<u8>                 bytes;
+			std::vector<detail::pool_entry> entries;
+			std::vector<detail::pool_slot>  table;
+		};
+
+		std::shared_ptr<const storage> m_storage;
+
+		friend class bytepool;
+
+	public:
+		frozen_bytepool() = default;
+
+		[[nodiscard]] byte_span get(handle h) const noexcept
+		{
+			if (not m_storage or h >= m_storage->entries.size())
+				return {};
+
+			const auto& entry = m_storage->entries[h];
+			return {m_storage->bytes.data() + entry.offset, entry.length};
+		}
+
+		[[nodiscard]] handle find(byte_span data) const
+		{
+			if (data.empty() or empty())
+				return invalid_handle;
+
+			const u64 slot = detail::probe(m_storage->table, data, detail::pool_hash(data), [this](handle h) { return get(h); });
+			return m_storage->table[slot].index;
+		}
+
+		[[nodiscard]] bool contains(byte_span data) const { return find(data) != invalid_handle; }
+
+		[[nodiscard]] size_t size() const noexcept { return m_storage ? m_storage->entries.size() : 0; }
+
+		[[nodiscard]] bool empty() const noexcept { return size() == 0; }
+
+		[[nodiscard]] size_t size_in_bytes() const noexcept { return m_storage ? m_storage->bytes.size() : 0; }
+	};
+
 	export class bytepool
 	{
 	public:
 		using byte_span = std::span<const u8>;
 		using handle    = u32;
+
 		static constexpr handle invalid_handle = std::numeric_limits<handle>::max();
+		static constexpr u64    chunk_size     = 64_KiB;
 
 	private:
-		std::deque<std::vector<u8>>                                          m_storage;
-		std::unordered_map<byte_span, handle, Bytepool_Hash, Bytepool_Equal> m_map;
+		std::pmr::vector<std::pmr::vector<u8>> m_chunks;
+		std::pmr::vector<detail::pool_entry>   m_entries;
+		std::pmr::vector<detail::pool_slot>    m_table;
+
+		[[nodiscard]] u64 probe(byte_span data, u32 hash) const
+		{
+			return detail::probe(m_table, data, hash, [this](handle h) { return get(h); });
+		}
+
+		// Keeps the load factor at or below one half
+		void grow_table()
+		{
+			std::pmr::vector<detail::pool_slot> table(m_table.size() * 2, m_table.get_allocator());
+
+			const u64 mask = table.size() - 1;
+			for (u32 i = 0; i < m_entries.size(); ++i)
+			{
+				u64 slot = m_entries[i].hash & mask;
+				while (table[slot].index != detail::empty_slot)
+					slot = (slot + 1) & mask;
+				table[slot] = {m_entries[i].hash, i};
+			}
+
+			m_table = std::move(table);
+		}
+
+		// Chunks are reserved up front and never reallocated, so entries never move
+		[[nodiscard]] detail::pool_entry append(byte_span data)
+		{
+			if (m_chunks.empty() or m_chunks.back().capacity() - m_chunks.back().size() < data.size())
+				m_chunks.emplace_back().reserve(std::max<u64>(chunk_size, data.size()));
+
+			auto& chunk = m_chunks.back();
+
+			detail::pool_entry entry;
+			entry.chunk  = as<u32>(m_chunks.size() - 1);
+			entry.offset = as<u32>(chunk.size());
+			entry.length = as<u32>(data.size());
+
+			chunk.insert(chunk.end(), data.begin(), data.end());
+			return entry;
+		}
 
 	public:
-		explicit bytepool(size_t initial_capacity = 256) { m_map.reserve(initial_capacity); }
+		explicit bytepool(size_t initial_capacity = 256, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+			: m_chunks(resource)
+			, m_entries(resource)
+			, m_table(detail::table_size_for(initial_capacity), resource)
+		{
+			m_entries.reserve(initial_capacity);
+		}
+
+		[[nodiscard]] std::pmr::memory_resource* resource() const noexcept { return m_table.get_allocator().resource(); }
 
 		void reset()
 		{
-			m_storage.clear();
-			m_map.clear();
+			m_chunks.clear();
+			m_entries.clear();
+			std::ranges::fill(m_table, detail::pool_slot{});
 		}
 
 		[[nodiscard]] byte_span get(handle h) const noexcept
 		{
-			if (h >= m_storage.size())
+			if (h >= m_entries.size())
 				return {};
-			return std::span(m_storage[h]);
+
+			const auto& entry = m_entries[h];
+			return {m_chunks[entry.chunk].data() + entry.offset, entry.length};
 		}
 
-		[[nodiscard]] handle add(byte_span data) 
+		[[nodiscard]] handle add(byte_span data)
 		{
 			if (data.empty())
 				return invalid_handle;
 
-			if (auto it = m_map.find(data); it != m_map.end())
-				return it->second;
+			const u32 hash = detail::pool_hash(data);
+			u64       slot = probe(data, hash);
+			if (m_table[slot].index != detail::empty_slot)
+				return m_table[slot].index;
+
+			assert::check(m_entries.size() < invalid_handle, "Bytepool capacity exceeded");
 
-			assert::check(m_storage.size() < invalid_handle, "Bytepool capacity exceeded");
+			if ((m_entries.size() + 1) * 2 > m_table.size())
+			{
+				grow_table();
+				slot = probe(data, hash);
+			}
 
-			handle new_handle = static_cast<handle>(m_storage.size());
-			m_storage.emplace_back(data.begin(), data.end());
-			m_map.emplace(std::span(m_storage.back()), new_handle);
+			detail::pool_entry entry = append(data);
+			entry.hash               = hash;
+
+			const handle new_handle = as<handle>(m_entries.size());
+			m_entries.push_back(entry);
+			m_table[slot] = {hash, new_handle};
 			return new_handle;
 		}
 
-		[[nodiscard]] bool contains(byte_span data) const noexcept { return m_map.contains(data); }
+		[[nodiscard]] handle find(byte_span data) const
+		{
+			if (data.empty())
+				return invalid_handle;
+			return m_table[probe(data, detail::pool_hash(data))].index;
+		}
+
+		[[nodiscard]] bool contains(byte_span data) const { return find(data) != invalid_handle; }
 
-		void merge(bytepool& other) noexcept
+		void merge(bytepool& other)
 		{
 			combine(other);
 			other.reset();
 		}
 
-		void combine(bytepool& other) noexcept
+		void combine(bytepool& other)
 		{
 			if (&other == this)
 				return;
 			if (other.empty())
 				return;
-			m_map.reserve(m_map.size() + other.size());
-		
-			for (const auto& data : other.m_storage)
-				(void)add(std::span(data));
+
+			for (handle h = 0; h < other.size(); ++h)
+				(void)add(other.get(h));
 		}
 
-		[[nodiscard]] size_t size() const noexcept { return m_map.size(); }
+		// Compacts the pool into a single buffer, handles stay the same
+		[[nodiscard]] frozen_bytepool freeze() const
+		{
+			auto storage = std::make_shared<frozen_bytepool::storage>();
+
+			storage->bytes.reserve(size_in_bytes());
+			storage->entries.reserve(m_entries.size());
+			for (handle h = 0; h < m_entries.size(); ++h)
+			{
+				const auto data = get(h);
+
+				auto entry   = m_entries[h];
+				entry.chunk  = 0;
+				entry.offset = as<u32>(storage->bytes.size());
+				storage->entries.push_back(entry);
+				storage->bytes.insert(storage->bytes.end(), data.begin(), data.end());
+			}
+			storage->table.assign(m_table.begin(), m_table.end());
+
+			frozen_bytepool frozen;
+			frozen.m_storage = std::move(storage);
+			return frozen;
+		}
 
-		[[nodiscard]] bool empty() const noexcept { return m_map.empty(); }
+		[[nodiscard]] size_t size() const noexcept { return m_entries.size(); }
+
+		[[nodiscard]] bool empty() const noexcept { return m_entries.empty(); }
+
+		[[nodiscard]] size_t size_in_bytes() const noexcept
+		{
+			size_t total = 0;
+			for (const auto& chunk : m_chunks)
+				total += chunk.size();
+			return total;
+		}
 	};
 
 } // namespace deckard
@@ -0,0 +1,653 @@
+export module deckard.cache;
+
+import std;
+import deckard.assert;
+import deckard.types;
+import deckard.lru;
+import deckard.utils.hash;
+
+namespace deckard
+{
+	/* Eviction policies behind the lru_cache interface, pick per workload with replay()
+
+		sieve_cache<u64, image>   images(4096);   // scan resistant, a hit only sets a bit
+		clock_cache<u64, image>   images(4096);   // second chance ring, a hit only sets a bit
+		tinylfu_cache<u64, image> images(4096);   // frequency based admission, best on skewed traffic
+
+		if (image* img = images.get(id))
+			draw(*img);
+		else
+			images.put(id, decode(id));
+
+	 lru_cache moves every hit to the front and lets one sequential scan flush it. SIEVE and
+	 CLOCK only mark hits and evict the first unmarked entry the hand finds. W-TinyLFU keeps a
+	 small LRU window for new keys and admits a key to the main cache only when a count-min
+	 sketch says it is used more often than the entry it would replace.
+	*/
+
+	export template<typename Cache, typename Key, typename Value>
+	concept cache_policy = requires(Cache cache, const Cache ccache, Key key, Value value) {
+		cache.put(std::move(key), std::move(value));
+		{ cache.get(key) } -> std::convertible_to<Value*>;
+		{ ccache.peek(key) } -> std::convertible_to<const Value*>;
+		{ cache.erase(key) } -> std::same_as<bool>;
+		{ ccache.exists(key) } -> std::same_as<bool>;
+		{ ccache.size() } -> std::same_as<u64>;
+		{ ccache.capacity() } -> std::same_as<u64>;
+		cache.clear();
+	};
+
+	namespace detail
+	{
+		template<typename Key>
+		[[nodiscard]] u64 sketch_hash(const Key& key)
+		{
+			if constexpr (std::is_convertible_v<const Key&, std::string_view>)
+				return utils::rapidhash(std::string_view(key));
+			else if constexpr (std::has_unique_object_representations_v<Key>)
+				return utils::rapidhash(&key, sizeof(Key));
+			else
+			{
+				const u64 h = static_cast<u64>(std::hash<Key>{}(key));
+				return utils::rapidhash(&h, sizeof(h));
+			}
+		}
+	} // namespace detail
+
+	// Approximate access counts in 4-bit saturating counters. A key's four counters all sit in
+	// one 64-byte block chosen by its hash, so an update or estimate touches one cache line.
+	// Every counter is halved after sample_size increments so old popularity fades.
+	export class count_min_sketch
+	{
+	private:
+		static constexpr u32 depth = 4;
+
+		struct alignas(64) block
+		{
+			std::array<u64, 8> words{}; // 16 counters per word
+		};
+
+		std::vector<block> m_blocks;
+		u64                m_block_mask{0};
+		u64                m_additions{0};
+		u64                m_sample_size{0};
+
+		// Low bits pick the block, the rest pick a word pair and a counter per row
+		template<typename Fn>
+		void for_each_counter(u64 hash, Fn&& fn) const
+		{
+			const u64 index = hash & m_block_mask;
+			const u64 bits  = hash >> 32;
+
+			for (u32 row = 0; row < depth; ++row)
+			{
+				const u32 word    = row * 2 + static_cast<u32>((bits >> row) & 1);
+				const u32 counter = static_cast<u32>((bits >> (8 + row * 4)) & 0xF);
+				fn(index, word, counter * 4);
+			}
+		}
+
+		void age() noexcept
+		{
+			for (block& b : m_blocks)
+				for (u64& word : b.words)
+					word = (word >> 1) & 0x7777'7777'7777'7777ull;
+			m_additions /= 2;
+		}
+
+	public:
+		explicit count_min_sketch(u64 expected_keys)
+		{
+			// 128 counters per block, about 8 per expected key over the 4 rows
+			const u64 blocks = std::bit_ceil(std::max<u64>(expected_keys / 16, 1));
+
+			m_blocks.resize(blocks);
+			m_block_mask  = blocks - 1;
+			m_sample_size = std::max<u64>(expected_keys, 16) * 10;
+		}
+
+		void increment(u64 hash) noexcept
+		{
+			bool added = false;
+			for_each_counter(
+			  hash,
+			  [&](u64 index, u32 word, u32 shift)
+			  {
+				  u64& w = m_blocks[index].words[word];
+				  if (((w >> shift) & 0xF) < 15)
+				  {
+					  w += 1ull << shift;
+					  added = true;
+				  }
+			  });
+
+			if (added and ++m_additions >= m_sample_size)
+				age();
+		}
+
+		[[nodiscard]] u32 frequency(u64 hash) const noexcept
+		{
+			u32 result = 15;
+			for_each_counter(
+			  hash,
+			  [&](u64 index, u32 word, u32 shift)
+			  { result = std::min(result, static_cast<u32>((m_blocks[index].words[word] >> shift) & 0xF)); });
+			return result;
+		}
+
+		void clear() noexcept
+		{
+			std::ranges::fill(m_blocks, block{});
+			m_additions = 0;
+		}
+	};
+
+	// SIEVE (Zhang et al., NSDI '24): new entries go to the head of a FIFO, a hit sets the
+	// visited bit. The hand walks from the tail towards the head, clears visited bits and
+	// evicts the first unvisited entry. Survivors are not moved, so a hit never relinks.
+	export template<typename Key, typename Value>
+	class sieve_cache
+	{
+	private:
+		static constexpr u32 npos    = detail::key_index::npos;
+		static constexpr u64 no_slot = detail::key_index::no_slot;
+
+		struct entry
+		{
+			std::pair<Key, Value> item;
+			u32                   prev{npos}; // towards the head, newer
+			u32                   next{npos}; // towards the tail, older. Next free entry when erased
+			u32                   hash{0};
+			bool                  visited{false};
+		};
+
+		std::pmr::vector<entry> m_entries;
+		detail::key_index       m_index;
+		u64                     m_size{0};
+		u64                     max_size;
+		u32                     m_head{npos};
+		u32                     m_tail{npos};
+		u32                     m_hand{npos};
+		u32                     m_free{npos};
+
+		[[nodiscard]] u64 find_slot(const Key& key, u32 hash) const
+		{
+			return m_index.find(hash, [&](u32 index) { return m_entries[index].item.first == key; });
+		}
+
+		void unlink(u32 index) noexcept
+		{
+			entry& e = m_entries[index];
+			if (m_hand == index)
+				m_hand = e.prev;
+			(e.prev != npos ? m_entries[e.prev].next : m_head) = e.next;
+			(e.next != npos ? m_entries[e.next].prev : m_tail) = e.prev;
+		}
+
+		void link_front(u32 index) noexcept
+		{
+			entry& e = m_entries[index];
+			e.prev   = npos;
+			e.next   = m_head;
+			(m_head != npos ? m_entries[m_head].prev : m_tail) = index;
+			m_head = index;
+		}
+
+		[[nodiscard]] u32 evict() noexcept
+		{
+			u32 index = m_hand != npos ? m_hand : m_tail;
+			while (m_entries[index].visited)
+			{
+				m_entries[index].visited = false;
+				index                    = m_entries[index].prev != npos ? m_entries[index].prev : m_tail;
+			}
+
+			m_hand = index; // unlink moves the hand on to the next newer entry
+			m_index.remove(m_index.slot_of(index, m_entries[index].hash));
+			unlink(index);
+			return index;
+		}
+
+	public:
+		explicit sieve_cache(u64 max_size, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+			: m_entries(resource)
+			, m_index(resource)
+			, max_size{max_size}
+		{
+			assert::check(max_size > 0, "sieve_cache max_size must be greater than zero");
+			assert::check(max_size <= (1ull << 31), "sieve_cache max_size is limited to 2^31 entries");
+		}
+
+		void put(Key key, Value value)
+		{
+			const u32 hash = static_cast<u32>(detail::key_hash(key));
+
+			if (const u64 pos = find_slot(key, hash); pos != no_slot)
+			{
+				entry& e      = m_entries[m_index.index_at(pos)];
+				e.item.second = std::move(value);
+				e.visited     = true;
+				return;
+			}
+
+			u32 index = npos;
+			if (m_size == max_size)
+			{
+				index                 = evict();
+				m_entries[index].item = {std::move(key), std::move(value)};
+			}
+			else
+			{
+				m_index.reserve(m_size + 1);
+				if (m_free != npos)
+				{
+					index                 = m_free;
+					m_free                = m_entries[index].next;
+					m_entries[index].item = {std::move(key), std::move(value)};
+				}
+				else
+				{
+					index = static_cast<u32>(m_entries.size());
+					m_entries.push_back({.item = {std::move(key), std::move(value)}});
+				}
+				++m_size;
+			}
+
+			entry& e  = m_entries[index];
+			e.hash    = hash;
+			e.visited = false;
+			m_index.insert(index, hash);
+			link_front(index);
+		}
+
+		// Marks key as visited. nullptr when missing, valid until the next put, erase or clear.
+		[[nodiscard]] Value* get(const Key& key)
+		{
+			const u64 pos = find_slot(key, static_cast<u32>(detail::key_hash(key)));
+			if (pos == no_slot)
+				return nullptr;
+
+			entry& e  = m_entries[m_index.index_at(pos)];
+			e.visited = true;
+			return &e.item.second;
+		}
+
+		[[nodiscard]] const Value* peek(const Key& key) const
+		{
+			const u64 pos = find_slot(key, static_cast<u32>(detail::key_hash(key)));
+			return pos != no_slot ? &m_entries[m_index.index_at(pos)].item.second : nullptr;
+		}
+
+		bool erase(const Key& key)
+		{
+			const u64 pos = find_slot(key, static_cast<u32>(detail::key_hash(key)));
+			if (pos == no_slot)
+				return false;
+
+			const u32 index = m_index.index_at(pos);
+			m_index.remove(pos);
+			unlink(index);
+
+			if constexpr (std::is_default_constructible_v<Value>)
+				m_entries[index].item.second = Value{};
+
+			m_entries[index].next = m_free;
+			m_free                = index;
+			--m_size;
+			return true;
+		}
+
+		[[nodiscard]] bool exists(const Key& key) const { return find_slot(key, static_cast<u32>(detail::key_hash(key))) != no_slot; }
+
+		void clear()
+		{
+			m_entries.clear();
+			m_index.clear();
+			m_size = 0;
+			m_head = m_tail = m_hand = m_free = npos;
+		}
+
+		[[nodiscard]] u64 size() const { return m_size; }
+
+		[[nodiscard]] u64 capacity() const { return max_size; }
+	};
+
+	// CLOCK: entries sit in a ring, a hit sets the referenced bit. The hand sweeps the ring,
+	// gives referenced entries a second chance by clearing the bit, and replaces the first
+	// unreferenced entry in place.
+	export template<typename Key, typename Value>
+	class clock_cache
+	{
+	private:
+		static constexpr u32 npos    = detail::key_index::npos;
+		static constexpr u64 no_slot = detail::key_index::no_slot;
+
+		struct entry
+		{
+			std::pair<Key, Value> item;
+			u32                   hash{0};
+			u32                   next_free{npos};
+			bool                  referenced{false};
+			bool                  occupied{false};
+		};
+
+		std::pmr::vector<entry> m_entries;
+		detail::key_index       m_index;
+		u64                     m_size{0};
+		u64                     max_size;
+		u32                     m_hand{0};
+		u32                     m_free{npos};
+
+		[[nodiscard]] u64 find_slot(const Key& key, u32 hash) const
+		{
+			return m_index.find(hash, [&](u32 index) { return m_entries[index].item.first == key; });
+		}
+
+		// Only called when the ring is full, every entry is occupied
+		[[nodiscard]] u32 evict() noexcept
+		{
+			for (;;)
+			{
+				const u32 index = m_hand;
+				m_hand          = index + 1 == m_entries.size() ? 0 : index + 1;
+
+				entry& e = m_entries[index];
+				if (not e.referenced)
+				{
+					m_index.remove(m_index.slot_of(index, e.hash));
+					return index;
+				}
+				e.referenced = false;
+			}
+		}
+
+	public:
+		explicit clock_cache(u64 max_size, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+			: m_entries(resource)
+			, m_index(resource)
+			, max_size{max_size}
+		{
+			assert::check(max_size > 0, "clock_cache max_size must be greater than zero");
+			assert::check(max_size <= (1ull << 31), "clock_cache max_size is limited to 2^31 entries");
+		}
+
+		void put(Key key, Value value)
+		{
+			const u32 hash = static_cast<u32>(detail::key_hash(key));
+
+			if (const u64 pos = find_slot(key, hash); pos != no_slot)
+			{
+				entry& e      = m_entries[m_index.index_at(pos)];
+				e.item.second = std::move(value);
+				e.referenced  = true;
+				return;
+			}
+
+			u32 index = npos;
+			if (m_size == max_size)
+			{
+				index                 = evict();
+				m_entries[index].item = {std::move(key), std::move(value)};
+			}
+			else
+			{
+				m_index.reserve(m_size + 1);
+				if (m_free != npos)
+				{
+					index                 = m_free;
+					m_free                = m_entries[index].next_free;
+					m_entries[index].item = {std::move(key), std::move(value)};
+				}
+				else
+				{
+					index = static_cast<u32>(m_entries.size());
+					m_entries.push_back({.item = {std::move(key), std::move(value)}});
+				}
+				++m_size;
+			}
+
+			entry& e     = m_entries[index];
+			e.hash       = hash;
+			e.referenced = false;
+			e.occupied   = true;
+			m_index.insert(index, hash);
+		}
+
+		// Marks key as referenced. nullptr when missing, valid until the next put, erase or clear.
+		[[nodiscard]] Value* get(const Key& key)
+		{
+			const u64 pos = find_slot(key, static_cast<u32>(detail::key_hash(key)));
+			if (pos == no_slot)
+				return nullptr;
+
+			entry& e     = m_entries[m_index.index_at(pos)];
+			e.referenced = true;
+			return &e.item.second;
+		}
+
+		[[nodiscard]] const Value* peek(const Key& key) const
+		{
+			const u64 pos = find_slot(key, static_cast<u32>(detail::key_hash(key)));
+			return pos != no_slot ? &m_entries[m_index.index_at(pos)].item.second : nullptr;
+		}
+
+		bool erase(const Key& key)
+		{
+			const u64 pos = find_slot(key, static_cast<u32>(detail::key_hash(key)));
+			if (pos == no_slot)
+				return false;
+
+			const u32 index = m_index.index_at(pos);
+			m_index.remove(pos);
+
+			entry& e = m_entries[index];
+			if constexpr (std::is_default_constructible_v<Value>)
+				e.item.second = Value{};
+			e.occupied  = false;
+			e.next_free = m_free;
+			m_free      = index;
+			--m_size;
+			return true;
+		}
+
+		[[nodiscard]] bool exists(const Key& key) const { return find_slot(key, static_cast<u32>(detail::key_hash(key))) != no_slot; }
+
+		void clear()
+		{
+			m_entries.clear();
+			m_index.clear();
+			m_size = 0;
+			m_hand = 0;
+			m_free = npos;
+		}
+
+		[[nodiscard]] u64 size() const { return m_size; }
+
+		[[nodiscard]] u64 capacity() const { return max_size; }
+	};
+
+	// W-TinyLFU (Einziger et al.): a 1% LRU window takes every new key, the rest is a segmented
+	// LRU of probation (20%) and protected (80%). A key leaving the window only enters probation
+	// when the sketch counts it more often than the probation entry it would evict. A hit in
+	// probation promotes to protected, protected overflow is demoted back to probation.
+	export template<typename Key, typename Value>
+	class tinylfu_cache
+	{
+	private:
+		lru_cache<Key, Value> m_window;
+		lru_cache<Key, Value> m_probation;
+		lru_cache<Key, Value> m_protected;
+		count_min_sketch      m_sketch;
+		u64                   m_main_size{0};
+		u64                   max_size;
+
+		// Window overflow, candidate competes with the probation victim for a main slot
+		void admit(std::pair<Key, Value> candidate)
+		{
+			const u64 hash = detail::key_hash(candidate.first);
+
+			if (m_probation.size() + m_protected.size() < m_main_size)
+			{
+				m_probation.put(std::move(candidate.first), std::move(candidate.second), hash);
+				return;
+			}
+
+			auto&       victims = m_probation.size() > 0 ? m_probation : m_protected;
+			const auto* victim  = victims.lru();
+
+			if (m_sketch.frequency(detail::sketch_hash(candidate.first)) <= m_sketch.frequency(detail::sketch_hash(victim->first)))
+				return;
+
+			(void)victims.pop_lru();
+			m_probation.put(std::move(candidate.first), std::move(candidate.second), hash);
+		}
+
+		[[nodiscard]] Value* find(const Key& key, u64 hash)
+		{
+			if (Value* value = m_window.get(key, hash))
+				return value;
+			if (Value* value = m_protected.get(key, hash))
+				return value;
+
+			// a probation hit is promoted to protected
+			Value* value = m_probation.get(key, hash);
+			if (value == nullptr)
+				return nullptr;
+
+			Value moved = std::move(*value);
+			m_probation.erase(key, hash);
+
+			if (m_protected.size() == m_protected.capacity())
+			{
+				auto demoted = m_protected.pop_lru();
+				m_probation.put(std::move(demoted->first), std::move(demoted->second));
+			}
+
+			m_protected.put(key, std::move(moved), hash);
+			return m_protected.get(key, hash);
+		}
+
+		[[nodiscard]] static u64 window_size(u64 max_size) { return std::max<u64>(1, max_size / 100); }
+
+	public:
+		explicit tinylfu_cache(u64 max_size, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+			: m_window(window_size(max_size), resource)
+			, m_probation(std::max<u64>(1, max_size - window_size(max_size)), resource)
+			, m_protected(std::max<u64>(1, (max_size - window_size(max_size)) * 4 / 5), resource)
+			, m_sketch(max_size)
+			, m_main_size(max_size - window_size(max_size))
+			, max_size{max_size}
+		{
+			assert::check(max_size >= 2, "tinylfu_cache max_size must be at least 2");
+		}
+
+		void put(Key key, Value value)
+		{
+			const u64 hash = detail::key_hash(key);
+			m_sketch.increment(detail::sketch_hash(key));
+
+			if (Value* existing = find(key, hash))
+			{
+				*existing = std::move(value);
+				return;
+			}
+
+			if (m_window.size() == m_window.capacity())
+				admit(*m_window.pop_lru());
+			m_window.put(std::move(key), std::move(value), hash);
+		}
+
+		// Counts the access. nullptr when missing, valid until the next put, get, erase or clear
+		// since a hit may move the entry between segments.
+		[[nodiscard]] Value* get(const Key& key)
+		{
+			m_sketch.increment(detail::sketch_hash(key));
+			return find(key, detail::key_hash(key));
+		}
+
+		[[nodiscard]] const Value* peek(const Key& key) const
+		{
+			const u64 hash = detail::key_hash(key);
+
+			if (const Value* value = m_window.peek(key, hash))
+				return value;
+			if (const Value* value = m_protected.peek(key, hash))
+				return value;
+			return m_probation.peek(key, hash);
+		}
+
+		bool erase(const Key& key)
+		{
+			const u64 hash = detail::key_hash(key);
+			return m_window.erase(key, hash) or m_protected.erase(key, hash) or m_probation.erase(key, hash);
+		}
+
+		[[nodiscard]] bool exists(const Key& key) const
+		{
+			const u64 hash = detail::key_hash(key);
+			return m_window.exists(key, hash) or m_protected.exists(key, hash) or m_probation.exists(key, hash);
+		}
+
+		void clear()
+		{
+			m_window.clear();
+			m_probation.clear();
+			m_protected.clear();
+			m_sketch.clear();
+		}
+
+		[[nodiscard]] u64 size() const { return m_window.size() + m_probation.size() + m_protected.size(); }
+
+		[[nodiscard]] u64 capacity() const { return max_size; }
+	};
+
+	// Trace replay for choosing a policy: every key is a get, a miss puts make_value(key)
+	export struct replay_result
+	{
+		u64                      hits{0};
+		u64                      misses{0};
+		std::chrono::nanoseconds elapsed{0};
+
+		[[nodiscard]] f64 hit_ratio() const noexcept
+		{
+			const u64 total = hits + misses;
+			return total > 0 ? static_cast<f64>(hits) / static_cast<f64>(total) : 0.0;
+		}
+
+		[[nodiscard]] f64 ops_per_second() const noexcept
+		{
+			const f64 seconds = std::chrono::duration<f64>(elapsed).count();
+			return seconds > 0.0 ? static_cast<f64>(hits + misses) / seconds : 0.0;
+		}
+	};
+
+	export template<typename Cache, typename Key, typename MakeValue>
+	[[nodiscard]] replay_result replay(Cache& cache, std::span<const Key> trace, MakeValue&& make_value)
+	{
+		replay_result result;
+
+		const auto start = std::chrono::steady_clock::now();
+		for (const Key& key : trace)
+		{
+			if (cache.get(key) != nullptr)
+			{
+				++result.hits;
+				continue;
+			}
+
+			++result.misses;
+			cache.put(key, make_value(key));
+		}
+		result.elapsed = std::chrono::steady_clock::now() - start;
+		return result;
+	}
+
+	export template<typename Cache, typename Key>
+	[[nodiscard]] replay_result replay(Cache& cache, std::span<const Key> trace)
+	{
+		using value_type = std::remove_pointer_t<decltype(cache.get(std::declval<const Key&>()))>;
+
+		return replay(cache, trace, [](const Key&) { return value_type{}; });
+	}
+
+} // namespace deckard
@@ -68,7 +68,7 @@ namespace deckard::cpuid
 		Vendor vendor{Vendor::Unknown};
 	};
 
-	enum class Feature : u32
+	export enum class Feature : u32
 	{
 		MMX = 0,
 
@@ -82,6 +82,7 @@ namespace deckard::cpuid
 		AVX,
 		AVX2,
 		AVX512,
+		OSXSAVE,
 
 		SHA,
 		AES,
@@ -110,6 +111,7 @@ namespace deckard::cpuid
 	  {"AVX", 1, cpu_register::ecx, 28},
 	  {"AVX2", 7, cpu_register::ebx, 5},
 	  {"AVX512", 7, cpu_register::ebx, 16},
+	  {"OSXSAVE", 1, cpu_register::ecx, 27},
 
 	  {"SHA", 7, cpu_register::ebx, 29},
 	  {"AES", 1, cpu_register::ecx, 25},
@@ -407,6 +409,33 @@ namespace deckard::cpuid
 		const u32& EDX() const { return regs[3]; }
 	};
 
+	// The CPU bit alone is not enough, the OS must also save the wider registers (XCR0)
+	bool os_saves_state(u64 xcr0_bits)
+	{
+		if (not CPUID().has(Feature::OSXSAVE))
+			return false;
+		return (_xgetbv(0) & xcr0_bits) == xcr0_bits;
+	}
+
+	export [[nodiscard]] bool has_avx2()
+	{
+		static const bool usable = CPUID().has(Feature::AVX2) and os_saves_state(0b110); // xmm, ymm
+		return usable;
+	}
+
+	export [[nodiscard]] bool has_avx512()
+	{
+		static const bool usable = CPUID().has(Feature::AVX512) and os_saves_state(0b1110'0110); // + opmask, zmm
+		return usable;
+	}
+
+	// SHA extensions, the kernels also shuffle bytes with SSSE3/SSE4.1
+	export [[nodiscard]] bool has_sha_ni()
+	{
+		static const bool usable = CPUID().has(Feature::SHA) and CPUID().has(Feature::SSE41);
+		return usable;
+	}
+
 	u64 fenced_rdtsc()
 	{
 		_mm_mfence();
@@ -0,0 +1,884 @@
+module;
+#if defined(_M_X64) or defined(_M_IX86) or defined(__SSE2__)
+#include <immintrin.h>
+#define DECKARD_FLAT_MAP_SSE2
+#endif
+
+export module deckard.flat_map;
+
+import std;
+import deckard.types;
+import deckard.assert;
+import deckard.utils.hash;
+
+namespace deckard
+{
+	/* Usage:
+
+		flat_map<std::string, u32> ids;
+		ids["alpha"] = 1;
+		ids.try_emplace("beta", 2);
+
+		if (auto it = ids.find(std::string_view("alpha")); it != ids.end()) // no std::string built
+			use(it->second);
+
+		flat_set<u64> seen(&arena_resource);
+		if (seen.insert(hash).second)
+			visit(hash);
+
+	 Swiss table: entries sit in one slot array next to an array of control bytes, one byte per
+	 slot holding 7 bits of the hash or an empty/deleted marker. A lookup compares 16 control
+	 bytes at once and only touches the slots whose byte matches, so most misses never read a key.
+
+	 Entries are stored as std::pair<Key, T> so rehashing can move them, do not modify keys
+	 through iterators. Iteration order is unspecified and insertion may rehash, which
+	 invalidates iterators and references. Erase invalidates only the erased entry.
+	*/
+
+	// Default hasher. Keys with unique object representations are rapidhashed as bytes, strings
+	// hash their characters so std::string keys accept std::string_view and const char* lookups.
+	export template<typename Key>
+	struct flat_hash
+	{
+		[[nodiscard]] u64 operator()(const Key& key) const noexcept
+		{
+			if constexpr (std::has_unique_object_representations_v<Key>)
+				return utils::rapidhash(&key, sizeof(Key));
+			else
+			{
+				const u64 h = static_cast<u64>(std::hash<Key>{}(key));
+				return utils::rapidhash(&h, sizeof(h));
+			}
+		}
+	};
+
+	export template<typename Key>
+		requires std::is_convertible_v<const Key&, std::string_view>
+	struct flat_hash<Key>
+	{
+		using is_transparent = void;
+
+		[[nodiscard]] u64 operator()(std::string_view key) const noexcept { return utils::rapidhash(key); }
+	};
+
+	namespace detail
+	{
+		using ctrl_t = i8;
+
+		// Full slots hold the low 7 bits of the hash, so every marker is negative
+		constexpr ctrl_t ctrl_empty   = -128;
+		constexpr ctrl_t ctrl_deleted = -2;
+
+		// 16 control bytes, matches come back as a bitmask with bit i for byte i
+		struct group
+		{
+			static constexpr u32 width = 16;
+
+#ifdef DECKARD_FLAT_MAP_SSE2
+			__m128i ctrl;
+
+			explicit group(const ctrl_t* pos) noexcept
+				: ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pos)))
+			{
+			}
+
+			[[nodiscard]] u32 match(ctrl_t h2) const noexcept
+			{
+				return static_cast<u32>(_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(h2))));
+			}
+
+			[[nodiscard]] u32 match_empty() const noexcept { return match(ctrl_empty); }
+
+			// empty and deleted are the only bytes below -1
+			[[nodiscard]] u32 match_free() const noexcept
+			{
+				return static_cast<u32>(_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(-1), ctrl)));
+			}
+#else
+			std::array<ctrl_t, width> ctrl;
+
+			explicit group(const ctrl_t* pos) noexcept { std::memcpy(ctrl.data(), pos, width); }
+
+			template<typename Pred>
+			[[nodiscard]] u32 mask_of(Pred&& pred) const noexcept
+			{
+				u32 mask = 0;
+				for (u32 i = 0; i < width; ++i)
+					mask |= static_cast<u32>(pred(ctrl[i])) << i;
+				return mask;
+			}
+
+			[[nodiscard]] u32 match(ctrl_t h2) const noexcept
+			{
+				return mask_of([h2](ctrl_t c) { return c == h2; });
+			}
+
+			[[nodiscard]] u32 match_empty() const noexcept { return match(ctrl_empty); }
+
+			[[nodiscard]] u32 match_free() const noexcept
+			{
+				return mask_of([](ctrl_t c) { return c < -1; });
+			}
+#endif
+		};
+
+		template<typename Hash, typename Equal, typename K>
+		concept transparent_key = requires {
+			typename Hash::is_transparent;
+			typename Equal::is_transparent;
+		} and std::is_invocable_v<const Hash&, const K&>;
+
+	} // namespace detail
+
+	// Shared implementation of flat_map (Mapped is the value type) and flat_set (Mapped is void)
+	export template<typename Key, typename Mapped, typename Hash = flat_hash<Key>, typename Equal = std::equal_to<>>
+	class flat_hash_table
+	{
+	private:
+		static constexpr bool is_set = std::is_void_v<Mapped>;
+
+	public:
+		using key_type       = Key;
+		using mapped_type    = Mapped;
+		using value_type     = std::conditional_t<is_set, Key, std::pair<Key, Mapped>>;
+		using hasher         = Hash;
+		using key_equal      = Equal;
+		using allocator_type = std::pmr::polymorphic_allocator<value_type>;
+
+	private:
+		using ctrl_t = detail::ctrl_t;
+		using group  = detail::group;
+
+		static constexpr u64 npos = std::numeric_limits<u64>::max();
+
+		template<typename K>
+		static constexpr bool transparent = detail::transparent_key<Hash, Equal, K>;
+
+		value_type*    m_slots{nullptr};
+		ctrl_t*        m_ctrl{nullptr}; // m_capacity bytes, then a copy of the first group for wrapping loads
+		u64            m_capacity{0};
+		u64            m_size{0};
+		u64            m_growth_left{0};
+		Hash           m_hash;
+		Equal          m_equal;
+		allocator_type m_alloc;
+
+		[[nodiscard]] static const Key& key_of(const value_type& value) noexcept
+		{
+			if constexpr (is_set)
+				return value;
+			else
+				return value.first;
+		}
+
+		// Top bits pick the probe start, the low 7 bits go in the control byte
+		[[nodiscard]] static u64 h1(u64 hash) noexcept { return hash >> 7; }
+
+		[[nodiscard]] static ctrl_t h2(u64 hash) noexcept { return static_cast<ctrl_t>(hash & 0x7F); }
+
+		// Maximum load is 7/8
+		[[nodiscard]] static u64 growth_for(u64 capacity) noexcept { return capacity - capacity / 8; }
+
+		[[nodiscard]] u64 mask() const noexcept { return m_capacity - 1; }
+
+		void set_ctrl(u64 index, ctrl_t c) noexcept
+		{
+			m_ctrl[index] = c;
+			if (index < group::width)
+				m_ctrl[m_capacity + index] = c;
+		}
+
+		// Triangular probing over groups, visits every group once when the capacity is a power of two
+		template<typename K>
+		[[nodiscard]] u64 find_index(const K& key, u64 hash) const
+		{
+			if (m_capacity == 0)
+				return npos;
+
+			const ctrl_t tag  = h2(hash);
+			u64          pos  = h1(hash) & mask();
+			u64          step = 0;
+
+			while (true)
+			{
+				const group g(m_ctrl + pos);
+				for (u32 bits = g.match(tag); bits != 0; bits &= bits - 1)
+				{
+					const u64 index = (pos + std::countr_zero(bits)) & mask();
+					if (m_equal(key_of(m_slots[index]), key)) [[likely]]
+						return index;
+				}
+
+				if (g.match_empty() != 0)
+					return npos;
+
+				step += group::width;
+				pos = (pos + step) & mask();
+			}
+		}
+
+		// First empty or deleted slot on the probe sequence, the table always has one
+		[[nodiscard]] u64 find_free(u64 hash) const noexcept
+		{
+			u64 pos  = h1(hash) & mask();
+			u64 step = 0;
+
+			while (true)
+			{
+				if (const u32 bits = group(m_ctrl + pos).match_free(); bits != 0)
+					return (pos + std::countr_zero(bits)) & mask();
+
+				step += group::width;
+				pos = (pos + step) & mask();
+			}
+		}
+
+		void allocate(u64 capacity)
+		{
+			const u64 slot_bytes = capacity * sizeof(value_type);
+			std::byte* memory    = static_cast<std::byte*>(m_alloc.allocate_bytes(slot_bytes + capacity + group::width, alignof(value_type)));
+
+			m_slots       = reinterpret_cast<value_type*>(memory);
+			m_ctrl        = reinterpret_cast<ctrl_t*>(memory + slot_bytes);
+			m_capacity    = capacity;
+			m_growth_left = growth_for(capacity) - m_size;
+			std::memset(m_ctrl, static_cast<u8>(detail::ctrl_empty), capacity + group::width);
+		}
+
+		void deallocate() noexcept
+		{
+			if (m_capacity == 0)
+				return;
+
+			m_alloc.deallocate_bytes(m_slots, m_capacity * sizeof(value_type) + m_capacity + group::width, alignof(value_type));
+			m_slots    = nullptr;
+			m_ctrl     = nullptr;
+			m_capacity = 0;
+		}
+
+		void destroy_all() noexcept
+		{
+			if constexpr (not std::is_trivially_destructible_v<value_type>)
+			{
+				for (u64 i = 0; i < m_capacity; ++i)
+					if (m_ctrl[i] >= 0)
+						std::destroy_at(m_slots + i);
+			}
+		}
+
+		// Also drops every deleted marker
+		void rehash_to(u64 capacity)
+		{
+			value_type* old_slots    = m_slots;
+			ctrl_t*     old_ctrl     = m_ctrl;
+			const u64   old_capacity = m_capacity;
+
+			allocate(capacity);
+
+			for (u64 i = 0; i < old_capacity; ++i)
+			{
+				if (old_ctrl[i] < 0)
+					continue;
+
+				const u64 hash  = m_hash(key_of(old_slots[i]));
+				const u64 index = find_free(hash);
+				std::allocator_traits<allocator_type>::construct(m_alloc, m_slots + index, std::move(old_slots[i]));
+				std::destroy_at(old_slots + i);
+				set_ctrl(index, h2(hash));
+			}
+
+			if (old_capacity > 0)
+				m_alloc.deallocate_bytes(old_slots, old_capacity * sizeof(value_type) + old_capacity + group::width, alignof(value_type));
+		}
+
+		// Slot for a new key, grows first when taking an empty slot would pass the load limit
+		[[nodiscard]] u64 prepare_insert(u64 hash)
+		{
+			if (m_capacity == 0)
+				rehash_to(group::width);
+
+			u64 index = find_free(hash);
+			if (m_growth_left == 0 and m_ctrl[index] != detail::ctrl_deleted)
+			{
+				// Mostly tombstones, rebuild at the same size instead of doubling
+				rehash_to(m_size <= growth_for(m_capacity) / 2 ? m_capacity : m_capacity * 2);
+				index = find_free(hash);
+			}
+			return index;
+		}
+
+		template<typename... Args>
+		void construct_at(u64 index, u64 hash, Args&&... args)
+		{
+			std::allocator_traits<allocator_type>::construct(m_alloc, m_slots + index, std::forward<Args>(args)...);
+
+			if (m_ctrl[index] == detail::ctrl_empty)
+				--m_growth_left;
+			set_ctrl(index, h2(hash));
+			++m_size;
+		}
+
+		template<typename K, typename... Args>
+		std::pair<u64, bool> emplace_key(K&& key, Args&&... args)
+		{
+			const u64 hash = m_hash(key);
+			if (const u64 found = find_index(key, hash); found != npos)
+				return {found, false};
+
+			const u64 index = prepare_insert(hash);
+			if constexpr (is_set)
+				construct_at(index, hash, std::forward<K>(key));
+			else
+				construct_at(
+				  index, hash, std::piecewise_construct, std::forward_as_tuple(std::forward<K>(key)), std::forward_as_tuple(std::forward<Args>(args)...));
+			return {index, true};
+		}
+
+		void erase_at(u64 index) noexcept
+		{
+			std::destroy_at(m_slots + index);
+			--m_size;
+
+			// The slot can go back to empty only if no probe ever saw a full group through it,
+			// i.e. the empty slots on both sides are less than a group apart
+			const u32  empty_after  = group(m_ctrl + index).match_empty();
+			const u32  empty_before = group(m_ctrl + ((index - group::width) & mask())).match_empty();
+			const bool never_full   = empty_after != 0 and empty_before != 0 and
+									static_cast<u32>(std::countr_zero(empty_after) + std::countl_zero(static_cast<u16>(empty_before))) < group::width;
+
+			if (never_full)
+			{
+				set_ctrl(index, detail::ctrl_empty);
+				++m_growth_left;
+			}
+			else
+				set_ctrl(index, detail::ctrl_deleted);
+		}
+
+		void copy_from(const flat_hash_table& other)
+		{
+			reserve(other.size());
+			for (const value_type& value : other)
+			{
+				const u64 hash = m_hash(key_of(value));
+				construct_at(find_free(hash), hash, value);
+			}
+		}
+
+		// Entry by entry, for tables on different resources
+		void move_from(flat_hash_table& other)
+		{
+			reserve(other.size());
+			for (value_type& value : other)
+			{
+				const u64 hash = m_hash(key_of(value));
+				construct_at(find_free(hash), hash, std::move(value));
+			}
+			other.clear();
+		}
+
+		void steal(flat_hash_table& other) noexcept
+		{
+			m_slots       = std::exchange(other.m_slots, nullptr);
+			m_ctrl        = std::exchange(other.m_ctrl, nullptr);
+			m_capacity    = std::exchange(other.m_capacity, 0);
+			m_size        = std::exchange(other.m_size, 0);
+			m_growth_left = std::exchange(other.m_growth_left, 0);
+		}
+
+	public:
+		template<bool Const>
+		class basic_iterator
+		{
+		private:
+			using slot_pointer = std::conditional_t<Const, const flat_hash_table::value_type*, flat_hash_table::value_type*>;
+
+			const ctrl_t* m_ctrl{nullptr};
+			const ctrl_t* m_end{nullptr};
+			slot_pointer  m_slot{nullptr};
+
+			void skip_free() noexcept
+			{
+				while (m_ctrl != m_end and *m_ctrl < 0)
+				{
+					++m_ctrl;
+					++m_slot;
+				}
+			}
+
+			friend class flat_hash_table;
+
+			basic_iterator(const ctrl_t* ctrl, const ctrl_t* end, slot_pointer slot) noexcept
+				: m_ctrl(ctrl)
+				, m_end(end)
+				, m_slot(slot)
+			{
+			}
+
+		public:
+			using iterator_category = std::forward_iterator_tag;
+			using value_type        = flat_hash_table::value_type;
+			using difference_type   = std::ptrdiff_t;
+			using pointer           = slot_pointer;
+			using reference         = std::conditional_t<Const, const flat_hash_table::value_type&, flat_hash_table::value_type&>;
+
+			basic_iterator() = default;
+
+			template<bool OtherConst>
+				requires(Const and not OtherConst)
+			basic_iterator(const basic_iterator<OtherConst>& other) noexcept
+				: m_ctrl(other.m_ctrl)
+				, m_end(other.m_end)
+				, m_slot(other.m_slot)
+			{
+			}
+
+			reference operator*() const noexcept { return *m_slot; }
+
+			pointer operator->() const noexcept { return m_slot; }
+
+			basic_iterator& operator++() noexcept
+			{
+				++m_ctrl;
+				++m_slot;
+				skip_free();
+				return *this;
+			}
+
+			basic_iterator operator++(int) noexcept
+			{
+				basic_iterator tmp = *this;
+				++*this;
+				return tmp;
+			}
+
+			template<bool OtherConst>
+			bool operator==(const basic_iterator<OtherConst>& other) const noexcept
+			{
+				return m_ctrl == other.m_ctrl;
+			}
+
+			template<bool>
+			friend class basic_iterator;
+		};
+
+		using iterator       = basic_iterator<false>;
+		using const_iterator = basic_iterator<true>;
+
+	private:
+		[[nodiscard]] iterator iterator_at(u64 index) noexcept { return {m_ctrl + index, m_ctrl + m_capacity, m_slots + index}; }
+
+		[[nodiscard]] const_iterator iterator_at(u64 index) const noexcept
+		{
+			return {m_ctrl + index, m_ctrl + m_capacity, m_slots + index};
+		}
+
+	public:
+		flat_hash_table() = default;
+
+		explicit flat_hash_table(const allocator_type& alloc)
+			: m_alloc(alloc)
+		{
+		}
+
+		explicit flat_hash_table(u64 initial_capacity, const allocator_type& alloc = {})
+			: m_alloc(alloc)
+		{
+			reserve(initial_capacity);
+		}
+
+		flat_hash_table(std::initializer_list<value_type> init, const allocator_type& alloc = {})
+			: m_alloc(alloc)
+		{
+			reserve(init.size());
+			for (const value_type& value : init)
+				insert(value);
+		}
+
+		flat_hash_table(const flat_hash_table& other)
+			: m_hash(other.m_hash)
+			, m_equal(other.m_equal)
+			, m_alloc(std::allocator_traits<allocator_type>::select_on_container_copy_construction(other.m_alloc))
+		{
+			copy_from(other);
+		}
+
+		flat_hash_table(flat_hash_table&& other) noexcept
+			: m_hash(std::move(other.m_hash))
+			, m_equal(std::move(other.m_equal))
+			, m_alloc(other.m_alloc)
+		{
+			steal(other);
+		}
+
+		flat_hash_table(const flat_hash_table& other, const allocator_type& alloc)
+			: m_hash(other.m_hash)
+			, m_equal(other.m_equal)
+			, m_alloc(alloc)
+		{
+			copy_from(other);
+		}
+
+		flat_hash_table(flat_hash_table&& other, const allocator_type& alloc)
+			: m_hash(other.m_hash)
+			, m_equal(other.m_equal)
+			, m_alloc(alloc)
+		{
+			if (m_alloc == other.m_alloc)
+				steal(other);
+			else
+				move_from(other);
+		}
+
+		flat_hash_table& operator=(const flat_hash_table& other)
+		{
+			if (this != &other)
+			{
+				clear();
+				m_hash  = other.m_hash;
+				m_equal = other.m_equal;
+				copy_from(other);
+			}
+			return *this;
+		}
+
+		// Different resources cannot share a slot array, the entries are moved one by one
+		flat_hash_table& operator=(flat_hash_table&& other)
+		{
+			if (this == &other)
+				return *this;
+
+			m_hash  = std::move(other.m_hash);
+			m_equal = std::move(other.m_equal);
+
+			if (m_alloc == other.m_alloc)
+			{
+				destroy_all();
+				deallocate();
+				m_size = 0;
+				steal(other);
+			}
+			else
+			{
+				clear();
+				move_from(other);
+			}
+			return *this;
+		}
+
+		~flat_hash_table()
+		{
+			destroy_all();
+			deallocate();
+		}
+
+		// lookup
+
+		[[nodiscard]] iterator find(const Key& key)
+		{
+			const u64 index = find_index(key, m_hash(key));
+			return index != npos ? iterator_at(index) : end();
+		}
+
+		[[nodiscard]] const_iterator find(const Key& key) const
+		{
+			const u64 index = find_index(key, m_hash(key));
+			return index != npos ? iterator_at(index) : end();
+		}
+
+		template<typename K>
+			requires transparent<K>
+		[[nodiscard]] iterator find(const K& key)
+		{
+			const u64 index = find_index(key, m_hash(key));
+			return index != npos ? iterator_at(index) : end();
+		}
+
+		template<typename K>
+			requires transparent<K>
+		[[nodiscard]] const_iterator find(const K& key) const
+		{
+			const u64 index = find_index(key, m_hash(key));
+			return index != npos ? iterator_at(index) : end();
+		}
+
+		[[nodiscard]] bool contains(const Key& key) const { return find_index(key, m_hash(key)) != npos; }
+
+		template<typename K>
+			requires transparent<K>
+		[[nodiscard]] bool contains(const K& key) const
+		{
+			return find_index(key, m_hash(key)) != npos;
+		}
+
+		[[nodiscard]] u64 count(const Key& key) const { return contains(key) ? 1 : 0; }
+
+		template<typename K>
+			requires transparent<K>
+		[[nodiscard]] u64 count(const K& key) const
+		{
+			return contains(key) ? 1 : 0;
+		}
+
+		// map only
+
+		template<typename K, typename... Args>
+			requires(not is_set and (std::same_as<std::remove_cvref_t<K>, Key> or transparent<K>))
+		std::pair<iterator, bool> try_emplace(K&& key, Args&&... args)
+		{
+			const auto [index, inserted] = emplace_key(std::forward<K>(key), std::forward<Args>(args)...);
+			return {iterator_at(index), inserted};
+		}
+
+		template<typename... Args>
+			requires(not is_set)
+		std::pair<iterator, bool> try_emplace(Key&& key, Args&&... args)
+		{
+			const auto [index, inserted] = emplace_key(std::move(key), std::forward<Args>(args)...);
+			return {iterator_at(index), inserted};
+		}
+
+		template<typename... Args>
+			requires(not is_set)
+		std::pair<iterator, bool> try_emplace(const Key& key, Args&&... args)
+		{
+			const auto [index, inserted] = emplace_key(key, std::forward<Args>(args)...);
+			return {iterator_at(index), inserted};
+		}
+
+		template<typename K, typename V>
+			requires(not is_set)
+		std::pair<iterator, bool> emplace(K&& key, V&& value)
+		{
+			return try_emplace(std::forward<K>(key), std::forward<V>(value));
+		}
+
+		template<typename V>
+			requires(not is_set)
+		std::pair<iterator, bool> insert_or_assign(const Key& key, V&& value)
+		{
+			auto result = try_emplace(key, std::forward<V>(value));
+			if (not result.second)
+				result.first->second = std::forward<V>(value);
+			return result;
+		}
+
+		template<typename V>
+			requires(not is_set)
+		std::pair<iterator, bool> insert_or_assign(Key&& key, V&& value)
+		{
+			auto result = try_emplace(std::move(key), std::forward<V>(value));
+			if (not result.second)
+				result.first->second = std::forward<V>(value);
+			return result;
+		}
+
+		template<typename M = Mapped>
+			requires(not is_set)
+		M& operator[](const Key& key)
+		{
+			return try_emplace(key).first->second;
+		}
+
+		template<typename M = Mapped>
+			requires(not is_set)
+		M& operator[](Key&& key)
+		{
+			return try_emplace(std::move(key)).first->second;
+		}
+
+		template<typename M = Mapped>
+			requires(not is_set)
+		[[nodiscard]] M& at(const Key& key)
+		{
+			auto it = find(key);
+			assert::check(it != end(), "flat_map::at, key not found");
+			return it->second;
+		}
+
+		template<typename M = Mapped>
+			requires(not is_set)
+		[[nodiscard]] const M& at(const Key& key) const
+		{
+			auto it = find(key);
+			assert::check(it != end(), "flat_map::at, key not found");
+			return it->second;
+		}
+
+		// insert
+
+		std::pair<iterator, bool> insert(const value_type& value)
+		{
+			if constexpr (is_set)
+				return try_insert_key(value);
+			else
+				return try_emplace(value.first, value.second);
+		}
+
+		std::pair<iterator, bool> insert(value_type&& value)
+		{
+			if constexpr (is_set)
+				return try_insert_key(std::move(value));
+			else
+				return try_emplace(std::move(value.first), std::move(value.second));
+		}
+
+		template<typename... Args>
+			requires is_set
+		std::pair<iterator, bool> emplace(Args&&... args)
+		{
+			return insert(Key(std::forward<Args>(args)...));
+		}
+
+		// erase
+
+		u64 erase(const Key& key)
+		{
+			const u64 index = find_index(key, m_hash(key));
+			if (index == npos)
+				return 0;
+
+			erase_at(index);
+			return 1;
+		}
+
+		template<typename K>
+			requires transparent<K>
+		u64 erase(const K& key)
+		{
+			const u64 index = find_index(key, m_hash(key));
+			if (index == npos)
+				return 0;
+
+			erase_at(index);
+			return 1;
+		}
+
+		iterator erase(const_iterator pos)
+		{
+			const u64 index = static_cast<u64>(pos.m_ctrl - m_ctrl);
+			erase_at(index);
+
+			iterator next = iterator_at(index);
+			next.skip_free();
+			return next;
+		}
+
+		iterator erase(iterator pos) { return erase(const_iterator(pos)); }
+
+		// Keeps the allocation
+		void clear() noexcept
+		{
+			if (m_size == 0 and m_growth_left == growth_for(m_capacity))
+				return;
+
+			destroy_all();
+			m_size = 0;
+			if (m_capacity > 0)
+			{
+				std::memset(m_ctrl, static_cast<u8>(detail::ctrl_empty), m_capacity + group::width);
+				m_growth_left = growth_for(m_capacity);
+			}
+		}
+
+		// Room for count entries without rehashing
+		void reserve(u64 count)
+		{
+			u64 capacity = group::width;
+			while (growth_for(capacity) < count)
+				capacity *= 2;
+
+			if (capacity > m_capacity)
+				rehash_to(capacity);
+		}
+
+		void swap(flat_hash_table& other) noexcept
+		{
+			assert::check(m_alloc == other.m_alloc, "flat_hash_table::swap needs equal allocators");
+
+			std::swap(m_slots, other.m_slots);
+			std::swap(m_ctrl, other.m_ctrl);
+			std::swap(m_capacity, other.m_capacity);
+			std::swap(m_size, other.m_size);
+			std::swap(m_growth_left, other.m_growth_left);
+			std::swap(m_hash, other.m_hash);
+			std::swap(m_equal, other.m_equal);
+		}
+
+		// size
+
+		[[nodiscard]] u64 size() const noexcept { return m_size; }
+
+		[[nodiscard]] bool empty() const noexcept { return m_size == 0; }
+
+		[[nodiscard]] u64 capacity() const noexcept { return m_capacity; }
+
+		[[nodiscard]] f32 load_factor() const noexcept
+		{
+			return m_capacity > 0 ? static_cast<f32>(m_size) / static_cast<f32>(m_capacity) : 0.0f;
+		}
+
+		[[nodiscard]] hasher hash_function() const { return m_hash; }
+
+		[[nodiscard]] key_equal key_eq() const { return m_equal; }
+
+		[[nodiscard]] allocator_type get_allocator() const noexcept { return m_alloc; }
+
+		// iterators, unspecified order
+
+		[[nodiscard]] iterator begin() noexcept
+		{
+			iterator it = iterator_at(0);
+			it.skip_free();
+			return it;
+		}
+
+		[[nodiscard]] iterator end() noexcept { return iterator_at(m_capacity); }
+
+		[[nodiscard]] const_iterator begin() const noexcept
+		{
+			const_iterator it = iterator_at(0);
+			it.skip_free();
+			return it;
+		}
+
+		[[nodiscard]] const_iterator end() const noexcept { return iterator_at(m_capacity); }
+
+		[[nodiscard]] const_iterator cbegin() const noexcept { return begin(); }
+
+		[[nodiscard]] const_iterator cend() const noexcept { return end(); }
+
+	private:
+		template<typename K>
+		std::pair<iterator, bool> try_insert_key(K&& key)
+		{
+			const auto [index, inserted] = emplace_key(std::forward<K>(key));
+			return {iterator_at(index), inserted};
+		}
+	};
+
+	export template<typename Key, typename T, typename Hash = flat_hash<Key>, typename Equal = std::equal_to<>>
+	using flat_map = flat_hash_table<Key, T, Hash, Equal>;
+
+	export template<typename Key, typename Hash = flat_hash<Key>, typename Equal = std::equal_to<>>
+	using flat_set = flat_hash_table<Key, void, Hash, Equal>;
+
+	// Erase every entry matching pred, returns the number erased
+	export template<typename Key, typename Mapped, typename Hash, typename Equal, typename Pred>
+	u64 erase_if(flat_hash_table<Key, Mapped, Hash, Equal>& table, Pred pred)
+	{
+		u64 erased = 0;
+		for (auto it = table.begin(); it != table.end();)
+		{
+			if (pred(*it))
+			{
+				it = table.erase(it);
+				++erased;
+			}
+			else
+				++it;
+		}
+		return erased;
+	}
+
+} // namespace deckard
@@ -10,6 +10,7 @@ import deckard_build;
 
 import deckard.types;
 import deckard.as;
+import deckard.assert;
 import deckard.helpers;
 import deckard.debug;
 import std;
@@ -364,6 +365,149 @@ namespace deckard::utils
 
 	export u64 rapidhash(std::span<const u8> buffer) { return rapidhash(buffer.data(), buffer.size_bytes(), RAPID_SEED); }
 
+	// Incremental rapidhash, finalize() matches rapidhash() over everything passed to update().
+	// rapidhash mixes the total length into the seed before the first block, so it must be known up front.
+	export class rapidhash_hasher
+	{
+		std::array<u8, 48> buffer_{};
+		std::array<u8, 16> last_{}; // end of the last processed block, the final reads may reach back into it
+		u64                seed_{0};
+		u64                see1_{0};
+		u64                see2_{0};
+		u64                initial_seed_{0};
+		u64                length_{0};
+		u64                total_len_{0};
+		size_t             buffer_size_{0};
+
+	public:
+		explicit rapidhash_hasher(u64 length, u64 seed = RAPID_SEED) noexcept
+			: initial_seed_(seed)
+			, length_(length)
+		{
+			reset();
+		}
+
+		void update(std::span<const u8> data) noexcept
+		{
+			const u8* ptr = data.data();
+			size_t    len = data.size();
+			total_len_ += len;
+
+			if (len == 0)
+				return;
+
+			// A full block is only processed once more input follows, exactly 48 bytes takes the short path
+			if (buffer_size_ > 0 or len <= buffer_.size())
+			{
+				const size_t to_copy = std::min(buffer_.size() - buffer_size_, len);
+				std::copy_n(ptr, to_copy, buffer_.data() + buffer_size_);
+				buffer_size_ += to_copy;
+				ptr += to_copy;
+				len -= to_copy;
+
+				if (len == 0)
+					return;
+
+				process_block(buffer_.data(), seed_, see1_, see2_, last_);
+				buffer_size_ = 0;
+			}
+
+			while (len > buffer_.size())
+			{
+				process_block(ptr, seed_, see1_, see2_, last_);
+				ptr += buffer_.size();
+				len -= buffer_.size();
+			}
+
+			std::copy_n(ptr, len, buffer_.data());
+			buffer_size_ = len;
+		}
+
+		void update(std::string_view data) noexcept { update(std::span<const u8>{as<const u8*>(data.data()), data.size()}); }
+
+		[[nodiscard]] u64 finalize() const noexcept
+		{
+			assert::check(total_len_ == length_, "rapidhash_hasher: input length differs from the constructed length");
+
+			std::array<u8, 64> tail{};
+			std::copy_n(last_.data(), last_.size(), tail.data());
+			std::copy_n(buffer_.data(), buffer_size_, tail.data() + last_.size());
+
+			const u8* p    = tail.data() + last_.size();
+			size_t    i    = buffer_size_;
+			u64       seed = seed_;
+			u64       a{}, b{};
+
+			if (total_len_ <= 16)
+			{
+				if (i >= 4)
+				{
+					const u8* plast = p + i - 4;
+					a               = (rapid_read32(p) << 32) | rapid_read32(plast);
+					const u64 delta = ((i & 24) >> (i >> 3));
+					b               = ((rapid_read32(p + delta) << 32) | rapid_read32(plast - delta));
+				}
+				else if (i > 0)
+				{
+					a = rapid_readsmall(p, i);
+					b = 0;
+				}
+			}
+			else
+			{
+				if (total_len_ > 48)
+				{
+					u64 see1 = see1_, see2 = see2_;
+					if (i == buffer_.size())
+					{
+						std::array<u8, 16> unused{};
+						process_block(p, seed, see1, see2, unused);
+						p += i;
+						i = 0;
+					}
+					seed ^= see1 ^ see2;
+				}
+				if (i > 16)
+				{
+					seed = rapid_mix(rapid_read64(p) ^ rapid_secret[2], rapid_read64(p + 8) ^ seed ^ rapid_secret[1]);
+					if (i > 32)
+						seed = rapid_mix(rapid_read64(p + 16) ^ rapid_secret[2], rapid_read64(p + 24) ^ seed);
+				}
+				a = rapid_read64(p + i - 16);
+				b = rapid_read64(p + i - 8);
+			}
+
+			a ^= rapid_secret[1];
+			b ^= seed;
+			rapid_mum(&a, &b);
+			return rapid_mix(a ^ rapid_secret[0] ^ total_len_, b ^ rapid_secret[1]);
+		}
+
+		void reset() noexcept
+		{
+			seed_        = initial_seed_ ^ rapid_mix(initial_seed_ ^ rapid_secret[0], rapid_secret[1]) ^ length_;
+			see1_        = seed_;
+			see2_        = seed_;
+			total_len_   = 0;
+			buffer_size_ = 0;
+		}
+
+		void reset(u64 length) noexcept
+		{
+			length_ = length;
+			reset();
+		}
+
+	private:
+		static void process_block(const u8* p, u64& seed, u64& see1, u64& see2, std::array<u8, 16>& last) noexcept
+		{
+			seed = rapid_mix(rapid_read64(p) ^ rapid_secret[0], rapid_read64(p + 8) ^ seed);
+			see1 = rapid_mix(rapid_read64(p + 16) ^ rapid_secret[1], rapid_read64(p + 24) ^ see1);
+			see2 = rapid_mix(rapid_read64(p + 32) ^ rapid_secret[2], rapid_read64(p + 40) ^ see2);
+			std::copy_n(p + 32, last.size(), last.data());
+		}
+	};
+
 	// ########################################################################
 	// Chibihash - https://nrk.neocities.org/articles/chibihash
 	constexpr u64 CHIBI_SEED = 0x1918'05f9'ed90'9da0;
@@ -458,6 +602,136 @@ namespace deckard::utils
 
 	export u64 operator""_chibihash(char const* buffer, size_t len) { return chibihash64({buffer, len}); }
 
+	// Incremental chibihash64, finalize() matches chibihash64() over everything passed to update()
+	export class chibihash_hasher
+	{
+		static constexpr u64 K = 0x2B7E'1516'28AE'D2A7ULL;
+
+		std::array<u64, 4> h_{};
+		std::array<u8, 32> buffer_{};
+		u64                seed_{CHIBI_SEED};
+		u64                total_len_{0};
+		size_t             buffer_size_{0};
+
+	public:
+		explicit chibihash_hasher(u64 seed = CHIBI_SEED) noexcept
+			: seed_(seed)
+		{
+			reset();
+		}
+
+		void update(std::span<const u8> data) noexcept
+		{
+			const u8* ptr = data.data();
+			size_t    len = data.size();
+			total_len_ += len;
+
+			if (buffer_size_ > 0)
+			{
+				const size_t to_copy = std::min(buffer_.size() - buffer_size_, len);
+				std::copy_n(ptr, to_copy, buffer_.data() + buffer_size_);
+				buffer_size_ += to_copy;
+				ptr += to_copy;
+				len -= to_copy;
+
+				if (buffer_size_ < buffer_.size())
+					return;
+
+				u64 h0 = h_[0], h1 = h_[1], h2 = h_[2], h3 = h_[3];
+				process_stripes(buffer_.data(), h0, h1, h2, h3);
+				h_           = {h0, h1, h2, h3};
+				buffer_size_ = 0;
+			}
+
+			if (len >= buffer_.size())
+			{
+				u64 h0 = h_[0], h1 = h_[1], h2 = h_[2], h3 = h_[3];
+				do
+				{
+					process_stripes(ptr, h0, h1, h2, h3);
+					ptr += buffer_.size();
+					len -= buffer_.size();
+				} while (len >= buffer_.size());
+				h_ = {h0, h1, h2, h3};
+			}
+
+			std::copy_n(ptr, len, buffer_.data());
+			buffer_size_ = len;
+		}
+
+		void update(std::string_view data) noexcept { update(std::span<const u8>{as<const u8*>(data.data()), data.size()}); }
+
+		[[nodiscard]] u64 finalize() const noexcept
+		{
+			std::array<u64, 4> h = h_;
+			const u8*          p = buffer_.data();
+			size_t             l = buffer_size_;
+
+			for (; l >= 8; l -= 8, p += 8)
+			{
+				h[0] ^= chibihash64__load32le(p + 0);
+				h[0] *= K;
+				h[1] ^= chibihash64__load32le(p + 4);
+				h[1] *= K;
+			}
+
+			if (l >= 4)
+			{
+				h[2] ^= chibihash64__load32le(p);
+				h[3] ^= chibihash64__load32le(p + l - 4);
+			}
+			else if (l > 0)
+			{
+				h[2] ^= p[0];
+				h[3] ^= p[l / 2] | ((u64)p[l - 1] << 8);
+			}
+
+			h[0] += chibihash64__rotl(h[2] * K, 31) ^ (h[2] >> 31);
+			h[1] += chibihash64__rotl(h[3] * K, 31) ^ (h[3] >> 31);
+			h[0] *= K;
+			h[0] ^= h[0] >> 31;
+			h[1] += h[0];
+
+			u64 x = total_len_ * K;
+			x ^= chibihash64__rotl(x, 29);
+			x += seed_;
+			x ^= h[1];
+
+			x ^= chibihash64__rotl(x, 15) ^ chibihash64__rotl(x, 42);
+			x *= K;
+			x ^= chibihash64__rotl(x, 13) ^ chibihash64__rotl(x, 31);
+
+			return x;
+		}
+
+		void reset() noexcept
+		{
+			const u64 seed2 = chibihash64__rotl(seed_ - K, 15) + chibihash64__rotl(seed_ - K, 47);
+			h_              = {seed_, seed_ + K, seed2, seed2 + (K * K ^ K)};
+			total_len_      = 0;
+			buffer_size_    = 0;
+		}
+
+	private:
+		// Lanes by reference so the bulk loop keeps them in registers
+		static void process_stripes(const u8* p, u64& h0, u64& h1, u64& h2, u64& h3) noexcept
+		{
+			const u64 s0 = chibihash64__load64le(p + 0);
+			const u64 s1 = chibihash64__load64le(p + 8);
+			const u64 s2 = chibihash64__load64le(p + 16);
+			const u64 s3 = chibihash64__load64le(p + 24);
+
+			h0 = (s0 + h0) * K;
+			h1 += chibihash64__rotl(s0, 27);
+			h1 = (s1 + h1) * K;
+			h2 += chibihash64__rotl(s1, 27);
+			h2 = (s2 + h2) * K;
+			h3 += chibihash64__rotl(s2, 27);
+			h3 = (s3 + h3) * K;
+			h0 += chibihash64__rotl(s3, 27);
+		}
+	};
+
 	// ########################################################
 
 	export u64 xxh64(std::span<const u8> buffer, u64 seed = 0)
@@ -690,6 +964,8 @@ namespace deckard::utils
 			return hash;
 		}
 
+		[[nodiscard]] u64 finalize() const noexcept { return digest(); }
+
 		void reset() noexcept
 		{
 			state_       = {prime1 + prime2, prime2, 0, static_cast<u64>(-static_cast<i64>(prime1))};
@@ -885,6 +1161,142 @@ namespace deckard::utils
 		return wyhash(to_span(str), seed, secret);
 	}
 
+	// Incremental wyhash, finalize() matches wyhash() over everything passed to update()
+	export class wyhash_hasher
+	{
+		std::array<u64, 4> secret_{};
+		std::array<u8, 48> buffer_{};
+		std::array<u8, 16> last_{}; // end of the last processed block, the final reads may reach back into it
+		u64                seed_{0};
+		u64                see1_{0};
+		u64                see2_{0};
+		u64                initial_seed_{0};
+		u64                total_len_{0};
+		size_t             buffer_size_{0};
+
+	public:
+		explicit wyhash_hasher(u64 seed = 0, const std::array<u64, 4>& secret = default_secret) noexcept
+			: secret_(secret)
+			, initial_seed_(seed)
+		{
+			reset();
+		}
+
+		void update(std::span<const u8> data) noexcept
+		{
+			const u8* ptr = data.data();
+			size_t    len = data.size();
+			total_len_ += len;
+
+			if (buffer_size_ > 0)
+			{
+				const size_t to_copy = std::min(buffer_.size() - buffer_size_, len);
+				std::copy_n(ptr, to_copy, buffer_.data() + buffer_size_);
+				buffer_size_ += to_copy;
+				ptr += to_copy;
+				len -= to_copy;
+
+				if (buffer_size_ < buffer_.size())
+					return;
+
+				process_block(buffer_.data());
+				buffer_size_ = 0;
+			}
+
+			while (len >= buffer_.size())
+			{
+				process_block(ptr);
+				ptr += buffer_.size();
+				len -= buffer_.size();
+			}
+
+			std::copy_n(ptr, len, buffer_.data());
+			buffer_size_ = len;
+		}
+
+		void update(std::string_view data) noexcept { update(to_span(data)); }
+
+		[[nodiscard]] u64 finalize() const noexcept
+		{
+			using namespace wyhash_detail;
+
+			std::array<u8, 64> tail{};
+			std::copy_n(last_.data(), last_.size(), tail.data());
+			std::copy_n(buffer_.data(), buffer_size_, tail.data() + last_.size());
+
+			const u8* p    = tail.data() + last_.size();
+			size_t    i    = buffer_size_;
+			u64       seed = seed_;
+			u64       a{}, b{};
+
+			if (total_len_ <= 16)
+			{
+				if (i >= 4)
+				{
+					a = (read_u32(p) << 32) | read_u32(p + ((i >> 3) << 2));
+					b = (read_u32(p + i - 4) << 32) | read_u32(p + i - 4 - ((i >> 3) << 2));
+				}
+				else if (i > 0)
+					a = read_short(p, i);
+			}
+			else
+			{
+				if (total_len_ >= 48)
+					seed ^= see1_ ^ see2_;
+
+				while (i > 16)
+				{
+					seed = mix(read_u64(p) ^ secret_[1], read_u64(p + 8) ^ seed);
+					i -= 16;
+					p += 16;
+				}
+				a = read_u64(p + i - 16);
+				b = read_u64(p + i - 8);
+			}
+
+			a ^= secret_[1];
+			b ^= seed;
+
+			const auto [ha, hb] = mul128(a, b);
+			return mix(ha ^ secret_[0] ^ total_len_, hb ^ secret_[1]);
+		}
+
+		void reset() noexcept
+		{
+			seed_        = initial_seed_ ^ wyhash_detail::mix(initial_seed_ ^ secret_[0], secret_[1]);
+			see1_        = seed_;
+			see2_        = seed_;
+			total_len_   = 0;
+			buffer_size_ = 0;
+		}
+
+	private:
+		void process_block(const u8* p) noexcept
+		{
+			using namespace wyhash_detail;
+
+			seed_ = mix(read_u64(p) ^ secret_[1], read_u64(p + 8) ^ seed_);
+			see1_ = mix(read_u64(p + 16) ^ secret_[2], read_u64(p + 24) ^ see1_);
+			see2_ = mix(read_u64(p + 32) ^ secret_[3], read_u64(p + 40) ^ see2_);
+			std::copy_n(p + 32, last_.size(), last_.data());
+		}
+	};
+
+	// ########################################################
+	// Streaming hashers share update(bytes) / finalize() / reset()
+
+	export template<typename T>
+	concept streaming_hasher = requires(T hasher, const T& const_hasher, std::span<const u8> data) {
+		hasher.update(data);
+		{ const_hasher.finalize() } -> std::same_as<u64>;
+		hasher.reset();
+	};
+
+	static_assert(streaming_hasher<xxhash64_hasher>);
+	static_assert(streaming_hasher<wyhash_hasher>);
+	static_assert(streaming_hasher<rapidhash_hasher>);
+	static_assert(streaming_hasher<chibihash_hasher>);
+
 	// ########################################################
 
 
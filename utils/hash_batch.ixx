@@ -0,0 +1,433 @@
+module;
+#include <immintrin.h>
+
+export module deckard.utils.hash_batch;
+
+import std;
+import deckard.types;
+import deckard.assert;
+import deckard.cpuid;
+import deckard.utils.hash;
+
+namespace deckard::utils
+{
+	/* Usage:
+
+		std::vector<std::span<const u8>> ids = ...;
+		std::vector<u64>                 hashes(ids.size());
+
+		hash_batch(ids, hashes);             // hashes[i] == hash(ids[i])
+		rapidhash_batch(ids, hashes);        // hashes[i] == rapidhash(ids[i])
+		hash_batch(id_bytes, 16, hashes);    // id_bytes holds hashes.size() keys of 16 bytes each
+
+	 Every key gets its loads done with scalar code, then 4 (AVX2) or 8 (AVX-512) keys go through
+	 the multiply-mix rounds together. There is no vector 64x64->128 multiply, each one is built
+	 from four 32x32->64 multiplies. Short keys are the target: wyhash keys of 48 bytes or more
+	 and rapidhash keys over 48 bytes are hashed one at a time inside the batch.
+	*/
+
+	export enum class hash_kernel : u8
+	{
+		scalar,
+		avx2,
+		avx512,
+	};
+
+	export [[nodiscard]] std::string_view to_string(hash_kernel kernel)
+	{
+		switch (kernel)
+		{
+			case hash_kernel::scalar: return "scalar";
+			case hash_kernel::avx2: return "avx2";
+			case hash_kernel::avx512: return "avx512";
+		}
+		return "unknown";
+	}
+
+	export [[nodiscard]] bool hash_kernel_supported(hash_kernel kernel)
+	{
+		switch (kernel)
+		{
+			case hash_kernel::avx2: return cpuid::has_avx2();
+			case hash_kernel::avx512: return cpuid::has_avx512();
+			default: return true;
+		}
+	}
+
+	export [[nodiscard]] hash_kernel best_hash_kernel()
+	{
+		static const hash_kernel best = cpuid::has_avx512() ? hash_kernel::avx512
+										: cpuid::has_avx2() ? hash_kernel::avx2
+															: hash_kernel::scalar;
+		return best;
+	}
+
+	namespace detail
+	{
+		// Same constants as hash(), which uses the default wyhash secret, and rapidhash()
+		constexpr u64 secret0    = 0x2d35'8dcc'aa6c'78a5ull;
+		constexpr u64 secret1    = 0x8bb8'4b93'962e'acc9ull;
+		constexpr u64 secret2    = 0x4b33'a62e'd433'd4a3ull;
+		constexpr u64 rapid_seed = 0xbdd8'9aa9'8270'4029ull;
+
+		[[nodiscard]] inline u64 mix(u64 a, u64 b) noexcept
+		{
+			const u64 a_lo = static_cast<u32>(a), a_hi = a >> 32;
+			const u64 b_lo = static_cast<u32>(b), b_hi = b >> 32;
+
+			const u64 ll  = a_lo * b_lo;
+			const u64 lh  = a_lo * b_hi;
+			const u64 hl  = a_hi * b_lo;
+			const u64 hh  = a_hi * b_hi;
+			const u64 mid = (ll >> 32) + static_cast<u32>(lh) + static_cast<u32>(hl);
+			return ((mid << 32) | static_cast<u32>(ll)) ^ (hh + (lh >> 32) + (hl >> 32) + (mid >> 32));
+		}
+
+		[[nodiscard]] inline u64 read_le64(const u8* p) noexcept
+		{
+			u64 v;
+			std::memcpy(&v, p, sizeof(v));
+			return v;
+		}
+
+		[[nodiscard]] inline u64 read_le32(const u8* p) noexcept
+		{
+			u32 v;
+			std::memcpy(&v, p, sizeof(v));
+			return v;
+		}
+
+		// rapidhash reads big endian
+		[[nodiscard]] inline u64 read_be64(const u8* p) noexcept { return std::byteswap(read_le64(p)); }
+
+		[[nodiscard]] inline u64 read_be32(const u8* p) noexcept { return std::byteswap(static_cast<u32>(read_le32(p))); }
+
+		// Both hashes end the same way once the loads are done:
+		//
+		//   round 1, 2 (if the lane has them)  seed = mix(x, y ^ seed)
+		//   then                               lo, hi = a ^ secret1 * b ^ seed
+		//                                      hash   = mix(lo ^ secret0 ^ len, hi ^ secret1)
+		//
+		// Lanes are filled with scalar loads, lanes in 'scalar' were hashed one at a time already.
+		template<u32 Lanes>
+		struct lane_block
+		{
+			alignas(64) std::array<u64, Lanes> seed{};
+			alignas(64) std::array<u64, Lanes> x1{};
+			alignas(64) std::array<u64, Lanes> y1{};
+			alignas(64) std::array<u64, Lanes> x2{};
+			alignas(64) std::array<u64, Lanes> y2{};
+			alignas(64) std::array<u64, Lanes> a{};
+			alignas(64) std::array<u64, Lanes> b{};
+			alignas(64) std::array<u64, Lanes> len{};
+
+			u32 round1{0};
+			u32 round2{0};
+			u32 scalar{0};
+		};
+
+		// Fills everything but the lane seed, keys the SIMD path doesn't take are hashed into out
+		template<u32 Lanes>
+		void load_wyhash_lane(lane_block<Lanes>& block, u32 lane, std::span<const u8> key, u64 seed, u64* out)
+		{
+			const u8* p = key.data();
+			const u64 n = key.size();
+
+			if (n >= 48)
+			{
+				*out = utils::wyhash(key, seed);
+				block.scalar |= 1u << lane;
+				return;
+			}
+
+			block.len[lane] = n;
+
+			if (n <= 16)
+			{
+				if (n >= 4)
+				{
+					const u64 step = (n >> 3) << 2;
+					block.a[lane]  = (read_le32(p) << 32) | read_le32(p + step);
+					block.b[lane]  = (read_le32(p + n - 4) << 32) | read_le32(p + n - 4 - step);
+				}
+				else if (n > 0)
+				{
+					block.a[lane] = (static_cast<u64>(p[0]) << 16) | (static_cast<u64>(p[n >> 1]) << 8) | p[n - 1];
+					block.b[lane] = 0;
+				}
+				else
+					block.a[lane] = block.b[lane] = 0;
+				return;
+			}
+
+			block.x1[lane] = read_le64(p) ^ secret1;
+			block.y1[lane] = read_le64(p + 8);
+			block.round1 |= 1u << lane;
+
+			u64 rest = n - 16;
+			p += 16;
+			if (rest > 16)
+			{
+				block.x2[lane] = read_le64(p) ^ secret1;
+				block.y2[lane] = read_le64(p + 8);
+				block.round2 |= 1u << lane;
+				rest -= 16;
+				p += 16;
+			}
+
+			block.a[lane] = read_le64(p + rest - 16);
+			block.b[lane] = read_le64(p + rest - 8);
+		}
+
+		template<u32 Lanes>
+		void load_rapidhash_lane(lane_block<Lanes>& block, u32 lane, std::span<const u8> key, u64 seed, u64* out)
+		{
+			const u8* p = key.data();
+			const u64 n = key.size();
+
+			if (n > 48)
+			{
+				*out = utils::rapidhash(p, n, seed);
+				block.scalar |= 1u << lane;
+				return;
+			}
+
+			block.len[lane] = n;
+
+			if (n <= 16)
+			{
+				if (n >= 4)
+				{
+					const u8* last  = p + n - 4;
+					const u64 delta = (n & 24) >> (n >> 3);
+					block.a[lane]   = (read_be32(p) << 32) | read_be32(last);
+					block.b[lane]   = (read_be32(p + delta) << 32) | read_be32(last - delta);
+				}
+				else if (n > 0)
+				{
+					block.a[lane] = (static_cast<u64>(p[0]) << 56) | (static_cast<u64>(p[n >> 1]) << 32) | p[n - 1];
+					block.b[lane] = 0;
+				}
+				else
+					block.a[lane] = block.b[lane] = 0;
+				return;
+			}
+
+			block.x1[lane] = read_be64(p) ^ secret2;
+			block.y1[lane] = read_be64(p + 8) ^ secret1;
+			block.round1 |= 1u << lane;
+
+			if (n > 32)
+			{
+				block.x2[lane] = read_be64(p + 16) ^ secret2;
+				block.y2[lane] = read_be64(p + 24);
+				block.round2 |= 1u << lane;
+			}
+
+			block.a[lane] = read_be64(p + n - 16);
+			block.b[lane] = read_be64(p + n - 8);
+		}
+
+		struct avx2
+		{
+			static constexpr u32 lanes = 4;
+
+			using reg = __m256i;
+
+			static reg load(const u64* p) noexcept { return _mm256_load_si256(reinterpret_cast<const reg*>(p)); }
+
+			static void store(u64* p, reg v) noexcept { _mm256_storeu_si256(reinterpret_cast<reg*>(p), v); }
+
+			static reg set1(u64 v) noexcept { return _mm256_set1_epi64x(static_cast<i64>(v)); }
+
+			static reg xor_(reg a, reg b) noexcept { return _mm256_xor_si256(a, b); }
+
+			static reg select(u32 mask, reg a, reg b) noexcept
+			{
+				const reg bits = _mm256_set_epi64x(8, 4, 2, 1);
+				const reg on   = _mm256_cmpeq_epi64(_mm256_and_si256(set1(mask), bits), bits);
+				return _mm256_blendv_epi8(b, a, on);
+			}
+
+			// 64x64->128 from 32x32->64 products
+			static void mul128(reg a, reg b, reg& lo, reg& hi) noexcept
+			{
+				const reg low32 = set1(0xFFFF'FFFFull);
+				const reg a_hi  = _mm256_srli_epi64(a, 32);
+				const reg b_hi  = _mm256_srli_epi64(b, 32);
+
+				const reg ll = _mm256_mul_epu32(a, b);
+				const reg lh = _mm256_mul_epu32(a, b_hi);
+				const reg hl = _mm256_mul_epu32(a_hi, b);
+				const reg hh = _mm256_mul_epu32(a_hi, b_hi);
+
+				const reg mid = _mm256_add_epi64(_mm256_add_epi64(_mm256_srli_epi64(ll, 32), _mm256_and_si256(lh, low32)), _mm256_and_si256(hl, low32));
+
+				lo = _mm256_or_si256(_mm256_and_si256(ll, low32), _mm256_slli_epi64(mid, 32));
+				hi = _mm256_add_epi64(_mm256_add_epi64(hh, _mm256_srli_epi64(lh, 32)), _mm256_add_epi64(_mm256_srli_epi64(hl, 32), _mm256_srli_epi64(mid, 32)));
+			}
+		};
+
+		struct avx512
+		{
+			static constexpr u32 lanes = 8;
+
+			using reg = __m512i;
+
+			static reg load(const u64* p) noexcept { return _mm512_load_si512(p); }
+
+			static void store(u64* p, reg v) noexcept { _mm512_storeu_si512(p, v); }
+
+			static reg set1(u64 v) noexcept { return _mm512_set1_epi64(static_cast<i64>(v)); }
+
+			static reg xor_(reg a, reg b) noexcept { return _mm512_xor_si512(a, b); }
+
+			static reg select(u32 mask, reg a, reg b) noexcept { return _mm512_mask_mov_epi64(b, static_cast<__mmask8>(mask), a); }
+
+			static void mul128(reg a, reg b, reg& lo, reg& hi) noexcept
+			{
+				const reg low32 = set1(0xFFFF'FFFFull);
+				const reg a_hi  = _mm512_srli_epi64(a, 32);
+				const reg b_hi  = _mm512_srli_epi64(b, 32);
+
+				const reg ll = _mm512_mul_epu32(a, b);
+				const reg lh = _mm512_mul_epu32(a, b_hi);
+				const reg hl = _mm512_mul_epu32(a_hi, b);
+				const reg hh = _mm512_mul_epu32(a_hi, b_hi);
+
+				const reg mid = _mm512_add_epi64(_mm512_add_epi64(_mm512_srli_epi64(ll, 32), _mm512_and_si512(lh, low32)), _mm512_and_si512(hl, low32));
+
+				lo = _mm512_or_si512(_mm512_and_si512(ll, low32), _mm512_slli_epi64(mid, 32));
+				hi = _mm512_add_epi64(_mm512_add_epi64(hh, _mm512_srli_epi64(lh, 32)), _mm512_add_epi64(_mm512_srli_epi64(hl, 32), _mm512_srli_epi64(mid, 32)));
+			}
+		};
+
+		template<typename V>
+		[[nodiscard]] typename V::reg mix(typename V::reg a, typename V::reg b) noexcept
+		{
+			typename V::reg lo, hi;
+			V::mul128(a, b, lo, hi);
+			return V::xor_(lo, hi);
+		}
+
+		// count <= V::lanes, lanes past count are left empty and not stored
+		template<typename V>
+		void finish(const lane_block<V::lanes>& block, u64* out, u32 count) noexcept
+		{
+			using reg = typename V::reg;
+
+			reg seed = V::load(block.seed.data());
+			if (block.round1 != 0)
+				seed = V::select(block.round1, mix<V>(V::load(block.x1.data()), V::xor_(V::load(block.y1.data()), seed)), seed);
+			if (block.round2 != 0)
+				seed = V::select(block.round2, mix<V>(V::load(block.x2.data()), V::xor_(V::load(block.y2.data()), seed)), seed);
+
+			reg lo, hi;
+			V::mul128(V::xor_(V::load(block.a.data()), V::set1(secret1)), V::xor_(V::load(block.b.data()), seed), lo, hi);
+
+			const reg hash = mix<V>(V::xor_(V::xor_(lo, V::set1(secret0)), V::load(block.len.data())), V::xor_(hi, V::set1(secret1)));
+
+			if (count == V::lanes and block.scalar == 0)
+			{
+				V::store(out, hash);
+				return;
+			}
+
+			alignas(64) std::array<u64, V::lanes> result;
+			V::store(result.data(), hash);
+			for (u32 lane = 0; lane < count; ++lane)
+				if ((block.scalar & (1u << lane)) == 0)
+					out[lane] = result[lane];
+		}
+
+		enum class algorithm : u8
+		{
+			wyhash,
+			rapidhash,
+		};
+
+		// key(i) returns the i:th key as a span
+		template<typename V, algorithm Algorithm, typename KeyAt>
+		void hash_lanes(u64 count, KeyAt&& key_at, std::span<u64> out, u64 seed)
+		{
+			const u64 mixed = seed ^ mix(seed ^ secret0, secret1);
+
+			for (u64 first = 0; first < count; first += V::lanes)
+			{
+				const u32 lanes = static_cast<u32>(std::min<u64>(V::lanes, count - first));
+
+				lane_block<V::lanes> block;
+				for (u32 lane = 0; lane < lanes; ++lane)
+				{
+					const std::span<const u8> key = key_at(first + lane);
+					if constexpr (Algorithm == algorithm::wyhash)
+					{
+						load_wyhash_lane(block, lane, key, seed, &out[first + lane]);
+						block.seed[lane] = mixed;
+					}
+					else
+					{
+						load_rapidhash_lane(block, lane, key, seed, &out[first + lane]);
+						block.seed[lane] = mixed ^ key.size();
+					}
+				}
+				finish<V>(block, &out[first], lanes);
+			}
+		}
+
+		template<algorithm Algorithm, typename KeyAt>
+		void dispatch(hash_kernel kernel, u64 count, KeyAt&& key_at, std::span<u64> out, u64 seed)
+		{
+			assert::check(out.size() == count, "hash batch output size must match the key count");
+			assert::check(hash_kernel_supported(kernel), "hash batch kernel not supported on this CPU");
+
+			switch (kernel)
+			{
+				case hash_kernel::avx512: hash_lanes<avx512, Algorithm>(count, key_at, out, seed); break;
+				case hash_kernel::avx2: hash_lanes<avx2, Algorithm>(count, key_at, out, seed); break;
+				default:
+					for (u64 i = 0; i < count; ++i)
+					{
+						const std::span<const u8> key = key_at(i);
+						if constexpr (Algorithm == algorithm::wyhash)
+							out[i] = utils::wyhash(key, seed);
+						else
+							out[i] = utils::rapidhash(key.data(), key.size(), seed);
+					}
+			}
+		}
+
+		[[nodiscard]] inline auto fixed_keys(std::span<const u8> keys, u64 key_size, u64 count)
+		{
+			assert::check(keys.size() == key_size * count, "fixed width keys must fill the buffer exactly");
+			return [keys, key_size](u64 i) { return keys.subspan(i * key_size, key_size); };
+		}
+
+	} // namespace detail
+
+	// out[i] = hash(keys[i], seed)
+	export void hash_batch(std::span<const std::span<const u8>> keys, std::span<u64> out, u64 seed = 0, hash_kernel kernel = best_hash_kernel())
+	{
+		detail::dispatch<detail::algorithm::wyhash>(kernel, keys.size(), [keys](u64 i) { return keys[i]; }, out, seed);
+	}
+
+	// keys holds out.size() keys of key_size bytes back to back
+	export void hash_batch(std::span<const u8> keys, u64 key_size, std::span<u64> out, u64 seed = 0, hash_kernel kernel = best_hash_kernel())
+	{
+		detail::dispatch<detail::algorithm::wyhash>(kernel, out.size(), detail::fixed_keys(keys, key_size, out.size()), out, seed);
+	}
+
+	// out[i] = rapidhash(keys[i]) or rapidhash(keys[i].data(), keys[i].size(), seed)
+	export void rapidhash_batch(
+	  std::span<const std::span<const u8>> keys, std::span<u64> out, u64 seed = detail::rapid_seed, hash_kernel kernel = best_hash_kernel())
+	{
+		detail::dispatch<detail::algorithm::rapidhash>(kernel, keys.size(), [keys](u64 i) { return keys[i]; }, out, seed);
+	}
+
+	export void rapidhash_batch(
+	  std::span<const u8> keys, u64 key_size, std::span<u64> out, u64 seed = detail::rapid_seed, hash_kernel kernel = best_hash_kernel())
+	{
+		detail::dispatch<detail::algorithm::rapidhash>(kernel, out.size(), detail::fixed_keys(keys, key_size, out.size()), out, seed);
+	}
+
+} // namespace deckard::utils
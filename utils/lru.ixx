@@ -6,79 +6,526 @@ import deckard.types;
 
 namespace deckard
 {
+	/* Usage:
+
+		lru_cache<u64, image> images(4096);
+
+		images.put(id, decode(file));
+		if (image* img = images.get(id)) // marks id as most recently used
+			draw(*img);
+
+		for (const auto& [id, img] : images) // most to least recently used
+			...
+
+	 Entries live in one contiguous slab and are linked by index, most recent first.
+	 Keys are found through an open addressing table (linear probing, load <= 0.5) that
+	 holds entry indices, erased slots are closed by shifting back so no tombstones build up.
+	 Once full, put() reuses the least recently used entry in place, nothing is allocated.
+	*/
+
+	export namespace detail
+	{
+		template<typename Key>
+		[[nodiscard]] u64 key_hash(const Key& key)
+		{
+			u64 h = static_cast<u64>(std::hash<Key>{}(key));
+			h ^= h >> 32;
+			h *= 0x9E37'79B9'7F4A'7C15ull;
+			h ^= h >> 29;
+			return h;
+		}
+
+		// Key to entry index table shared by the caches, the keys stay in the caller's entries.
+		// Linear probing with load <= 0.5, erased slots are closed by shifting back the rest of
+		// the probe run so eviction churn leaves no tombstones.
+		class key_index
+		{
+		public:
+			static constexpr u32 npos    = std::numeric_limits<u32>::max();
+			static constexpr u64 no_slot = std::numeric_limits<u64>::max();
+
+		private:
+			static constexpr u64 min_table_size = 16;
+
+			struct slot
+			{
+				u32 index{npos};
+				u32 hash{0};
+			};
+
+			std::pmr::vector<slot> m_slots;
+			u64                    m_mask{0};
+
+			void grow()
+			{
+				std::pmr::vector<slot> old(std::move(m_slots));
+
+				const u64 size = std::max<u64>(min_table_size, old.size() * 2);
+				m_slots.assign(size, slot{});
+				m_mask = size - 1;
+
+				for (const slot& s : old)
+					if (s.index != npos)
+						insert(s.index, s.hash);
+			}
+
+		public:
+			explicit key_index(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+				: m_slots(resource)
+			{
+			}
+
+			// Slot of the entry equal(index) accepts, no_slot when missing
+			template<typename Equal>
+			[[nodiscard]] u64 find(u32 hash, Equal&& equal) const
+			{
+				if (m_slots.empty())
+					return no_slot;
+
+				for (u64 pos = hash & m_mask;; pos = (pos + 1) & m_mask)
+				{
+					const slot& s = m_slots[pos];
+					if (s.index == npos)
+						return no_slot;
+					if (s.hash == hash and equal(s.index))
+						return pos;
+				}
+			}
+
+			[[nodiscard]] u32 index_at(u64 pos) const noexcept { return m_slots[pos].index; }
+
+			[[nodiscard]] u64 slot_of(u32 index, u32 hash) const noexcept
+			{
+				u64 pos = hash & m_mask;
+				while (m_slots[pos].index != index)
+					pos = (pos + 1) & m_mask;
+				return pos;
+			}
+
+			// Needs room, see reserve()
+			void insert(u32 index, u32 hash) noexcept
+			{
+				u64 pos = hash & m_mask;
+				while (m_slots[pos].index != npos)
+					pos = (pos + 1) & m_mask;
+				m_slots[pos] = {index, hash};
+			}
+
+			void remove(u64 hole) noexcept
+			{
+				for (u64 pos = (hole + 1) & m_mask; m_slots[pos].index != npos; pos = (pos + 1) & m_mask)
+				{
+					const u64 ideal = m_slots[pos].hash & m_mask;
+					if (((pos - ideal) & m_mask) >= ((pos - hole) & m_mask))
+					{
+						m_slots[hole] = m_slots[pos];
+						hole          = pos;
+					}
+				}
+				m_slots[hole] = {};
+			}
+
+			// Room for count keys
+			void reserve(u64 count)
+			{
+				while (count * 2 > m_slots.size())
+					grow();
+			}
+
+			void clear() noexcept { std::ranges::fill(m_slots, slot{}); }
+		};
+
+	} // namespace detail
+
 	export template<typename Key, typename Value>
 	class lru_cache
 	{
 	private:
-		static_assert(std::is_copy_constructible_v<Key>, "Key must be copy constructible");
-		static_assert(std::is_copy_constructible_v<Value>, "Value must be copy constructible");
-		static_assert(std::is_copy_assignable_v<Value>, "Value must be copy assignable");
-
 		using key_value_pair = std::pair<Key, Value>;
-		using list_iterator  = std::list<key_value_pair>::iterator;
 
-		std::list<key_value_pair>              cache_items_list;
-		std::unordered_map<Key, list_iterator> cache_items_map;
-		u64                                    max_size;
+		static constexpr u32 npos    = detail::key_index::npos;
+		static constexpr u64 no_slot = detail::key_index::no_slot;
+
+		struct entry
+		{
+			key_value_pair item;
+			u32            prev{npos};
+			u32            next{npos}; // next free entry when erased
+			u32            hash{0};
+		};
+
+		std::pmr::vector<entry> m_entries;
+		detail::key_index       m_index;
+		u64                     m_size{0};
+		u64                     max_size;
+		u32                     m_head{npos}; // most recently used
+		u32                     m_tail{npos}; // least recently used
+		u32                     m_free{npos};
+
+		[[nodiscard]] u64 find_slot(const Key& key, u32 hash) const
+		{
+			return m_index.find(hash, [&](u32 index) { return m_entries[index].item.first == key; });
+		}
+
+		void remove_entry(u64 pos)
+		{
+			const u32 index = m_index.index_at(pos);
+			m_index.remove(pos);
+			unlink(index);
+
+			if constexpr (std::is_default_constructible_v<Value>)
+				m_entries[index].item.second = Value{};
+
+			m_entries[index].next = m_free;
+			m_free                = index;
+			--m_size;
+		}
+
+		void unlink(u32 index) noexcept
+		{
+			entry& e = m_entries[index];
+			(e.prev != npos ? m_entries[e.prev].next : m_head) = e.next;
+			(e.next != npos ? m_entries[e.next].prev : m_tail) = e.prev;
+		}
+
+		void link_front(u32 index) noexcept
+		{
+			entry& e = m_entries[index];
+			e.prev   = npos;
+			e.next   = m_head;
+			(m_head != npos ? m_entries[m_head].prev : m_tail) = index;
+			m_head = index;
+		}
+
+		void touch(u32 index) noexcept
+		{
+			if (index == m_head)
+				return;
+			unlink(index);
+			link_front(index);
+		}
 
 	public:
-		explicit lru_cache(u64 max_size)
-			: max_size{max_size}
+		// Overloads taking hash = detail::key_hash(key), for callers that hash once
+		// and look the key up in several caches or shards
+
+		[[nodiscard]] Value* get(const Key& key, u64 hash64)
 		{
-			assert::check(max_size > 0, "lru_cache max_size must be greater than zero");
+			const u64 pos = find_slot(key, static_cast<u32>(hash64));
+			if (pos == no_slot)
+				return nullptr;
+
+			const u32 index = m_index.index_at(pos);
+			touch(index);
+			return &m_entries[index].item.second;
 		}
 
-		void put(Key key, Value value)
+		void put(Key key, Value value, u64 hash64)
 		{
-			auto it = cache_items_map.find(key);
-			if (it != cache_items_map.end())
+			const u32 hash = static_cast<u32>(hash64);
+
+			if (const u64 pos = find_slot(key, hash); pos != no_slot)
 			{
-				it->second->second = std::move(value);
-				cache_items_list.splice(cache_items_list.begin(), cache_items_list, it->second);
+				const u32 index = m_index.index_at(pos);
+
+				m_entries[index].item.second = std::move(value);
+				touch(index);
 				return;
 			}
 
-			cache_items_list.emplace_front(key, std::move(value));
-			cache_items_map.emplace(key, cache_items_list.begin());
-
-			if (cache_items_map.size() > max_size)
+			u32 index = npos;
+			if (m_size == max_size)
 			{
-				cache_items_map.erase(cache_items_list.back().first);
-				cache_items_list.pop_back();
+				// reuse the least recently used entry
+				index = m_tail;
+				m_index.remove(m_index.slot_of(index, m_entries[index].hash));
+				unlink(index);
+				m_entries[index].item = {std::move(key), std::move(value)};
 			}
+			else
+			{
+				m_index.reserve(m_size + 1);
+
+				if (m_free != npos)
+				{
+					index                 = m_free;
+					m_free                = m_entries[index].next;
+					m_entries[index].item = {std::move(key), std::move(value)};
+				}
+				else
+				{
+					index = static_cast<u32>(m_entries.size());
+					m_entries.push_back({.item = {std::move(key), std::move(value)}});
+				}
+				++m_size;
+			}
+
+			m_entries[index].hash = hash;
+			m_index.insert(index, hash);
+			link_front(index);
 		}
 
-#ifdef __cpp_lib_optional_ref
-#error ("use optional ref instead");
-		std::optional<const & Value> get(const Key& key)
-#else
-		std::optional<const Value> get(const Key& key)
-#endif
+		bool erase(const Key& key, u64 hash64)
 		{
-			if (auto it = cache_items_map.find(key); it != cache_items_map.end())
+			const u64 pos = find_slot(key, static_cast<u32>(hash64));
+			if (pos == no_slot)
+				return false;
+
+			remove_entry(pos);
+			return true;
+		}
+
+		[[nodiscard]] const Value* peek(const Key& key, u64 hash64) const
+		{
+			const u64 pos = find_slot(key, static_cast<u32>(hash64));
+			return pos != no_slot ? &m_entries[m_index.index_at(pos)].item.second : nullptr;
+		}
+
+		[[nodiscard]] bool exists(const Key& key, u64 hash64) const { return find_slot(key, static_cast<u32>(hash64)) != no_slot; }
+
+		// Most to least recently used
+		template<bool Const>
+		class basic_iterator
+		{
+		private:
+			using entries_type = std::conditional_t<Const, const std::pmr::vector<entry>, std::pmr::vector<entry>>;
+
+			entries_type* m_entries{nullptr};
+			u32           m_index{npos};
+
+		public:
+			using iterator_concept = std::forward_iterator_tag;
+			using value_type       = key_value_pair;
+			using difference_type  = i64;
+			using reference        = std::conditional_t<Const, const key_value_pair&, key_value_pair&>;
+			using pointer          = std::conditional_t<Const, const key_value_pair*, key_value_pair*>;
+
+			basic_iterator() = default;
+
+			basic_iterator(entries_type* entries, u32 index)
+				: m_entries(entries)
+				, m_index(index)
+			{
+			}
+
+			reference operator*() const { return (*m_entries)[m_index].item; }
+
+			pointer operator->() const { return &(*m_entries)[m_index].item; }
+
+			basic_iterator& operator++()
 			{
-				cache_items_list.splice(cache_items_list.begin(), cache_items_list, it->second);
-				return it->second->second;
+				m_index = (*m_entries)[m_index].next;
+				return *this;
 			}
 
-			return {};
+			basic_iterator operator++(int)
+			{
+				auto copy = *this;
+				++*this;
+				return copy;
+			}
+
+			friend bool operator==(const basic_iterator& a, const basic_iterator& b) { return a.m_index == b.m_index; }
+		};
+
+		using iterator       = basic_iterator<false>;
+		using const_iterator = basic_iterator<true>;
+
+		explicit lru_cache(u64 max_size, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+			: m_entries(resource)
+			, m_index(resource)
+			, max_size{max_size}
+		{
+			assert::check(max_size > 0, "lru_cache max_size must be greater than zero");
+			assert::check(max_size <= (1ull << 31), "lru_cache max_size is limited to 2^31 entries");
+		}
+
+		void put(Key key, Value value)
+		{
+			const u64 hash = detail::key_hash(key);
+			put(std::move(key), std::move(value), hash);
 		}
 
-		[[nodiscard]] bool exists(const Key& key) const { return cache_items_map.contains(key); }
+		// Marks key as most recently used. nullptr when missing,
+		// the pointer is valid until the next put, erase or clear.
+		[[nodiscard]] Value* get(const Key& key) { return get(key, detail::key_hash(key)); }
 
-		[[nodiscard]] u64 size() const { return cache_items_map.size(); }
+		// Lookup without changing the recency order
+		[[nodiscard]] const Value* peek(const Key& key) const { return peek(key, detail::key_hash(key)); }
+
+		// Least recently used entry, the next to be evicted, nullptr when empty
+		[[nodiscard]] const key_value_pair* lru() const noexcept { return m_tail != npos ? &m_entries[m_tail].item : nullptr; }
+
+		// Removes and returns the least recently used entry
+		std::optional<key_value_pair> pop_lru()
+		{
+			if (m_tail == npos)
+				return std::nullopt;
+
+			const u32                     index = m_tail;
+			std::optional<key_value_pair> item(std::move(m_entries[index].item));
+			remove_entry(m_index.slot_of(index, m_entries[index].hash));
+			return item;
+		}
+
+		bool erase(const Key& key) { return erase(key, detail::key_hash(key)); }
+
+		[[nodiscard]] bool exists(const Key& key) const { return exists(key, detail::key_hash(key)); }
+
+		void clear()
+		{
+			m_entries.clear();
+			m_index.clear();
+			m_size = 0;
+			m_head = m_tail = m_free = npos;
+		}
+
+		// Slab space for count entries, up to max_size
+		void reserve(u64 count)
+		{
+			count = std::min(count, max_size);
+			m_entries.reserve(count);
+			m_index.reserve(count);
+		}
+
+		[[nodiscard]] u64 size() const { return m_size; }
 
 		[[nodiscard]] u64 capacity() const { return max_size; }
 
 		// iterators
 
-		auto begin() { return cache_items_list.begin(); }
+		iterator begin() { return {&m_entries, m_head}; }
+
+		iterator end() { return {&m_entries, npos}; }
+
+		const_iterator begin() const { return {&m_entries, m_head}; }
+
+		const_iterator end() const { return {&m_entries, npos}; }
+	};
+
+	/* Thread-safe lru_cache split into shards by key hash, each with its own lock and
+	   capacity / shard_count entries, so recency and eviction are per shard.
+
+		concurrent_lru_cache<std::string, config_value> lookups(1'000'000);
+
+		lookups.put(path, value);
+		if (auto value = lookups.get(path)) // copy, made under the shard lock
+			...
+		lookups.visit(path, [](config_value& v) { ... }); // in place, under the shard lock
+	*/
+	export template<typename Key, typename Value>
+	class concurrent_lru_cache
+	{
+	private:
+		struct alignas(64) shard
+		{
+			mutable std::mutex                   mutex;
+			std::optional<lru_cache<Key, Value>> cache;
+		};
+
+		std::unique_ptr<shard[]> m_shards;
+		u32                      m_shard_bits{0};
+		u64                      max_size{0};
 
-		auto end() { return cache_items_list.end(); }
+		[[nodiscard]] shard& shard_of(u64 hash) const noexcept
+		{
+			return m_shards[m_shard_bits == 0 ? 0 : hash >> (64 - m_shard_bits)];
+		}
+
+	public:
+		explicit concurrent_lru_cache(u64 max_size, u32 shard_count = 16, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+			: max_size{max_size}
+		{
+			assert::check(std::has_single_bit(shard_count) and shard_count <= 256, "Shard count must be a power of two up to 256");
+			assert::check(max_size >= shard_count, "concurrent_lru_cache needs at least one entry per shard");
+
+			m_shard_bits = static_cast<u32>(std::countr_zero(shard_count));
+			m_shards     = std::make_unique<shard[]>(shard_count);
+
+			const u64 per_shard = (max_size + shard_count - 1) / shard_count;
+			for (u32 i = 0; i < shard_count; ++i)
+				m_shards[i].cache.emplace(per_shard, resource);
+		}
+
+		void put(Key key, Value value)
+		{
+			const u64 hash = detail::key_hash(key);
+			shard&    s    = shard_of(hash);
+
+			std::scoped_lock lock(s.mutex);
+			s.cache->put(std::move(key), std::move(value), hash);
+		}
+
+		// Copy of the value, a reference would outlive the shard lock
+		[[nodiscard]] std::optional<Value> get(const Key& key)
+		{
+			const u64 hash = detail::key_hash(key);
+			shard&    s    = shard_of(hash);
+
+			std::scoped_lock lock(s.mutex);
+			if (Value* value = s.cache->get(key, hash))
+				return *value;
+			return std::nullopt;
+		}
+
+		// Calls fn(Value&) under the shard lock, returns false when key is missing
+		template<typename Fn>
+		bool visit(const Key& key, Fn&& fn)
+		{
+			const u64 hash = detail::key_hash(key);
+			shard&    s    = shard_of(hash);
+
+			std::scoped_lock lock(s.mutex);
+			Value*           value = s.cache->get(key, hash);
+			if (value == nullptr)
+				return false;
+
+			std::invoke(std::forward<Fn>(fn), *value);
+			return true;
+		}
+
+		bool erase(const Key& key)
+		{
+			const u64 hash = detail::key_hash(key);
+			shard&    s    = shard_of(hash);
+
+			std::scoped_lock lock(s.mutex);
+			return s.cache->erase(key, hash);
+		}
+
+		[[nodiscard]] bool exists(const Key& key) const
+		{
+			const u64 hash = detail::key_hash(key);
+			shard&    s    = shard_of(hash);
+
+			std::scoped_lock lock(s.mutex);
+			return s.cache->exists(key, hash);
+		}
+
+		void clear()
+		{
+			for (u32 i = 0; i < shard_count(); ++i)
+			{
+				std::scoped_lock lock(m_shards[i].mutex);
+				m_shards[i].cache->clear();
+			}
+		}
+
+		// Sum over the shards, not a consistent snapshot while other threads write
+		[[nodiscard]] u64 size() const
+		{
+			u64 total = 0;
+			for (u32 i = 0; i < shard_count(); ++i)
+			{
+				std::scoped_lock lock(m_shards[i].mutex);
+				total += m_shards[i].cache->size();
+			}
+			return total;
+		}
+
+		[[nodiscard]] u64 capacity() const { return max_size; }
 
-		auto begin() const { return cache_items_list.begin(); }
-		
-		auto end() const { return cache_items_list.end(); }
+		[[nodiscard]] u32 shard_count() const noexcept { return 1u << m_shard_bits; }
 	};
 
 } // namespace deckard
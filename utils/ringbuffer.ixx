@@ -8,163 +8,630 @@ import deckard.assert;
 namespace deckard
 {
 
-	struct alignas(std::hardware_destructive_interference_size) SlotFlag
+	namespace detail
 	{
-		enum class State : u8
+		// Parks threads until the other side of a queue makes progress. notify() costs one fence
+		// when nobody is waiting, the waiter count keeps the futex call off the hot path.
+		class wait_gate
 		{
-			Empty   = 0,
-			Writing = 1,
-			Ready   = 2
+		private:
+			alignas(std::hardware_destructive_interference_size) std::atomic<u32> m_epoch{0};
+			std::atomic<u32> m_waiters{0};
+
+		public:
+			void notify() noexcept
+			{
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				if (m_waiters.load(std::memory_order_relaxed) == 0)
+					return;
+
+				m_epoch.fetch_add(1, std::memory_order_release);
+				m_epoch.notify_all();
+			}
+
+			// Blocks until attempt() returns true
+			template<typename Attempt>
+			void wait_until(Attempt&& attempt) noexcept
+			{
+				while (not attempt())
+				{
+					m_waiters.fetch_add(1, std::memory_order_relaxed);
+					std::atomic_thread_fence(std::memory_order_seq_cst);
+
+					const u32 epoch = m_epoch.load(std::memory_order_acquire);
+					if (attempt())
+					{
+						m_waiters.fetch_sub(1, std::memory_order_relaxed);
+						return;
+					}
+
+					m_epoch.wait(epoch, std::memory_order_acquire);
+					m_waiters.fetch_sub(1, std::memory_order_relaxed);
+				}
+			}
 		};
-		std::atomic<State> flag{State::Empty};
-	};
 
+		template<typename T>
+		struct alignas(T) storage
+		{
+			std::byte bytes[sizeof(T)];
+
+			[[nodiscard]] T* get() noexcept { return std::launder(reinterpret_cast<T*>(bytes)); }
+		};
+
+	} // namespace detail
+
+	/* Bounded multi-producer multi-consumer queue
+
+		atomic_ringbuffer<packet, 1024> inbox;
+
+		// network threads
+		if (not inbox.try_push(std::move(p)))
+			dropped++;
+
+		// workers
+		std::array<packet, 32> batch;
+		while (running)
+		{
+			u64 count = inbox.try_pop_n(batch);
+			...
+		}
+
+	 Every slot carries a sequence number (D. Vyukov's bounded MPMC queue): a producer may write
+	 slot pos when its sequence is pos, a consumer may read it when it is pos + 1. Producers and
+	 consumers only contend on their own index, a claim is a single CAS and never has to be undone.
+	*/
 	export template<typename T, std::size_t N>
 	class atomic_ringbuffer
 	{
 	private:
 		using index_type = u64;
-		static_assert((N & (N - 1)) == 0, "Must be a power of two");
-		static_assert(std::is_nothrow_move_constructible_v<T> || std::is_nothrow_copy_constructible_v<T>,
-					  "T must be move‑ or copy‑constructible without throwing");
-
-		alignas(std::hardware_destructive_interference_size) std::atomic<index_type> head{0};
-		alignas(std::hardware_destructive_interference_size) std::atomic<index_type> tail{0};
+		static_assert(N > 1 and (N & (N - 1)) == 0, "Must be a power of two");
+		static_assert(std::is_nothrow_move_constructible_v<T>, "T must be move-constructible without throwing");
 
-		const index_type mask{N - 1};
+		static constexpr index_type mask{N - 1};
 
-		struct alignas(T) Slot
+		struct slot
 		{
-			std::byte storage[sizeof(T)];
+			std::atomic<index_type> sequence{0};
+			detail::storage<T>      value;
 		};
 
-		std::vector<Slot>     slots;
-		std::vector<SlotFlag> flags;
+		alignas(std::hardware_destructive_interference_size) std::atomic<index_type> m_head{0};
+		alignas(std::hardware_destructive_interference_size) std::atomic<index_type> m_tail{0};
 
+		std::vector<slot> m_slots;
+
+		detail::wait_gate m_not_empty;
+		detail::wait_gate m_not_full;
+
+		// Claims up to count consecutive positions starting at the sequence offset,
+		// producers look for sequence == pos, consumers for sequence == pos + 1
+		[[nodiscard]] u64 claim(std::atomic<index_type>& index, index_type offset, u64 count, index_type& pos) noexcept
+		{
+			pos = index.load(std::memory_order_relaxed);
+			for (;;)
+			{
+				u64 available = 0;
+				while (available < count)
+				{
+					const index_type seq = m_slots[(pos + available) & mask].sequence.load(std::memory_order_acquire);
+					if (seq != pos + available + offset)
+						break;
+					++available;
+				}
+
+				if (available > 0)
+				{
+					if (index.compare_exchange_weak(pos, pos + available, std::memory_order_relaxed))
+						return available;
+					continue;
+				}
+
+				// first slot not ready: full/empty, or pos is stale
+				const index_type seq = m_slots[pos & mask].sequence.load(std::memory_order_acquire);
+				if (static_cast<i64>(seq - (pos + offset)) < 0)
+					return 0;
+
+				pos = index.load(std::memory_order_relaxed);
+			}
+		}
 
 	public:
-		constexpr atomic_ringbuffer() noexcept
-			: head{0}
-			, tail{0}
-			, mask{N - 1}
-			, slots(N)
-			, flags(N)
+		atomic_ringbuffer()
+			: m_slots(N)
+		{
+			for (index_type i = 0; i < N; ++i)
+				m_slots[i].sequence.store(i, std::memory_order_relaxed);
+		}
+
+		~atomic_ringbuffer()
 		{
+			const index_type tail = m_tail.load(std::memory_order_relaxed);
+			for (index_type pos = m_head.load(std::memory_order_relaxed); pos != tail; ++pos)
+				std::destroy_at(m_slots[pos & mask].value.get());
 		}
+
+		atomic_ringbuffer(const atomic_ringbuffer&)            = delete;
+		atomic_ringbuffer& operator=(const atomic_ringbuffer&) = delete;
+
+		template<typename... Args>
+		bool try_emplace(Args&&... args) noexcept
+		{
+			static_assert(std::is_nothrow_constructible_v<T, Args...>, "Construct T before pushing, a claimed slot can't be given back");
+
+			index_type pos = 0;
+			if (claim(m_tail, 0, 1, pos) == 0)
+				return false;
+
+			slot& s = m_slots[pos & mask];
+			std::construct_at(s.value.get(), std::forward<Args>(args)...);
+			s.sequence.store(pos + 1, std::memory_order_release);
+
+			m_not_empty.notify();
+			return true;
+		}
+
 		bool try_push(const T& value) noexcept
 		{
-			index_type pos   = tail.fetch_add(1, std::memory_order_relaxed);
-			index_type index = pos & mask;
+			if constexpr (std::is_nothrow_copy_constructible_v<T>)
+				return try_emplace(value);
+			else
+				return try_emplace(T(value));
+		}
+
+		bool try_push(T&& value) noexcept { return try_emplace(std::move(value)); }
+
+		// Pushes as many leading values as fit, returns the count pushed
+		u64 try_push_n(std::span<const T> values) noexcept
+		{
+			static_assert(std::is_nothrow_copy_constructible_v<T>, "T must be copy-constructible without throwing");
 
-			index_type current_head = head.load(std::memory_order_acquire);
-			if (pos - current_head >= N)
+			index_type pos   = 0;
+			const u64  count = claim(m_tail, 0, std::min<u64>(values.size(), N), pos);
+
+			for (u64 i = 0; i < count; ++i)
 			{
-				tail.fetch_sub(1, std::memory_order_relaxed);
-				return false;
+				slot& s = m_slots[(pos + i) & mask];
+				std::construct_at(s.value.get(), values[i]);
+				s.sequence.store(pos + i + 1, std::memory_order_release);
 			}
 
-			flags[index].flag.store(SlotFlag::State::Writing, std::memory_order_relaxed);
+			if (count > 0)
+				m_not_empty.notify();
+			return count;
+		}
+
+		std::optional<T> try_pop() noexcept
+		{
+			index_type pos = 0;
+			if (claim(m_head, 1, 1, pos) == 0)
+				return std::nullopt;
 
-			new (slots[index].storage) T(value);
+			slot&            s     = m_slots[pos & mask];
+			T*               elem  = s.value.get();
+			std::optional<T> value(std::move(*elem));
+			std::destroy_at(elem);
+			s.sequence.store(pos + N, std::memory_order_release);
 
-			flags[index].flag.store(SlotFlag::State::Ready, std::memory_order_release);
-			return true;
+			m_not_full.notify();
+			return value;
 		}
 
-		bool try_push(T&& value) noexcept
+		// Pops up to out.size() values in queue order, returns the count popped
+		u64 try_pop_n(std::span<T> out) noexcept
 		{
-			index_type pos   = tail.fetch_add(1, std::memory_order_relaxed);
-			index_type index = pos & mask;
+			static_assert(std::is_nothrow_move_assignable_v<T>, "T must be move-assignable without throwing");
+
+			index_type pos   = 0;
+			const u64  count = claim(m_head, 1, std::min<u64>(out.size(), N), pos);
 
-			index_type current_head = head.load(std::memory_order_acquire);
-			if (pos - current_head >= N)
+			for (u64 i = 0; i < count; ++i)
 			{
-				tail.fetch_sub(1, std::memory_order_relaxed);
-				return false;
+				slot& s    = m_slots[(pos + i) & mask];
+				T*    elem = s.value.get();
+				out[i]     = std::move(*elem);
+				std::destroy_at(elem);
+				s.sequence.store(pos + i + N, std::memory_order_release);
 			}
-			flags[index].flag.store(SlotFlag::State::Writing, std::memory_order_relaxed);
 
-			new (slots[index].storage) T(std::move(value));
+			if (count > 0)
+				m_not_full.notify();
+			return count;
+		}
 
-			flags[index].flag.store(SlotFlag::State::Ready, std::memory_order_release);
+		// Blocking, waits while the queue is full
+		void push(const T& value) noexcept
+		{
+			m_not_full.wait_until([&] { return try_push(value); });
+		}
+
+		void push(T&& value) noexcept
+		{
+			m_not_full.wait_until([&] { return try_push(std::move(value)); });
+		}
+
+		// Blocking, waits while the queue is empty
+		[[nodiscard]] T pop() noexcept
+		{
+			std::optional<T> value;
+			m_not_empty.wait_until(
+			  [&]
+			  {
+				  value = try_pop();
+				  return value.has_value();
+			  });
+			return std::move(*value);
+		}
+
+		// Approximate while other threads push or pop
+		[[nodiscard]] std::size_t size() const noexcept
+		{
+			const index_type head = m_head.load(std::memory_order_acquire);
+			const index_type tail = m_tail.load(std::memory_order_acquire);
+			return static_cast<std::size_t>(std::min<index_type>(tail - head, N));
+		}
+
+		[[nodiscard]] bool empty() const noexcept { return size() == 0; }
+
+		[[nodiscard]] bool full() const noexcept { return size() >= N; }
+
+		[[nodiscard]] static constexpr std::size_t capacity() noexcept { return N; }
+	};
+
+	/* Bounded single-producer single-consumer queue, one thread pushes and one thread pops.
+
+	 No CAS and no per-slot state: the producer owns the tail and the consumer owns the head.
+	 Each side keeps a cached copy of the other side's index and only reloads it, pulling
+	 the other side's cache line over, when the cached value says full or empty.
+	*/
+	export template<typename T, std::size_t N>
+	class spsc_ringbuffer
+	{
+	private:
+		using index_type = u64;
+		static_assert(N > 1 and (N & (N - 1)) == 0, "Must be a power of two");
+		static_assert(std::is_nothrow_move_constructible_v<T>, "T must be move-constructible without throwing");
+
+		static constexpr index_type mask{N - 1};
+
+		// consumer
+		alignas(std::hardware_destructive_interference_size) std::atomic<index_type> m_head{0};
+		index_type m_cached_tail{0};
+
+		// producer
+		alignas(std::hardware_destructive_interference_size) std::atomic<index_type> m_tail{0};
+		index_type m_cached_head{0};
+
+		std::vector<detail::storage<T>> m_slots;
+
+		detail::wait_gate m_not_empty;
+		detail::wait_gate m_not_full;
+
+		[[nodiscard]] u64 free_slots(index_type tail) noexcept
+		{
+			if (tail - m_cached_head >= N)
+				m_cached_head = m_head.load(std::memory_order_acquire);
+			return N - (tail - m_cached_head);
+		}
+
+		[[nodiscard]] u64 ready_slots(index_type head) noexcept
+		{
+			if (head == m_cached_tail)
+				m_cached_tail = m_tail.load(std::memory_order_acquire);
+			return m_cached_tail - head;
+		}
+
+	public:
+		spsc_ringbuffer()
+			: m_slots(N)
+		{
+		}
+
+		~spsc_ringbuffer()
+		{
+			const index_type tail = m_tail.load(std::memory_order_relaxed);
+			for (index_type pos = m_head.load(std::memory_order_relaxed); pos != tail; ++pos)
+				std::destroy_at(m_slots[pos & mask].get());
+		}
+
+		spsc_ringbuffer(const spsc_ringbuffer&)            = delete;
+		spsc_ringbuffer& operator=(const spsc_ringbuffer&) = delete;
+
+		// Producer side
+
+		template<typename... Args>
+		bool try_emplace(Args&&... args) noexcept
+		{
+			static_assert(std::is_nothrow_constructible_v<T, Args...>, "Construct T before pushing");
+
+			const index_type tail = m_tail.load(std::memory_order_relaxed);
+			if (free_slots(tail) == 0)
+				return false;
+
+			std::construct_at(m_slots[tail & mask].get(), std::forward<Args>(args)...);
+			m_tail.store(tail + 1, std::memory_order_release);
+
+			m_not_empty.notify();
 			return true;
 		}
 
-		std::optional<T> try_pop() noexcept
+		bool try_push(const T& value) noexcept
 		{
-			index_type pos   = head.fetch_add(1, std::memory_order_relaxed);
-			index_type index = pos & mask;
+			if constexpr (std::is_nothrow_copy_constructible_v<T>)
+				return try_emplace(value);
+			else
+				return try_emplace(T(value));
+		}
 
-			auto state = flags[index].flag.load(std::memory_order_acquire);
-			if (state != SlotFlag::State::Ready)
-			{
-				head.fetch_sub(1, std::memory_order_relaxed);
+		bool try_push(T&& value) noexcept { return try_emplace(std::move(value)); }
+
+		u64 try_push_n(std::span<const T> values) noexcept
+		{
+			static_assert(std::is_nothrow_copy_constructible_v<T>, "T must be copy-constructible without throwing");
+
+			const index_type tail  = m_tail.load(std::memory_order_relaxed);
+			const u64        count = std::min<u64>(values.size(), free_slots(tail));
+			if (count == 0)
+				return 0;
+
+			for (u64 i = 0; i < count; ++i)
+				std::construct_at(m_slots[(tail + i) & mask].get(), values[i]);
+			m_tail.store(tail + count, std::memory_order_release);
+
+			m_not_empty.notify();
+			return count;
+		}
+
+		void push(const T& value) noexcept
+		{
+			m_not_full.wait_until([&] { return try_push(value); });
+		}
+
+		void push(T&& value) noexcept
+		{
+			m_not_full.wait_until([&] { return try_push(std::move(value)); });
+		}
+
+		// Consumer side
+
+		std::optional<T> try_pop() noexcept
+		{
+			const index_type head = m_head.load(std::memory_order_relaxed);
+			if (ready_slots(head) == 0)
 				return std::nullopt;
-			}
 
-			T* elem  = reinterpret_cast<T*>(slots[index].storage);
-			T  value = std::move(*elem);
-			elem->~T();
+			T*               elem = m_slots[head & mask].get();
+			std::optional<T> value(std::move(*elem));
+			std::destroy_at(elem);
+			m_head.store(head + 1, std::memory_order_release);
 
-			flags[index].flag.store(SlotFlag::State::Empty, std::memory_order_release);
+			m_not_full.notify();
 			return value;
 		}
 
-		bool empty() const noexcept { return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire); }
+		u64 try_pop_n(std::span<T> out) noexcept
+		{
+			static_assert(std::is_nothrow_move_assignable_v<T>, "T must be move-assignable without throwing");
+
+			const index_type head  = m_head.load(std::memory_order_relaxed);
+			const u64        count = std::min<u64>(out.size(), ready_slots(head));
+			if (count == 0)
+				return 0;
+
+			for (u64 i = 0; i < count; ++i)
+			{
+				T* elem = m_slots[(head + i) & mask].get();
+				out[i]  = std::move(*elem);
+				std::destroy_at(elem);
+			}
+			m_head.store(head + count, std::memory_order_release);
+
+			m_not_full.notify();
+			return count;
+		}
+
+		[[nodiscard]] T pop() noexcept
+		{
+			std::optional<T> value;
+			m_not_empty.wait_until(
+			  [&]
+			  {
+				  value = try_pop();
+				  return value.has_value();
+			  });
+			return std::move(*value);
+		}
 
-		bool full() const noexcept { return (tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire)) >= N; }
+		// Either side
 
-		std::size_t size() const noexcept
+		[[nodiscard]] std::size_t size() const noexcept
 		{
-			return static_cast<std::size_t>(tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire));
+			const index_type head = m_head.load(std::memory_order_acquire);
+			const index_type tail = m_tail.load(std::memory_order_acquire);
+			return static_cast<std::size_t>(tail - head);
 		}
 
+		[[nodiscard]] bool empty() const noexcept { return size() == 0; }
+
+		[[nodiscard]] bool full() const noexcept { return size() >= N; }
+
+		[[nodiscard]] static constexpr std::size_t capacity() noexcept { return N; }
 	};
 
+	/* Overwriting ring buffer, pushing to a full buffer drops the oldest value
+
+		ringbuffer<f32> frame_times(128);
+		frame_times.push(dt);
+
+		for (f32 t : frame_times) // oldest to newest, no copy
+			...
+
+		auto [older, newer] = frame_times.as_spans(); // contiguous runs, e.g. for plotting
+		for (f32 t : frame_times.last(8))             // newest first
+			...
+
+	 Power of two capacities wrap indices with a mask, others with a compare and subtract.
+	*/
 	export template<typename T>
 	class ringbuffer
 	{
+	public:
 		using value_type      = T;
 		using size_type       = u32;
+		using difference_type = i64;
 		using reference       = T&;
 		using const_reference = const T&;
 		using array_type      = std::vector<value_type>;
 
+		// Random access over the logical order, index 0 is the oldest value
+		template<bool Const>
+		class basic_iterator
+		{
+		private:
+			using buffer_type = std::conditional_t<Const, const ringbuffer, ringbuffer>;
+
+			friend class basic_iterator<not Const>;
+
+			buffer_type* m_buffer{nullptr};
+			i64          m_index{0};
+
+		public:
+			using iterator_concept  = std::random_access_iterator_tag;
+			using iterator_category = std::random_access_iterator_tag;
+			using value_type        = T;
+			using difference_type   = i64;
+			using reference         = std::conditional_t<Const, const T&, T&>;
+			using pointer           = std::conditional_t<Const, const T*, T*>;
+
+			basic_iterator() = default;
+
+			basic_iterator(buffer_type* buffer, i64 index)
+				: m_buffer(buffer)
+				, m_index(index)
+			{
+			}
+
+			template<bool OtherConst>
+				requires(Const and not OtherConst)
+			basic_iterator(const basic_iterator<OtherConst>& other)
+				: m_buffer(other.m_buffer)
+				, m_index(other.m_index)
+			{
+			}
+
+			reference operator*() const { return (*m_buffer)[static_cast<size_type>(m_index)]; }
+
+			pointer operator->() const { return &**this; }
+
+			reference operator[](i64 n) const { return (*m_buffer)[static_cast<size_type>(m_index + n)]; }
+
+			basic_iterator& operator++()
+			{
+				++m_index;
+				return *this;
+			}
+
+			basic_iterator operator++(int)
+			{
+				auto copy = *this;
+				++m_index;
+				return copy;
+			}
+
+			basic_iterator& operator--()
+			{
+				--m_index;
+				return *this;
+			}
+
+			basic_iterator operator--(int)
+			{
+				auto copy = *this;
+				--m_index;
+				return copy;
+			}
+
+			basic_iterator& operator+=(i64 n)
+			{
+				m_index += n;
+				return *this;
+			}
+
+			basic_iterator& operator-=(i64 n)
+			{
+				m_index -= n;
+				return *this;
+			}
+
+			friend basic_iterator operator+(basic_iterator it, i64 n) { return it += n; }
+
+			friend basic_iterator operator+(i64 n, basic_iterator it) { return it += n; }
+
+			friend basic_iterator operator-(basic_iterator it, i64 n) { return it -= n; }
+
+			friend i64 operator-(const basic_iterator& a, const basic_iterator& b) { return a.m_index - b.m_index; }
+
+			friend bool operator==(const basic_iterator& a, const basic_iterator& b) { return a.m_index == b.m_index; }
+
+			friend auto operator<=>(const basic_iterator& a, const basic_iterator& b) { return a.m_index <=> b.m_index; }
+		};
+
+		using iterator       = basic_iterator<false>;
+		using const_iterator = basic_iterator<true>;
+
 	private:
 		array_type      m_array{};
-		size_type       m_head{1};
-		size_type       m_tail{0};
-		size_type       m_content_size{0};
 		const size_type m_array_size{0};
+		const size_type m_mask{0}; // capacity - 1 for power of two capacities, otherwise 0
+		size_type       m_head{0}; // oldest value
+		size_type       m_content_size{0};
 
-		void increment_tail()
+		// index < 2 * capacity
+		[[nodiscard]] size_type wrap(size_type index) const noexcept
 		{
-			++m_tail;
-			++m_content_size;
-
-			if (m_tail == m_array_size)
-				m_tail = 0;
+			if (m_mask != 0)
+				return index & m_mask;
+			return index >= m_array_size ? index - m_array_size : index;
 		}
 
+		[[nodiscard]] size_type index_of(size_type index) const noexcept { return wrap(m_head + index); }
+
 		void increment_head()
 		{
 			if (m_content_size == 0)
 				return;
-			++m_head;
+			m_head = wrap(m_head + 1);
 			--m_content_size;
+		}
 
-			if (m_head == m_array_size)
-				m_head = 0;
+		static void copy_elements(std::span<const value_type> from, value_type* to)
+		{
+			if constexpr (std::is_trivially_copyable_v<value_type>)
+			{
+				if (not from.empty())
+					std::memcpy(to, from.data(), from.size_bytes());
+			}
+			else
+				std::ranges::copy(from, to);
 		}
 
+		static void move_elements(std::span<value_type> from, value_type* to)
+		{
+			if constexpr (std::is_trivially_copyable_v<value_type>)
+			{
+				if (not from.empty())
+					std::memcpy(to, from.data(), from.size_bytes());
+			}
+			else
+				std::ranges::move(from, to);
+		}
 
 	public:
 		ringbuffer(size_type size = 8)
 			: m_array(size)
 			, m_array_size(size)
-			, m_head(1)
-			, m_tail(0)
-			, m_content_size(0)
+			, m_mask(std::has_single_bit(size) ? size - 1 : 0)
 		{
 			assert::check(m_array_size > 1, "size must be greater than 1");
 		}
@@ -181,20 +648,77 @@ namespace deckard
 
 		void clear()
 		{
-			m_head = 1;
-			m_tail = m_content_size = 0;
+			m_head         = 0;
+			m_content_size = 0;
 		}
 
 		void push_back(const value_type& item)
 		{
-			increment_tail();
-			if (m_content_size > m_array_size)
-				increment_head();
-			m_array[m_tail] = item;
+			if (m_content_size == m_array_size)
+			{
+				m_array[m_head] = item;
+				m_head          = wrap(m_head + 1);
+				return;
+			}
+
+			m_array[index_of(m_content_size)] = item;
+			++m_content_size;
+		}
+
+		void push_back(value_type&& item)
+		{
+			if (m_content_size == m_array_size)
+			{
+				m_array[m_head] = std::move(item);
+				m_head          = wrap(m_head + 1);
+				return;
+			}
+
+			m_array[index_of(m_content_size)] = std::move(item);
+			++m_content_size;
 		}
 
 		void push(const value_type& item) { push_back(item); }
 
+		void push(value_type&& item) { push_back(std::move(item)); }
+
+		// Same result as pushing each value in order, only the last capacity() values can survive
+		void push_range(std::span<const value_type> values)
+		{
+			if (values.size() > m_array_size)
+				values = values.last(m_array_size);
+
+			const size_type count      = static_cast<size_type>(values.size());
+			const size_type free_slots = m_array_size - m_content_size;
+			if (count > free_slots)
+			{
+				m_head = wrap(m_head + (count - free_slots));
+				m_content_size -= count - free_slots;
+			}
+
+			const size_type start = index_of(m_content_size);
+			const size_type first = std::min(count, m_array_size - start);
+			copy_elements(values.first(first), m_array.data() + start);
+			copy_elements(values.subspan(first), m_array.data());
+
+			m_content_size += count;
+		}
+
+		// Moves up to out.size() oldest values into out, returns the count popped
+		size_type pop_range(std::span<value_type> out)
+		{
+			const size_type count = static_cast<size_type>(std::min<u64>(out.size(), m_content_size));
+
+			auto [older, newer] = as_spans();
+			const size_type first = std::min(count, static_cast<size_type>(older.size()));
+			move_elements(older.first(first), out.data());
+			move_elements(newer.first(count - first), out.data() + first);
+
+			m_head = wrap(m_head + count);
+			m_content_size -= count;
+			return count;
+		}
+
 		[[nodiscard]] reference pop_front()
 		{
 			assert::check(m_content_size > 0, "pop from empty buffer");
@@ -213,22 +737,9 @@ namespace deckard
 
 		[[nodiscard]] bool full() const { return m_content_size == m_array_size; }
 
-		private:
-			[[nodiscard]] size_type index_of(size_type index) const noexcept
-			{
-				return (index + m_head) % m_array_size;
-			}
-
-		public:
-			[[nodiscard]] reference operator[](size_type index)
-			{
-				return m_array[index_of(index)];
-			}
+		[[nodiscard]] reference operator[](size_type index) { return m_array[index_of(index)]; }
 
-			[[nodiscard]] const_reference operator[](size_type index) const
-			{
-				return m_array[index_of(index)];
-			}
+		[[nodiscard]] const_reference operator[](size_type index) const { return m_array[index_of(index)]; }
 
 		[[nodiscard]] reference at(size_type index)
 		{
@@ -242,46 +753,46 @@ namespace deckard
 			return this->operator[](index);
 		}
 
-		//
-		[[nodiscard]] reference last()
+		// Contents oldest to newest as (up to) two contiguous runs, the second is empty unless the contents wrap
+		[[nodiscard]] std::pair<std::span<value_type>, std::span<value_type>> as_spans() noexcept
 		{
-			size_type pos = m_head - 1;
-			if (pos > m_array_size)
-				pos = m_array_size - 1;
-
-			return m_array[pos];
+			const size_type first = std::min(m_content_size, m_array_size - m_head);
+			return {std::span(m_array.data() + m_head, first), std::span(m_array.data(), m_content_size - first)};
 		}
 
-		[[nodiscard]] const_reference last() const
+		[[nodiscard]] std::pair<std::span<const value_type>, std::span<const value_type>> as_spans() const noexcept
 		{
-			size_type pos = m_head - 1;
-			if (pos > m_array_size)
-				pos = m_array_size - 1;
-
-			return m_array[pos];
+			const size_type first = std::min(m_content_size, m_array_size - m_head);
+			return {std::span(m_array.data() + m_head, first), std::span(m_array.data(), m_content_size - first)};
 		}
 
-		// TODO: iterator instead of copying
-		[[nodiscard]] std::vector<value_type> last(size_type count) const
+		// Newest value
+		[[nodiscard]] reference last() { return back(); }
+
+		[[nodiscard]] const_reference last() const { return back(); }
+
+		// View of the newest count values, newest first
+		[[nodiscard]] auto last(size_type count) const
 		{
 			assert::check(count <= m_content_size, "Cant get more than max size");
-			if (count == 0 or count > m_content_size)
-				return {};
+			count = std::min(count, m_content_size);
 
-			std::vector<value_type> ret;
-			ret.reserve(count);
-			size_type pos = m_head - 1;
-			while (count--)
-			{
-				if (pos > m_array_size)
-					pos = m_array_size - 1;
+			return std::ranges::subrange(end() - count, end()) | std::views::reverse;
+		}
 
-				ret.push_back(m_array[pos]);
-				pos--;
-			}
+		// iterators, oldest to newest
 
-			return ret;
-		}
+		iterator begin() noexcept { return {this, 0}; }
+
+		iterator end() noexcept { return {this, m_content_size}; }
+
+		const_iterator begin() const noexcept { return {this, 0}; }
+
+		const_iterator end() const noexcept { return {this, m_content_size}; }
+
+		const_iterator cbegin() const noexcept { return begin(); }
+
+		const_iterator cend() const noexcept { return end(); }
 	};
 
 
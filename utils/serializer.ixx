@@ -89,10 +89,10 @@ namespace deckard
 	export class serializer
 	{
 	private:
-		std::vector<u8> buffer;
-		u64             writepos{0};
-		u64             readpos{0};
-		padding         pad{padding::no};
+		std::pmr::vector<u8> buffer;
+		u64                  writepos{0};
+		u64                  readpos{0};
+		padding              pad{padding::no};
 
 	public:
 		template<std::integral T>
@@ -225,20 +225,26 @@ namespace deckard
 
 	public:
 		serializer()
-			: writepos{0}
+			: serializer(std::pmr::get_default_resource())
+		{
+		}
+
+		explicit serializer(std::pmr::memory_resource* resource)
+			: buffer(resource)
+			, writepos{0}
 			, pad{padding::no}
 		{
 			buffer.reserve(128);
 		}
 
-		serializer(padding p)
-			: serializer()
+		serializer(padding p, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+			: serializer(resource)
 		{
 			pad = p;
 		}
 
-		serializer(std::span<const u8> data)
-			: serializer()
+		serializer(std::span<const u8> data, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+			: serializer(resource)
 		{
 			buffer.insert(buffer.end(), data.begin(), data.end());
 			writepos = 0;
@@ -1,7 +1,11 @@
+module;
+#include <immintrin.h>
+
 export module deckard.sha;
 
 import deckard.assert;
 import deckard.as;
+import deckard.cpuid;
 import deckard.debug;
 import deckard.types;
 import deckard.helpers;
@@ -143,6 +147,32 @@ namespace deckard
 		std::array<u8, Size> binary{};
 	};
 
+	// SHA compression kernels, scalar is always available
+	export enum class sha_kernel : u8
+	{
+		scalar,
+		sha_ni, // SHA extensions, SHA-1 and SHA-256
+		avx2,   // 8 messages at once, sha256::hash_many only
+	};
+
+	export [[nodiscard]] bool sha_kernel_supported(sha_kernel kernel)
+	{
+		switch (kernel)
+		{
+			case sha_kernel::scalar: return true;
+			case sha_kernel::sha_ni: return cpuid::has_sha_ni();
+			case sha_kernel::avx2: return cpuid::has_avx2();
+			default: return false;
+		}
+	}
+
+	// Kernel used by the streaming hashers
+	export [[nodiscard]] sha_kernel default_sha_kernel()
+	{
+		static const sha_kernel best = cpuid::has_sha_ni() ? sha_kernel::sha_ni : sha_kernel::scalar;
+		return best;
+	}
+
 } // namespace deckard
 
 export template<typename T>
@@ -164,7 +194,18 @@ namespace deckard::sha1 // #####################################################
 		static constexpr u32 ROUNDS     = 80;
 		using Digest                    = digest;
 
-		hasher() { reset(); }
+		hasher()
+			: hasher(default_sha_kernel())
+		{
+		}
+
+		explicit hasher(sha_kernel kernel)
+			: m_kernel(kernel)
+		{
+			assert::check(kernel != sha_kernel::avx2, "sha1: avx2 is only a multi-buffer SHA-256 kernel");
+			assert::check(sha_kernel_supported(kernel), "sha1: kernel not supported on this CPU");
+			reset();
+		}
 
 		void reset()
 		{
@@ -196,7 +237,7 @@ namespace deckard::sha1 // #####################################################
 			if (buffer_len > 56)
 			{
 				std::fill(m_block.begin() + buffer_len, m_block.end(), std::byte{0});
-				compress(m_block);
+				compress(block_data(), 1);
 				buffer_len = 0;
 			}
 
@@ -205,7 +246,7 @@ namespace deckard::sha1 // #####################################################
 			for (int i = 0; i < 8; ++i)
 				m_block[63 - i] = std::byte{static_cast<u8>((bit_len >> (i * 8)) & 0xff)};
 
-			compress(m_block);
+			compress(block_data(), 1);
 
 			digest out{};
 			for (int i = 0; i < 5; ++i)
@@ -220,53 +261,66 @@ namespace deckard::sha1 // #####################################################
 		}
 
 	private:
+		const u8* block_data() const { return reinterpret_cast<const u8*>(m_block.data()); }
+
 		template<typename T>
+		requires(sizeof(T) == 1)
 		void generic_update(std::span<const T> data)
 		{
-			u64 i = 0;
+			const u8* ptr = reinterpret_cast<const u8*>(data.data());
+			u64       len = data.size();
 
 			if (buffer_len > 0)
 			{
 				u64 need = 64 - buffer_len;
-				if (data.size() < need)
+				if (len < need)
 				{
-					std::memcpy(m_block.data() + buffer_len, data.data(), data.size());
-					buffer_len += data.size();
+					std::memcpy(m_block.data() + buffer_len, ptr, len);
+					buffer_len += len;
 					return;
 				}
-				std::memcpy(m_block.data() + buffer_len, data.data(), need);
-				compress(m_block);
+				std::memcpy(m_block.data() + buffer_len, ptr, need);
+				compress(block_data(), 1);
 				total_len += 64;
-				i += need;
+				ptr += need;
+				len -= need;
 				buffer_len = 0;
 			}
 
-			for (; i + 64 <= data.size(); i += 64)
+			// Whole blocks straight from the input
+			if (const u64 blocks = len / 64; blocks > 0)
 			{
-				std::memcpy(m_block.data(), data.data() + i, 64);
-				compress(m_block);
-				total_len += 64;
+				compress(ptr, blocks);
+				total_len += blocks * 64;
+				ptr += blocks * 64;
+				len -= blocks * 64;
 			}
 
-			u64 remain = data.size() - i;
-			if (remain)
+			if (len > 0)
 			{
-				std::memcpy(m_block.data(), data.data() + i, remain);
-				buffer_len = remain;
+				std::memcpy(m_block.data(), ptr, len);
+				buffer_len = len;
 			}
 		}
 
-		void compress(const std::array<std::byte, 64>& blk)
+		void compress(const u8* data, u64 blocks)
 		{
-			std::array<u32, ROUNDS> w{};
-			for (int i = 0; i < 16; ++i)
+			if (m_kernel == sha_kernel::sha_ni)
 			{
-				std::size_t idx = i * 4;
-				w[i]            = (static_cast<u32>(std::to_integer<u8>(blk[idx])) << 24)
-								  | (static_cast<u32>(std::to_integer<u8>(blk[idx + 1])) << 16)
-								  | (static_cast<u32>(std::to_integer<u8>(blk[idx + 2])) << 8)
-								  | (static_cast<u32>(std::to_integer<u8>(blk[idx + 3])));
+				compress_sha_ni(data, blocks);
+				return;
 			}
+
+			for (; blocks > 0; --blocks, data += BLOCK_SIZE)
+				compress_scalar(data);
+		}
+
+		void compress_scalar(const u8* blk)
+		{
+			std::array<u32, ROUNDS> w{};
+			for (int i = 0; i < 16; ++i)
+				w[i] = load_as_be<u32>(blk + i * 4);
+
 			for (int i = 16; i < ROUNDS; ++i)
 				w[i] = std::rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
 
@@ -315,8 +369,77 @@ namespace deckard::sha1 // #####################################################
 			m_h[4] += e;
 		}
 
+		// Four rounds with the SHA extensions. e_in carries the next E plus the message words,
+		// next/prev/prev2 advance the message schedule 4 words at a time.
+		template<int Function, bool Msg2, bool Msg1, bool Xor>
+		static void rounds_sha_ni(
+		  __m128i& abcd, __m128i& e_in, __m128i& e_out, const __m128i& msg, __m128i& next, __m128i& prev, __m128i& prev2)
+		{
+			e_in  = _mm_sha1nexte_epu32(e_in, msg);
+			e_out = abcd;
+			if constexpr (Msg2)
+				next = _mm_sha1msg2_epu32(next, msg);
+			abcd = _mm_sha1rnds4_epu32(abcd, e_in, Function);
+			if constexpr (Msg1)
+				prev = _mm_sha1msg1_epu32(prev, msg);
+			if constexpr (Xor)
+				prev2 = _mm_xor_si128(prev2, msg);
+		}
+
+		void compress_sha_ni(const u8* data, u64 blocks)
+		{
+			const __m128i byteswap = _mm_set_epi64x(0x0001'0203'0405'0607ull, 0x0809'0a0b'0c0d'0e0full);
+
+			__m128i abcd = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(m_h.data())), 0x1B);
+			__m128i e0   = _mm_set_epi32(static_cast<int>(m_h[4]), 0, 0, 0);
+			__m128i e1{};
+
+			for (; blocks > 0; --blocks, data += BLOCK_SIZE)
+			{
+				const __m128i abcd_save = abcd;
+				const __m128i e0_save   = e0;
+
+				__m128i m0 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0)), byteswap);
+				__m128i m1 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16)), byteswap);
+				__m128i m2 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 32)), byteswap);
+				__m128i m3 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 48)), byteswap);
+
+				// Rounds 0-3
+				e0   = _mm_add_epi32(e0, m0);
+				e1   = abcd;
+				abcd = _mm_sha1rnds4_epu32(abcd, e0, 0);
+
+				rounds_sha_ni<0, false, true, false>(abcd, e1, e0, m1, m2, m0, m3);
+				rounds_sha_ni<0, false, true, true>(abcd, e0, e1, m2, m3, m1, m0);
+				rounds_sha_ni<0, true, true, true>(abcd, e1, e0, m3, m0, m2, m1);
+				rounds_sha_ni<0, true, true, true>(abcd, e0, e1, m0, m1, m3, m2); // 16-19
+				rounds_sha_ni<1, true, true, true>(abcd, e1, e0, m1, m2, m0, m3);
+				rounds_sha_ni<1, true, true, true>(abcd, e0, e1, m2, m3, m1, m0);
+				rounds_sha_ni<1, true, true, true>(abcd, e1, e0, m3, m0, m2, m1);
+				rounds_sha_ni<1, true, true, true>(abcd, e0, e1, m0, m1, m3, m2);
+				rounds_sha_ni<1, true, true, true>(abcd, e1, e0, m1, m2, m0, m3); // 36-39
+				rounds_sha_ni<2, true, true, true>(abcd, e0, e1, m2, m3, m1, m0);
+				rounds_sha_ni<2, true, true, true>(abcd, e1, e0, m3, m0, m2, m1);
+				rounds_sha_ni<2, true, true, true>(abcd, e0, e1, m0, m1, m3, m2);
+				rounds_sha_ni<2, true, true, true>(abcd, e1, e0, m1, m2, m0, m3);
+				rounds_sha_ni<2, true, true, true>(abcd, e0, e1, m2, m3, m1, m0); // 56-59
+				rounds_sha_ni<3, true, true, true>(abcd, e1, e0, m3, m0, m2, m1);
+				rounds_sha_ni<3, true, true, true>(abcd, e0, e1, m0, m1, m3, m2);
+				rounds_sha_ni<3, true, false, true>(abcd, e1, e0, m1, m2, m0, m3);
+				rounds_sha_ni<3, true, false, false>(abcd, e0, e1, m2, m3, m1, m0);
+				rounds_sha_ni<3, false, false, false>(abcd, e1, e0, m3, m0, m2, m1); // 76-79
+
+				e0   = _mm_sha1nexte_epu32(e0, e0_save);
+				abcd = _mm_add_epi32(abcd, abcd_save);
+			}
+
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(m_h.data()), _mm_shuffle_epi32(abcd, 0x1B));
+			m_h[4] = static_cast<u32>(_mm_extract_epi32(e0, 3));
+		}
+
 		std::array<u32, 5>                m_h{};
 		std::array<std::byte, BLOCK_SIZE> m_block{};
+		sha_kernel                        m_kernel{sha_kernel::scalar};
 		u64                               buffer_len{};
 		u64                               total_len{};
 	};
@@ -347,6 +470,19 @@ namespace deckard::sha256 // ###################################################
 	export using digest = generic_sha_digest<32>;
 	static_assert(sizeof(digest) == 32);
 
+	constexpr std::array<u32, 64> K = {
+	  0x428a'2f98, 0x7137'4491, 0xb5c0'fbcf, 0xe9b5'dba5, 0x3956'c25b, 0x59f1'11f1, 0x923f'82a4, 0xab1c'5ed5,
+	  0xd807'aa98, 0x1283'5b01, 0x2431'85be, 0x550c'7dc3, 0x72be'5d74, 0x80de'b1fe, 0x9bdc'06a7, 0xc19b'f174,
+	  0xe49b'69c1, 0xefbe'4786, 0x0fc1'9dc6, 0x240c'a1cc, 0x2de9'2c6f, 0x4a74'84aa, 0x5cb0'a9dc, 0x76f9'88da,
+	  0x983e'5152, 0xa831'c66d, 0xb003'27c8, 0xbf59'7fc7, 0xc6e0'0bf3, 0xd5a7'9147, 0x06ca'6351, 0x1429'2967,
+	  0x27b7'0a85, 0x2e1b'2138, 0x4d2c'6dfc, 0x5338'0d13, 0x650a'7354, 0x766a'0abb, 0x81c2'c92e, 0x9272'2c85,
+	  0xa2bf'e8a1, 0xa81a'664b, 0xc24b'8b70, 0xc76c'51a3, 0xd192'e819, 0xd699'0624, 0xf40e'3585, 0x106a'a070,
+	  0x19a4'c116, 0x1e37'6c08, 0x2748'774c, 0x34b0'bcb5, 0x391c'0cb3, 0x4ed8'aa4a, 0x5b9c'ca4f, 0x682e'6ff3,
+	  0x748f'82ee, 0x78a5'636f, 0x84c8'7814, 0x8cc7'0208, 0x90be'fffa, 0xa450'6ceb, 0xbef9'a3f7, 0xc671'78f2};
+
+	constexpr std::array<u32, 8> initial_state = {
+	  0x6A09'E667, 0xBB67'AE85, 0x3C6E'F372, 0xA54F'F53A, 0x510E'527F, 0x9B05'688C, 0x1F83'D9AB, 0x5BE0'CD19};
+
 	export class hasher
 	{
 	public:
@@ -356,12 +492,22 @@ namespace deckard::sha256 // ###################################################
 
 		using Digest = digest;
 
-		hasher() { reset(); }
+		hasher()
+			: hasher(default_sha_kernel())
+		{
+		}
+
+		explicit hasher(sha_kernel kernel)
+			: m_kernel(kernel)
+		{
+			assert::check(kernel != sha_kernel::avx2, "sha256: avx2 is a multi-buffer kernel, use sha256::hash_many");
+			assert::check(sha_kernel_supported(kernel), "sha256: kernel not supported on this CPU");
+			reset();
+		}
 
 		void reset()
 		{
-			m_state = {
-			  0x6A09'E667, 0xBB67'AE85, 0x3C6E'F372, 0xA54F'F53A, 0x510E'527F, 0x9B05'688C, 0x1F83'D9AB, 0x5BE0'CD19};
+			m_state      = initial_state;
 			m_block      = {};
 			m_bitlen     = 0ULL;
 			m_blockindex = 0ULL;
@@ -399,24 +545,55 @@ namespace deckard::sha256 // ###################################################
 			return ret;
 		}
 
-
 	private:
+		void transform(const u8* data, u64 blocks)
+		{
+			if (m_kernel == sha_kernel::sha_ni)
+			{
+				transform_sha_ni(data, blocks);
+				return;
+			}
+
+			for (; blocks > 0; --blocks, data += BLOCK_SIZE)
+				transform_scalar(data);
+		}
+
 		template<typename T>
+		requires(sizeof(T) == 1)
 		void generic_update(const std::span<const T> data)
 		{
-			if (data.empty())
-				return;
+			const u8* ptr = reinterpret_cast<const u8*>(data.data());
+			u64       len = data.size();
 
-			for (const auto& i : data)
+			if (m_blockindex > 0)
 			{
-				m_block[m_blockindex++] = static_cast<u8>(i);
-				if (m_blockindex == BLOCK_SIZE)
-				{
-					transform();
+				const u64 to_copy = std::min<u64>(BLOCK_SIZE - m_blockindex, len);
+				std::memcpy(m_block.data() + m_blockindex, ptr, to_copy);
+				m_blockindex += as<u32>(to_copy);
+				ptr += to_copy;
+				len -= to_copy;
 
-					m_bitlen += CHUNK_SIZE_IN_BITS;
-					m_blockindex = 0;
-				}
+				if (m_blockindex < BLOCK_SIZE)
+					return;
+
+				transform(m_block.data(), 1);
+				m_bitlen += CHUNK_SIZE_IN_BITS;
+				m_blockindex = 0;
+			}
+
+			// Whole blocks straight from the input
+			if (const u64 blocks = len / BLOCK_SIZE; blocks > 0)
+			{
+				transform(ptr, blocks);
+				m_bitlen += blocks * CHUNK_SIZE_IN_BITS;
+				ptr += blocks * BLOCK_SIZE;
+				len -= blocks * BLOCK_SIZE;
+			}
+
+			if (len > 0)
+			{
+				std::memcpy(m_block.data(), ptr, len);
+				m_blockindex = as<u32>(len);
 			}
 		}
 
@@ -428,13 +605,13 @@ namespace deckard::sha256 // ###################################################
 
 		u32 sig1(u32 x) { return std::rotr(x, 17) ^ std::rotr(x, 19) ^ (x >> 10); }
 
-		void transform()
+		void transform_scalar(const u8* block)
 		{
 			u32                maj{}, S0{}, ch{}, S1{}, temp1{}, temp2{}, w[ROUNDS]{0};
 			std::array<u32, 8> state;
 
 			for (u32 i = 0, j = 0; i < 16; i++, j += 4)
-				w[i] = load_as_be<u32>(&m_block[j]);
+				w[i] = load_as_be<u32>(block + j);
 
 			for (u32 i = 16; i < ROUNDS; i++)
 			{
@@ -468,25 +645,84 @@ namespace deckard::sha256 // ###################################################
 				m_state[i] += state[i];
 		}
 
-		void pad()
+		// Four rounds with the SHA extensions, Extend finishes the schedule words 4 ahead (next),
+		// Prepare starts the ones 12 ahead (prev)
+		template<bool Extend, bool Prepare>
+		static void rounds_sha_ni(__m128i& state0, __m128i& state1, const __m128i& msg, __m128i& prev, __m128i& next, u32 round)
 		{
-			u64 i = m_blockindex;
+			const __m128i wk = _mm_add_epi32(msg, _mm_loadu_si128(reinterpret_cast<const __m128i*>(&K[round])));
+
+			state1 = _mm_sha256rnds2_epu32(state1, state0, wk);
+			if constexpr (Extend)
+				next = _mm_sha256msg2_epu32(_mm_add_epi32(next, _mm_alignr_epi8(msg, prev, 4)), msg);
+			state0 = _mm_sha256rnds2_epu32(state0, state1, _mm_shuffle_epi32(wk, 0x0E));
+			if constexpr (Prepare)
+				prev = _mm_sha256msg1_epu32(prev, msg);
+		}
 
-			if (m_blockindex < (BLOCK_SIZE - 8))
+		void transform_sha_ni(const u8* data, u64 blocks)
+		{
+			const __m128i byteswap = _mm_set_epi64x(0x0c0d'0e0f'0809'0a0bull, 0x0405'0607'0001'0203ull);
+
+			// The instructions keep the state as ABEF / CDGH
+			__m128i tmp    = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&m_state[0])), 0xB1); // CDAB
+			__m128i state1 = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&m_state[4])), 0x1B); // EFGH
+			__m128i state0 = _mm_alignr_epi8(tmp, state1, 8);                                                     // ABEF
+			state1         = _mm_blend_epi16(state1, tmp, 0xF0);                                                  // CDGH
+
+			for (; blocks > 0; --blocks, data += BLOCK_SIZE)
 			{
-				m_block[i++] = 0x80;
-				while (i < (BLOCK_SIZE - 8))
-					m_block[i++] = 0x00;
+				const __m128i abef_save = state0;
+				const __m128i cdgh_save = state1;
+
+				__m128i m0 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0)), byteswap);
+				__m128i m1 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16)), byteswap);
+				__m128i m2 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 32)), byteswap);
+				__m128i m3 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 48)), byteswap);
+
+				rounds_sha_ni<false, false>(state0, state1, m0, m3, m1, 0);
+				rounds_sha_ni<false, true>(state0, state1, m1, m0, m2, 4);
+				rounds_sha_ni<false, true>(state0, state1, m2, m1, m3, 8);
+				rounds_sha_ni<true, true>(state0, state1, m3, m2, m0, 12);
+				rounds_sha_ni<true, true>(state0, state1, m0, m3, m1, 16);
+				rounds_sha_ni<true, true>(state0, state1, m1, m0, m2, 20);
+				rounds_sha_ni<true, true>(state0, state1, m2, m1, m3, 24);
+				rounds_sha_ni<true, true>(state0, state1, m3, m2, m0, 28);
+				rounds_sha_ni<true, true>(state0, state1, m0, m3, m1, 32);
+				rounds_sha_ni<true, true>(state0, state1, m1, m0, m2, 36);
+				rounds_sha_ni<true, true>(state0, state1, m2, m1, m3, 40);
+				rounds_sha_ni<true, true>(state0, state1, m3, m2, m0, 44);
+				rounds_sha_ni<true, true>(state0, state1, m0, m3, m1, 48);
+				rounds_sha_ni<true, false>(state0, state1, m1, m0, m2, 52);
+				rounds_sha_ni<true, false>(state0, state1, m2, m1, m3, 56);
+				rounds_sha_ni<false, false>(state0, state1, m3, m2, m0, 60);
+
+				state0 = _mm_add_epi32(state0, abef_save);
+				state1 = _mm_add_epi32(state1, cdgh_save);
 			}
-			else
-			{
-				m_block[i++] = 0x80;
-				while (i < (BLOCK_SIZE - 8))
-					m_block[i++] = 0x00;
 
-				std::fill_n(m_block.begin(), BLOCK_SIZE - 8, 0_u8);
-				transform();
+			tmp    = _mm_shuffle_epi32(state0, 0x1B);    // FEBA
+			state1 = _mm_shuffle_epi32(state1, 0xB1);    // DCHG
+			state0 = _mm_blend_epi16(tmp, state1, 0xF0); // DCBA
+			state1 = _mm_alignr_epi8(state1, tmp, 8);    // ABEF
+
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(&m_state[0]), state0);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(&m_state[4]), state1);
+		}
+
+		void pad()
+		{
+			u64 i = m_blockindex;
+
+			m_block[i++] = 0x80;
+			if (m_blockindex >= (BLOCK_SIZE - 8))
+			{
+				// No room for the length, it goes in one more block
+				std::fill(m_block.begin() + i, m_block.end(), 0_u8);
+				transform(m_block.data(), 1);
+				i = 0;
 			}
+			std::fill(m_block.begin() + i, m_block.begin() + (BLOCK_SIZE - 8), 0_u8);
 
 			m_bitlen += m_blockindex * 8;
 			m_block[63] = as<u8>(m_bitlen >> 0 & 0xFF);
@@ -498,23 +734,14 @@ namespace deckard::sha256 // ###################################################
 			m_block[57] = as<u8>(m_bitlen >> 48 & 0xFF);
 			m_block[56] = as<u8>(m_bitlen >> 56 & 0xFF);
 
-			transform();
+			transform(m_block.data(), 1);
 		}
 
 		std::array<u8, BLOCK_SIZE> m_block;
 		std::array<u32, 8>         m_state;
 		u64                        m_bitlen;
 		u32                        m_blockindex;
-
-		static constexpr std::array<u32, 64> K = {
-		  0x428a'2f98, 0x7137'4491, 0xb5c0'fbcf, 0xe9b5'dba5, 0x3956'c25b, 0x59f1'11f1, 0x923f'82a4, 0xab1c'5ed5,
-		  0xd807'aa98, 0x1283'5b01, 0x2431'85be, 0x550c'7dc3, 0x72be'5d74, 0x80de'b1fe, 0x9bdc'06a7, 0xc19b'f174,
-		  0xe49b'69c1, 0xefbe'4786, 0x0fc1'9dc6, 0x240c'a1cc, 0x2de9'2c6f, 0x4a74'84aa, 0x5cb0'a9dc, 0x76f9'88da,
-		  0x983e'5152, 0xa831'c66d, 0xb003'27c8, 0xbf59'7fc7, 0xc6e0'0bf3, 0xd5a7'9147, 0x06ca'6351, 0x1429'2967,
-		  0x27b7'0a85, 0x2e1b'2138, 0x4d2c'6dfc, 0x5338'0d13, 0x650a'7354, 0x766a'0abb, 0x81c2'c92e, 0x9272'2c85,
-		  0xa2bf'e8a1, 0xa81a'664b, 0xc24b'8b70, 0xc76c'51a3, 0xd192'e819, 0xd699'0624, 0xf40e'3585, 0x106a'a070,
-		  0x19a4'c116, 0x1e37'6c08, 0x2748'774c, 0x34b0'bcb5, 0x391c'0cb3, 0x4ed8'aa4a, 0x5b9c'ca4f, 0x682e'6ff3,
-		  0x748f'82ee, 0x78a5'636f, 0x84c8'7814, 0x8cc7'0208, 0x90be'fffa, 0xa450'6ceb, 0xbef9'a3f7, 0xc671'78f2};
+		sha_kernel                 m_kernel{sha_kernel::scalar};
 	};
 
 	export sha256::digest hash(std::string_view input)
@@ -524,6 +751,168 @@ namespace deckard::sha256 // ###################################################
 		return hasher.finalize();
 	}
 
+	namespace detail
+	{
+		// Eight lanes of u32, one message per lane
+		inline __m256i rotr(__m256i x, int n) { return _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - n)); }
+
+		inline __m256i add(__m256i a, __m256i b) { return _mm256_add_epi32(a, b); }
+
+		inline __m256i xor3(__m256i a, __m256i b, __m256i c) { return _mm256_xor_si256(_mm256_xor_si256(a, b), c); }
+
+		// Padded message blocks, block b of a lane comes from the message itself or from its padded tail
+		struct lane
+		{
+			const u8*           data{nullptr};
+			u64                 full_blocks{0};
+			u64                 blocks{0};
+			std::array<u8, 128> tail{};
+		};
+
+		inline void prepare_lane(lane& l, std::span<const u8> message)
+		{
+			const u64 len = message.size();
+
+			l.data        = message.data();
+			l.full_blocks = len / hasher::BLOCK_SIZE;
+			l.blocks      = (len + 8) / hasher::BLOCK_SIZE + 1;
+
+			const u64 rest = len - l.full_blocks * hasher::BLOCK_SIZE;
+			l.tail.fill(0);
+			if (rest > 0)
+				std::memcpy(l.tail.data(), message.data() + l.full_blocks * hasher::BLOCK_SIZE, rest);
+			l.tail[rest] = 0x80;
+
+			const u64 tail_size = (l.blocks - l.full_blocks) * hasher::BLOCK_SIZE;
+			const u64 bitlen    = len * 8;
+			for (u32 i = 0; i < 8; ++i)
+				l.tail[tail_size - 1 - i] = static_cast<u8>(bitlen >> (i * 8));
+		}
+
+		inline void hash8_avx2(std::span<const std::span<const u8>> messages, std::span<digest> out)
+		{
+			const u32 count = static_cast<u32>(messages.size());
+
+			std::array<lane, 8> lanes;
+			u64                 max_blocks = 0;
+			for (u32 i = 0; i < count; ++i)
+			{
+				prepare_lane(lanes[i], messages[i]);
+				max_blocks = std::max(max_blocks, lanes[i].blocks);
+			}
+
+			alignas(32) std::array<i32, 8> lane_blocks{};
+			for (u32 i = 0; i < count; ++i)
+				lane_blocks[i] = static_cast<i32>(lanes[i].blocks);
+			const __m256i blocks_left = _mm256_load_si256(reinterpret_cast<const __m256i*>(lane_blocks.data()));
+
+			__m256i state[8];
+			for (u32 i = 0; i < 8; ++i)
+				state[i] = _mm256_set1_epi32(static_cast<i32>(initial_state[i]));
+
+			for (u64 b = 0; b < max_blocks; ++b)
+			{
+				// Transpose the block words, w[j] holds word j of every lane
+				alignas(32) std::array<std::array<u32, 8>, 16> words{};
+				for (u32 i = 0; i < count; ++i)
+				{
+					const lane& l = lanes[i];
+					if (b >= l.blocks)
+						continue;
+
+					const u8* block = b < l.full_blocks ? l.data + b * hasher::BLOCK_SIZE : l.tail.data() + (b - l.full_blocks) * hasher::BLOCK_SIZE;
+					for (u32 j = 0; j < 16; ++j)
+						words[j][i] = load_as_be<u32>(block + j * 4);
+				}
+
+				__m256i w[16];
+				for (u32 j = 0; j < 16; ++j)
+					w[j] = _mm256_load_si256(reinterpret_cast<const __m256i*>(words[j].data()));
+
+				__m256i a = state[0], b_ = state[1], c = state[2], d = state[3];
+				__m256i e = state[4], f = state[5], g = state[6], h = state[7];
+
+				for (u32 i = 0; i < hasher::ROUNDS; ++i)
+				{
+					if (i >= 16)
+					{
+						const __m256i w15 = w[(i - 15) & 15];
+						const __m256i w2  = w[(i - 2) & 15];
+						const __m256i s0  = xor3(rotr(w15, 7), rotr(w15, 18), _mm256_srli_epi32(w15, 3));
+						const __m256i s1  = xor3(rotr(w2, 17), rotr(w2, 19), _mm256_srli_epi32(w2, 10));
+						w[i & 15]         = add(add(w[i & 15], s0), add(w[(i - 7) & 15], s1));
+					}
+
+					const __m256i S1    = xor3(rotr(e, 6), rotr(e, 11), rotr(e, 25));
+					const __m256i ch    = _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+					const __m256i temp1 = add(add(add(h, S1), add(ch, _mm256_set1_epi32(static_cast<i32>(K[i])))), w[i & 15]);
+					const __m256i S0    = xor3(rotr(a, 2), rotr(a, 13), rotr(a, 22));
+					const __m256i maj   = xor3(_mm256_and_si256(a, b_), _mm256_and_si256(a, c), _mm256_and_si256(b_, c));
+
+					h  = g;
+					g  = f;
+					f  = e;
+					e  = add(d, temp1);
+					d  = c;
+					c  = b_;
+					b_ = a;
+					a  = add(temp1, add(S0, maj));
+				}
+
+				// Lanes whose message already ended keep their state
+				const __m256i active = _mm256_cmpgt_epi32(blocks_left, _mm256_set1_epi32(static_cast<i32>(b)));
+				const __m256i result[8]{a, b_, c, d, e, f, g, h};
+				for (u32 i = 0; i < 8; ++i)
+					state[i] = _mm256_blendv_epi8(state[i], add(state[i], result[i]), active);
+			}
+
+			alignas(32) std::array<std::array<u32, 8>, 8> words;
+			for (u32 i = 0; i < 8; ++i)
+				_mm256_store_si256(reinterpret_cast<__m256i*>(words[i].data()), state[i]);
+
+			for (u32 l = 0; l < count; ++l)
+				for (u32 i = 0; i < 8; ++i)
+				{
+					const u32 word = words[i][l];
+					out[l][i * 4 + 0] = static_cast<u8>(word >> 24);
+					out[l][i * 4 + 1] = static_cast<u8>(word >> 16);
+					out[l][i * 4 + 2] = static_cast<u8>(word >> 8);
+					out[l][i * 4 + 3] = static_cast<u8>(word);
+				}
+		}
+	} // namespace detail
+
+	// Best kernel for many short messages, 8 AVX2 lanes beat one SHA-NI stream there
+	export [[nodiscard]] sha_kernel default_hash_many_kernel()
+	{
+		static const sha_kernel best = cpuid::has_avx2() ? sha_kernel::avx2 : default_sha_kernel();
+		return best;
+	}
+
+	// out[i] = SHA-256(messages[i]), avx2 hashes 8 messages per pass
+	export void hash_many(std::span<const std::span<const u8>> messages, std::span<digest> out, sha_kernel kernel = default_hash_many_kernel())
+	{
+		assert::check(messages.size() == out.size(), "sha256::hash_many: output size must match the message count");
+		assert::check(sha_kernel_supported(kernel), "sha256::hash_many: kernel not supported on this CPU");
+
+		if (kernel == sha_kernel::avx2)
+		{
+			for (u64 first = 0; first < messages.size(); first += 8)
+			{
+				const u64 count = std::min<u64>(8, messages.size() - first);
+				detail::hash8_avx2(messages.subspan(first, count), out.subspan(first, count));
+			}
+			return;
+		}
+
+		sha256::hasher hasher(kernel);
+		for (u64 i = 0; i < messages.size(); ++i)
+		{
+			hasher.update(messages[i]);
+			out[i] = hasher.finalize();
+		}
+	}
+
 	std::string quick_hash_generic(std::span<const u8> input)
 	{
 		sha256::hasher hasher;
@@ -614,21 +1003,39 @@ namespace deckard::sha512 // ###################################################
 
 	private:
 		template<typename T>
+		requires(sizeof(T) == 1)
 		void generic_update(const std::span<const T> data)
 		{
-			if (data.empty())
-				return;
+			const u8* ptr = reinterpret_cast<const u8*>(data.data());
+			u64       len = data.size();
 
-			for (const auto& i : data)
+			if (m_blockindex > 0)
 			{
-				m_block[m_blockindex++] = as<u8>(static_cast<u8>(i) & 0xFF);
-				if (m_blockindex == BLOCK_SIZE)
-				{
-					transform();
+				const u64 to_copy = std::min<u64>(BLOCK_SIZE - m_blockindex, len);
+				std::memcpy(m_block.data() + m_blockindex, ptr, to_copy);
+				m_blockindex += as<u32>(to_copy);
+				ptr += to_copy;
+				len -= to_copy;
 
-					m_bitlen += CHUNK_SIZE_IN_BITS;
-					m_blockindex = 0;
-				}
+				if (m_blockindex < BLOCK_SIZE)
+					return;
+
+				transform(m_block.data());
+				m_bitlen += CHUNK_SIZE_IN_BITS;
+				m_blockindex = 0;
+			}
+
+			// Whole blocks straight from the input
+			for (; len >= BLOCK_SIZE; ptr += BLOCK_SIZE, len -= BLOCK_SIZE)
+			{
+				transform(ptr);
+				m_bitlen += CHUNK_SIZE_IN_BITS;
+			}
+
+			if (len > 0)
+			{
+				std::memcpy(m_block.data(), ptr, len);
+				m_blockindex = as<u32>(len);
 			}
 		}
 
@@ -640,13 +1047,13 @@ namespace deckard::sha512 // ###################################################
 
 		u64 sig1(u64 x) { return (std::rotr(x, 19) ^ std::rotr(x, 61) ^ (x >> 6)); }
 
-		void transform()
+		void transform(const u8* block)
 		{
 			u64                maj{}, S0{}, ch{}, S1{}, temp1{}, temp2{}, w[ROUNDS]{0};
 			std::array<u64, 8> state;
 
 			for (u64 i = 0, j = 0; i < 16; i++, j += 8)
-				w[i] = load_as_be<u64>(&m_block[j]);
+				w[i] = load_as_be<u64>(block + j);
 
 
 			state = m_state;
@@ -684,21 +1091,15 @@ namespace deckard::sha512 // ###################################################
 		{
 			u64 i = m_blockindex;
 
-			if (m_blockindex < (BLOCK_SIZE - 8))
-			{
-				m_block[i++] = 0x80;
-				while (i < (BLOCK_SIZE - 8))
-					m_block[i++] = 0x00;
-			}
-			else
+			m_block[i++] = 0x80;
+			if (m_blockindex >= (BLOCK_SIZE - 16))
 			{
-				m_block[i++] = 0x80;
-				while (i < (BLOCK_SIZE - 8))
-					m_block[i++] = 0x00;
-
-				transform();
-				std::fill_n(&m_block[0], BLOCK_SIZE - 8, 0_u8);
+				// No room for the 128 bit length, it goes in one more block
+				std::fill(m_block.begin() + i, m_block.end(), 0_u8);
+				transform(m_block.data());
+				i = 0;
 			}
+			std::fill(m_block.begin() + i, m_block.begin() + (BLOCK_SIZE - 8), 0_u8);
 
 			m_bitlen += m_blockindex * 8;
 
@@ -711,7 +1112,7 @@ namespace deckard::sha512 // ###################################################
 			m_block[BLOCK_SIZE - 7] = as<u8>(m_bitlen >> 48 & 0xFF);
 			m_block[BLOCK_SIZE - 8] = as<u8>(m_bitlen >> 56 & 0xFF);
 
-			transform();
+			transform(m_block.data());
 		}
 
 		std::array<u8, BLOCK_SIZE> m_block;
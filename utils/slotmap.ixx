@@ -0,0 +1,231 @@
+export module deckard.slot_map;
+
+import std;
+import deckard.types;
+import deckard.assert;
+
+namespace deckard
+{
+	/* Usage:
+
+		slot_map<connection> connections;
+
+		auto handle = connections.emplace(socket, address);
+		if (auto* c = connections.get(handle))
+			c->send(packet);
+
+		connections.erase(handle);
+		connections.get(handle); // nullptr, the handle is stale
+
+		for (auto& c : connections) // dense, no holes
+			c.poll();
+
+	 Values live in one contiguous vector, erase moves the last value into the hole.
+	 Handles go through a sparse slot table with a generation per slot, a slot is reused
+	 through a free list and its generation changes every time, so old handles stop matching.
+	*/
+
+	export template<typename T>
+	class slot_map
+	{
+	public:
+		struct handle
+		{
+			static constexpr u32 invalid_index = std::numeric_limits<u32>::max();
+
+			u32 index{invalid_index};
+			u32 generation{0};
+
+			[[nodiscard]] bool valid() const noexcept { return index != invalid_index; }
+
+			bool operator==(const handle&) const = default;
+		};
+
+		using value_type     = T;
+		using iterator       = std::vector<T>::iterator;
+		using const_iterator = std::vector<T>::const_iterator;
+
+	private:
+		// Odd generation is occupied, even is free
+		struct slot
+		{
+			u32 index{0}; // dense index when occupied, next free slot when free
+			u32 generation{0};
+		};
+
+		static constexpr u32 end_of_free_list = std::numeric_limits<u32>::max();
+
+		std::vector<T>    m_values;
+		std::vector<u32>  m_dense_to_slot;
+		std::vector<slot> m_slots;
+		u32               m_free_head{end_of_free_list};
+
+		[[nodiscard]] const slot* find(handle h) const noexcept
+		{
+			if (h.index >= m_slots.size())
+				return nullptr;
+
+			const slot& s = m_slots[h.index];
+			return s.generation == h.generation and (s.generation & 1) ? &s : nullptr;
+		}
+
+		// Room for the next slot before the value is constructed, so acquire_slot cannot throw
+		void reserve_next_slot()
+		{
+			auto grow = [](auto& v)
+			{
+				if (v.size() == v.capacity())
+					v.reserve(std::max<u64>(8, v.capacity() * 2));
+			};
+
+			grow(m_dense_to_slot);
+			if (m_free_head == end_of_free_list)
+				grow(m_slots);
+		}
+
+		// For the value just appended to m_values, capacity comes from reserve_next_slot
+		[[nodiscard]] handle acquire_slot() noexcept
+		{
+			u32 slot_index = m_free_head;
+			if (slot_index != end_of_free_list)
+				m_free_head = m_slots[slot_index].index;
+			else
+			{
+				slot_index = static_cast<u32>(m_slots.size());
+				m_slots.push_back({});
+			}
+
+			slot& s      = m_slots[slot_index];
+			s.index      = static_cast<u32>(m_values.size() - 1);
+			s.generation = s.generation + 1;
+			m_dense_to_slot.push_back(slot_index);
+			return {slot_index, s.generation};
+		}
+
+	public:
+		slot_map() = default;
+
+		explicit slot_map(u64 initial_capacity) { reserve(initial_capacity); }
+
+		template<typename... Args>
+		handle emplace(Args&&... args)
+		{
+			assert::check(m_values.size() < end_of_free_list - 1, "slot_map capacity exceeded");
+
+			reserve_next_slot();
+			m_values.emplace_back(std::forward<Args>(args)...);
+			return acquire_slot();
+		}
+
+		handle insert(const T& value) { return emplace(value); }
+
+		handle insert(T&& value) { return emplace(std::move(value)); }
+
+		// Returns false for stale or invalid handles
+		bool erase(handle h)
+		{
+			const slot* found = find(h);
+			if (found == nullptr)
+				return false;
+
+			const u32 dense = found->index;
+			const u32 last  = static_cast<u32>(m_values.size() - 1);
+
+			if (dense != last)
+			{
+				m_values[dense]                       = std::move(m_values[last]);
+				m_dense_to_slot[dense]                = m_dense_to_slot[last];
+				m_slots[m_dense_to_slot[dense]].index = dense;
+			}
+
+			m_values.pop_back();
+			m_dense_to_slot.pop_back();
+
+			slot& s      = m_slots[h.index];
+			s.generation = s.generation + 1;
+			s.index      = m_free_head;
+			m_free_head  = h.index;
+			return true;
+		}
+
+		[[nodiscard]] bool contains(handle h) const noexcept { return find(h) != nullptr; }
+
+		// nullptr for stale or invalid handles
+		[[nodiscard]] T* get(handle h) noexcept
+		{
+			const slot* found = find(h);
+			return found ? &m_values[found->index] : nullptr;
+		}
+
+		[[nodiscard]] const T* get(handle h) const noexcept
+		{
+			const slot* found = find(h);
+			return found ? &m_values[found->index] : nullptr;
+		}
+
+		[[nodiscard]] T& operator[](handle h)
+		{
+			T* value = get(h);
+			assert::check(value != nullptr, "Stale or invalid slot_map handle");
+			return *value;
+		}
+
+		[[nodiscard]] const T& operator[](handle h) const
+		{
+			const T* value = get(h);
+			assert::check(value != nullptr, "Stale or invalid slot_map handle");
+			return *value;
+		}
+
+		// Handle of the value at dense position index, positions change on erase
+		[[nodiscard]] handle handle_at(u64 index) const
+		{
+			assert::check(index < m_values.size(), "slot_map index out of range");
+
+			const u32 slot_index = m_dense_to_slot[index];
+			return {slot_index, m_slots[slot_index].generation};
+		}
+
+		void clear() noexcept
+		{
+			for (u32 slot_index : m_dense_to_slot)
+			{
+				slot& s      = m_slots[slot_index];
+				s.generation = s.generation + 1;
+				s.index      = m_free_head;
+				m_free_head  = slot_index;
+			}
+
+			m_values.clear();
+			m_dense_to_slot.clear();
+		}
+
+		void reserve(u64 count)
+		{
+			m_values.reserve(count);
+			m_dense_to_slot.reserve(count);
+			m_slots.reserve(count);
+		}
+
+		[[nodiscard]] u64 size() const noexcept { return m_values.size(); }
+
+		[[nodiscard]] bool empty() const noexcept { return m_values.empty(); }
+
+		[[nodiscard]] u64 capacity() const noexcept { return m_values.capacity(); }
+
+		[[nodiscard]] std::span<T> values() noexcept { return m_values; }
+
+		[[nodiscard]] std::span<const T> values() const noexcept { return m_values; }
+
+		// iterators, dense order
+
+		iterator begin() noexcept { return m_values.begin(); }
+
+		iterator end() noexcept { return m_values.end(); }
+
+		const_iterator begin() const noexcept { return m_values.begin(); }
+
+		const_iterator end() const noexcept { return m_values.end(); }
+	};
+
+} // namespace deckard
@@ -6,9 +6,49 @@ import deckard.bytepool;
 import deckard.utf8;
 import deckard.debug;
 import deckard.assert;
+import deckard.utils.hash;
 
 namespace deckard
 {
+	// Read-only snapshot of a string_pool, see frozen_bytepool
+	export class frozen_string_pool
+	{
+	public:
+		using view_type = utf8::view;
+		using handle    = frozen_bytepool::handle;
+
+		static constexpr handle invalid_handle = frozen_bytepool::invalid_handle;
+
+	private:
+		frozen_bytepool m_pool;
+
+	public:
+		frozen_string_pool() = default;
+
+		explicit frozen_string_pool(frozen_bytepool pool)
+			: m_pool(std::move(pool))
+		{
+		}
+
+		[[nodiscard]] view_type get(handle h) const
+		{
+			auto span = m_pool.get(h);
+			assert::check(!span.empty(), "handle out of range");
+			return view_type(std::string_view(reinterpret_cast<const char*>(span.data()), span.size()));
+		}
+
+		[[nodiscard]] handle find(view_type str) const { return m_pool.find(str.data()); }
+
+		[[nodiscard]] handle find(std::string_view str) const { return find(utf8::view(str)); }
+
+		[[nodiscard]] bool contains(view_type str) const { return find(str) != invalid_handle; }
+
+		[[nodiscard]] bool contains(std::string_view str) const { return find(str) != invalid_handle; }
+
+		[[nodiscard]] size_t size() const noexcept { return m_pool.size(); }
+
+		[[nodiscard]] bool empty() const noexcept { return m_pool.empty(); }
+	};
 
 	export class string_pool
 	{
@@ -28,11 +68,13 @@ namespace deckard
 		}
 
 	public:
-		explicit string_pool(size_t initial_capacity = 256)
-			: m_pool(initial_capacity)
+		explicit string_pool(size_t initial_capacity = 256, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+			: m_pool(initial_capacity, resource)
 		{
 		}
 
+		[[nodiscard]] std::pmr::memory_resource* resource() const noexcept { return m_pool.resource(); }
+
 		void reset() noexcept { m_pool.reset(); }
 
 		[[nodiscard]] size_t size() const noexcept { return m_pool.size(); }
@@ -59,6 +101,12 @@ namespace deckard
 
 		[[nodiscard]] bool contains(std::string_view str) const noexcept { return contains(utf8::view(str)); }
 
+		[[nodiscard]] handle find(view_type str) const { return m_pool.find(str.data()); }
+
+		[[nodiscard]] handle find(std::string_view str) const { return find(utf8::view(str)); }
+
+		[[nodiscard]] frozen_string_pool freeze() const { return frozen_string_pool(m_pool.freeze()); }
+
 		void merge(string_pool& other) noexcept
 		{
 			m_pool.merge(other.m_pool);
@@ -87,4 +135,253 @@ namespace deckard
 			}
 		}
 	};
+
+	// ###########################################################################
+
+	// Thread-safe interner, strings are spread over shards by hash
+	//
+	//  concurrent_string_pool symbols;
+	//  pool.parallel_for(files, [&](const auto& file) { ... token.id = symbols.add(identifier); });
+	//
+	// Looking up a string that is already interned and get() never lock, a new string locks only
+	// its shard. Handles are (index << shard_bits) | shard, they stay valid while other shards grow.
+	export class concurrent_string_pool
+	{
+	public:
+		using view_type = utf8::view;
+		using handle    = u32;
+
+		static constexpr handle invalid_handle = std::numeric_limits<handle>::max();
+		static constexpr u64    chunk_size     = 64_KiB;
+
+	private:
+		struct entry
+		{
+			const u8* data{nullptr};
+			u32       length{0};
+		};
+
+		// Slots pack (hash << 32) | (index + 1), zero is empty
+		struct table
+		{
+			u64                                 mask{0};
+			std::unique_ptr<std::atomic<u64>[]> slots;
+
+			explicit table(u64 size)
+				: mask(size - 1)
+				, slots(std::make_unique<std::atomic<u64>[]>(size))
+			{
+			}
+		};
+
+		// Entries live in segments of doubling size that never move, so readers need no lock
+		static constexpr u32 first_segment_bits = 10;
+		static constexpr u32 segment_count      = 32 - first_segment_bits + 1;
+
+		struct alignas(64) shard
+		{
+			std::atomic<table*>                            current{nullptr};
+			std::array<std::atomic<entry*>, segment_count> segments{};
+			std::atomic<u32>                               count{0};
+
+			// writers only, under mutex
+			std::mutex                            mutex;
+			std::vector<std::unique_ptr<table>>   tables; // retired tables stay alive for readers
+			std::vector<std::unique_ptr<entry[]>> segment_storage;
+			std::vector<std::unique_ptr<u8[]>>    chunks;
+			u8*                                   chunk{nullptr};
+			u64                                   chunk_used{0};
+		};
+
+		std::unique_ptr<shard[]> m_shards;
+		u32                      m_shard_bits{0};
+
+		[[nodiscard]] static std::pair<u32, u32> locate(u32 index) noexcept
+		{
+			const u64 biased  = u64{index} + (1ull << first_segment_bits);
+			const u32 segment = static_cast<u32>(std::bit_width(biased)) - 1 - first_segment_bits;
+			return {segment, static_cast<u32>(biased - (1ull << (segment + first_segment_bits)))};
+		}
+
+		[[nodiscard]] static const entry& entry_at(const shard& s, u32 index) noexcept
+		{
+			const auto [segment, offset] = locate(index);
+			return s.segments[segment].load(std::memory_order_acquire)[offset];
+		}
+
+		[[nodiscard]] static std::span<const u8> bytes_of(const entry& e) noexcept { return {e.data, e.length}; }
+
+		[[nodiscard]] u32 shard_of(u64 hash) const noexcept { return m_shard_bits == 0 ? 0 : static_cast<u32>(hash >> (64 - m_shard_bits)); }
+
+		[[nodiscard]] handle encode(u32 index, u32 shard_index) const noexcept { return (index << m_shard_bits) | shard_index; }
+
+		[[nodiscard]] handle lookup(const shard& s, u32 shard_index, std::span<const u8> data, u32 hash) const noexcept
+		{
+			const table* t = s.current.load(std::memory_order_acquire);
+			for (u64 i = hash & t->mask;; i = (i + 1) & t->mask)
+			{
+				const u64 slot = t->slots[i].load(std::memory_order_acquire);
+				if (slot == 0)
+					return invalid_handle;
+
+				if (static_cast<u32>(slot >> 32) == hash)
+				{
+					const u32 index = static_cast<u32>(slot) - 1;
+					if (std::ranges::equal(bytes_of(entry_at(s, index)), data))
+						return encode(index, shard_index);
+				}
+			}
+		}
+
+		static void insert_slot(table& t, u64 slot) noexcept
+		{
+			u64 i = (slot >> 32) & t.mask;
+			while (t.slots[i].load(std::memory_order_relaxed) != 0)
+				i = (i + 1) & t.mask;
+			t.slots[i].store(slot, std::memory_order_release);
+		}
+
+		// Copies into a new table of twice the size and publishes it, readers on the old one still finish
+		static void grow(shard& s)
+		{
+			const table& old  = *s.current.load(std::memory_order_relaxed);
+			auto         next = std::make_unique<table>((old.mask + 1) * 2);
+
+			for (u64 i = 0; i <= old.mask; ++i)
+				if (const u64 slot = old.slots[i].load(std::memory_order_relaxed); slot != 0)
+					insert_slot(*next, slot);
+
+			s.current.store(next.get(), std::memory_order_release);
+			s.tables.push_back(std::move(next));
+		}
+
+		[[nodiscard]] static const u8* store_bytes(shard& s, std::span<const u8> data)
+		{
+			// big strings get their own allocation and leave the current chunk alone
+			if (data.size() > chunk_size / 4)
+			{
+				s.chunks.push_back(std::make_unique_for_overwrite<u8[]>(data.size()));
+				std::ranges::copy(data, s.chunks.back().get());
+				return s.chunks.back().get();
+			}
+
+			if (s.chunk == nullptr or s.chunk_used + data.size() > chunk_size)
+			{
+				s.chunks.push_back(std::make_unique_for_overwrite<u8[]>(chunk_size));
+				s.chunk      = s.chunks.back().get();
+				s.chunk_used = 0;
+			}
+
+			u8* dest = s.chunk + s.chunk_used;
+			std::ranges::copy(data, dest);
+			s.chunk_used += data.size();
+			return dest;
+		}
+
+	public:
+		explicit concurrent_string_pool(u32 shard_count = 16)
+		{
+			assert::check(std::has_single_bit(shard_count) and shard_count <= 256, "Shard count must be a power of two up to 256");
+
+			m_shard_bits = static_cast<u32>(std::countr_zero(shard_count));
+			m_shards     = std::make_unique<shard[]>(shard_count);
+
+			for (u32 i = 0; i < shard_count; ++i)
+			{
+				auto& s = m_shards[i];
+				s.tables.push_back(std::make_unique<table>(1u << first_segment_bits));
+				s.current.store(s.tables.back().get(), std::memory_order_release);
+			}
+		}
+
+		concurrent_string_pool(const concurrent_string_pool&)            = delete;
+		concurrent_string_pool& operator=(const concurrent_string_pool&) = delete;
+
+		[[nodiscard]] handle add(view_type str)
+		{
+			const auto data = str.data();
+			if (data.empty())
+				return invalid_handle;
+
+			const u64 hash64      = utils::rapidhash(data);
+			const u32 hash        = static_cast<u32>(hash64);
+			const u32 shard_index = shard_of(hash64);
+			shard&    s           = m_shards[shard_index];
+
+			if (const handle found = lookup(s, shard_index, data, hash); found != invalid_handle)
+				return found;
+
+			std::scoped_lock lock(s.mutex);
+
+			// another thread may have added it since
+			if (const handle found = lookup(s, shard_index, data, hash); found != invalid_handle)
+				return found;
+
+			const u32 index = s.count.load(std::memory_order_relaxed);
+			assert::check(index < (invalid_handle >> m_shard_bits), "concurrent_string_pool shard capacity exceeded");
+
+			const auto [segment, offset] = locate(index);
+			if (offset == 0)
+			{
+				s.segment_storage.push_back(std::make_unique<entry[]>(1ull << (segment + first_segment_bits)));
+				s.segments[segment].store(s.segment_storage.back().get(), std::memory_order_release);
+			}
+
+			entry& e = s.segment_storage[segment][offset];
+			e.data   = store_bytes(s, data);
+			e.length = static_cast<u32>(data.size());
+
+			if ((index + 1) * 2 > s.current.load(std::memory_order_relaxed)->mask + 1)
+				grow(s);
+
+			insert_slot(*s.current.load(std::memory_order_relaxed), (u64{hash} << 32) | (index + 1));
+			s.count.store(index + 1, std::memory_order_release);
+			return encode(index, shard_index);
+		}
+
+		[[nodiscard]] handle add(std::string_view str) { return add(view_type(str)); }
+
+		// Lock-free, invalid_handle if str has not been interned
+		[[nodiscard]] handle find(view_type str) const
+		{
+			const auto data = str.data();
+			if (data.empty())
+				return invalid_handle;
+
+			const u64 hash64      = utils::rapidhash(data);
+			const u32 shard_index = shard_of(hash64);
+			return lookup(m_shards[shard_index], shard_index, data, static_cast<u32>(hash64));
+		}
+
+		[[nodiscard]] handle find(std::string_view str) const { return find(view_type(str)); }
+
+		[[nodiscard]] bool contains(view_type str) const { return find(str) != invalid_handle; }
+
+		[[nodiscard]] bool contains(std::string_view str) const { return find(str) != invalid_handle; }
+
+		// Lock-free, h must come from add() on this pool
+		[[nodiscard]] view_type get(handle h) const
+		{
+			assert::check(h != invalid_handle, "invalid handle");
+
+			const u32    shard_index = h & ((1u << m_shard_bits) - 1);
+			const u32    index       = h >> m_shard_bits;
+			const shard& s           = m_shards[shard_index];
+			assert::check(index < s.count.load(std::memory_order_acquire), "handle out of range");
+
+			return view_type(bytes_of(entry_at(s, index)));
+		}
+
+		[[nodiscard]] size_t size() const noexcept
+		{
+			size_t total = 0;
+			for (u32 i = 0; i < (1u << m_shard_bits); ++i)
+				total += m_shards[i].count.load(std::memory_order_acquire);
+			return total;
+		}
+
+		[[nodiscard]] bool empty() const noexcept { return size() == 0; }
+
+		[[nodiscard]] u32 shard_count() const noexcept { return 1u << m_shard_bits; }
+	};
 } // namespace deckard
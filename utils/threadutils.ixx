@@ -1,6 +1,11 @@
 module;
+#ifdef _WIN32
 #include <Windows.h>
 #include <VersionHelpers.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
 
 export module deckard.threadutil;
 
@@ -77,5 +82,222 @@ namespace deckard::thread
 		#endif // WIN32
 	}
 
+	// ###########################################################################
+
+	// Logical processor as seen by the OS scheduler
+	export struct logical_cpu
+	{
+		u32 id{0};   // OS processor number, what set_thread_affinity takes
+		u32 core{0}; // dense physical core index, SMT siblings share it
+		u32 node{0}; // NUMA node
+	};
+
+	export struct cpu_topology
+	{
+		std::vector<logical_cpu> cpus;  // processors this process may run on
+		std::vector<u32>         nodes; // distinct NUMA node ids, ascending
+		u32                      cores{0};
+
+		[[nodiscard]] std::vector<u32> cpus_on_node(u32 node) const
+		{
+			std::vector<u32> ret;
+			for (const auto& cpu : cpus)
+				if (cpu.node == node)
+					ret.push_back(cpu.id);
+			return ret;
+		}
+
+		[[nodiscard]] bool smt() const noexcept { return cpus.size() > cores; }
+	};
+
+	namespace detail
+	{
+		void finish_topology(cpu_topology& topology)
+		{
+			if (topology.cpus.empty())
+			{
+				const u32 count = std::max(1u, std::thread::hardware_concurrency());
+				for (u32 i = 0; i < count; ++i)
+					topology.cpus.push_back({.id = i, .core = i, .node = 0});
+			}
+
+			std::ranges::sort(topology.cpus, {}, &logical_cpu::id);
+
+			topology.nodes.clear();
+			std::set<u32> cores;
+			for (const auto& cpu : topology.cpus)
+			{
+				cores.insert(cpu.core);
+				if (std::ranges::find(topology.nodes, cpu.node) == topology.nodes.end())
+					topology.nodes.push_back(cpu.node);
+			}
+			std::ranges::sort(topology.nodes);
+			topology.cores = static_cast<u32>(cores.size());
+		}
+
+		#ifdef __linux__
+		std::optional<u32> read_u32(const std::filesystem::path& path)
+		{
+			std::ifstream file(path);
+			u32           value{0};
+			if (file >> value)
+				return value;
+			return {};
+		}
+
+		// "0-3,8-11"
+		std::vector<u32> parse_cpulist(std::string_view list)
+		{
+			std::vector<u32> ret;
+			for (auto part : std::views::split(list, ','))
+			{
+				std::string_view range(part.begin(), part.end());
+				u32              first{0}, last{0};
+
+				auto [ptr, ec] = std::from_chars(range.data(), range.data() + range.size(), first);
+				if (ec != std::errc{})
+					continue;
+
+				last = first;
+				if (ptr != range.data() + range.size() and *ptr == '-')
+					std::from_chars(ptr + 1, range.data() + range.size(), last);
+
+				for (u32 cpu = first; cpu <= last; ++cpu)
+					ret.push_back(cpu);
+			}
+			return ret;
+		}
+		#endif
+	} // namespace detail
+
+	// Processors, physical cores and NUMA nodes available to this process
+	export cpu_topology query_topology()
+	{
+		cpu_topology topology;
+
+		#ifdef _WIN32
+		DWORD length = 0;
+		GetLogicalProcessorInformationEx(RelationAll, nullptr, &length);
+
+		std::vector<std::byte> buffer(length);
+		auto*                  first = reinterpret_cast<PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX>(buffer.data());
+
+		if (length > 0 and GetLogicalProcessorInformationEx(RelationAll, first, &length))
+		{
+			std::vector<std::pair<GROUP_AFFINITY, u32>> node_masks;
+			u32                                         core = 0;
+
+			for (DWORD offset = 0; offset < length;)
+			{
+				auto* info = reinterpret_cast<PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX>(buffer.data() + offset);
+
+				if (info->Relationship == RelationProcessorCore)
+				{
+					for (WORD g = 0; g < info->Processor.GroupCount; ++g)
+					{
+						const auto& mask = info->Processor.GroupMask[g];
+						for (u32 bit = 0; bit < 64; ++bit)
+							if (mask.Mask & (KAFFINITY{1} << bit))
+								topology.cpus.push_back({.id = mask.Group * 64u + bit, .core = core, .node = 0});
+					}
+					core++;
+				}
+				else if (info->Relationship == RelationNumaNode)
+					node_masks.emplace_back(info->NumaNode.GroupMask, info->NumaNode.NodeNumber);
+
+				offset += info->Size;
+			}
+
+			for (auto& cpu : topology.cpus)
+			{
+				for (const auto& [mask, node] : node_masks)
+					if (mask.Group == cpu.id / 64 and (mask.Mask & (KAFFINITY{1} << (cpu.id % 64))))
+						cpu.node = node;
+			}
+		}
+		#elif defined(__linux__)
+		namespace fs = std::filesystem;
+
+		cpu_set_t allowed;
+		CPU_ZERO(&allowed);
+		sched_getaffinity(0, sizeof(allowed), &allowed);
+
+		std::map<std::pair<u32, u32>, u32> cores; // (package, core_id) -> dense index
+		for (u32 id = 0; id < CPU_SETSIZE; ++id)
+		{
+			if (not CPU_ISSET(id, &allowed))
+				continue;
+
+			const fs::path base    = fs::path("/sys/devices/system/cpu") / std::format("cpu{}", id) / "topology";
+			const u32      package = detail::read_u32(base / "physical_package_id").value_or(0);
+			const u32      core_id = detail::read_u32(base / "core_id").value_or(id);
+
+			auto [it, _] = cores.try_emplace({package, core_id}, static_cast<u32>(cores.size()));
+			topology.cpus.push_back({.id = id, .core = it->second, .node = 0});
+		}
+
+		std::error_code ec;
+		for (const auto& entry : fs::directory_iterator("/sys/devices/system/node", ec))
+		{
+			const std::string name = entry.path().filename().string();
+			u32               node{0};
+			if (not name.starts_with("node") or std::from_chars(name.data() + 4, name.data() + name.size(), node).ec != std::errc{})
+				continue;
+
+			std::ifstream file(entry.path() / "cpulist");
+			std::string   list;
+			std::getline(file, list);
+
+			for (u32 id : detail::parse_cpulist(list))
+				for (auto& cpu : topology.cpus)
+					if (cpu.id == id)
+						cpu.node = node;
+		}
+		#endif
+
+		detail::finish_topology(topology);
+		return topology;
+	}
+
+	// Spin-wait hint, lets the sibling hyperthread run and saves power while busy waiting
+	export inline void cpu_relax() noexcept
+	{
+		#ifdef _WIN32
+		YieldProcessor();
+		#elif defined(__x86_64__) or defined(__i386__)
+		__builtin_ia32_pause();
+		#elif defined(__aarch64__)
+		asm volatile("yield");
+		#endif
+	}
+
+	// Restricts the calling thread to the given processors, empty span is a no-op.
+	// On Windows all processors must be in the same processor group as the first one.
+	export bool set_thread_affinity(std::span<const u32> cpus)
+	{
+		if (cpus.empty())
+			return true;
+
+		#ifdef _WIN32
+		GROUP_AFFINITY affinity{};
+		affinity.Group = static_cast<WORD>(cpus.front() / 64);
+		for (u32 cpu : cpus)
+			if (cpu / 64 == affinity.Group)
+				affinity.Mask |= KAFFINITY{1} << (cpu % 64);
+
+		return SetThreadGroupAffinity(GetCurrentThread(), &affinity, nullptr) != 0;
+		#elif defined(__linux__)
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		for (u32 cpu : cpus)
+			if (cpu < CPU_SETSIZE)
+				CPU_SET(cpu, &set);
+
+		return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+		#else
+		return false;
+		#endif
+	}
+
 
 } // namespace deckard::thread
@@ -0,0 +1,152 @@
+export module deckard.utils.tree_hash;
+
+import std;
+import deckard.types;
+import deckard.assert;
+import deckard.sha;
+import deckard.taskpool;
+import deckard.utils.hash;
+
+namespace deckard::utils
+{
+	/* Tree hashing, leaves are hashed in parallel and combined into one root
+
+		taskpool::taskpool pool;
+		auto view = file::map("archive.zip");
+
+		u64            id     = tree_xxh64(view.data(), pool);
+		sha256::digest digest = tree_sha256(view.data(), pool);
+
+	 Without a pool the same value is computed on the calling thread.
+
+	 Format (version 1), stable so stored values can be verified later:
+
+	   Input is cut into leaves of leaf_size bytes, the last one may be shorter.
+	   Empty input is a single empty leaf.
+
+	   tree_sha256 follows the RFC 6962 Merkle tree hash:
+		 leaf = SHA-256(0x00 || leaf bytes)
+		 node = SHA-256(0x01 || left || right)
+
+	   tree_xxh64:
+		 leaf = xxh64(leaf bytes, seed 0)
+		 node = xxh64(le64(left) || le64(right), seed 1)
+
+	   Nodes pair up left to right on each level, an unpaired last node moves up unchanged
+	   (same shape as RFC 6962's split at the largest power of two below the leaf count).
+	   A single leaf is the root, so tree_xxh64 of input up to leaf_size equals xxh64.
+
+	   The leaf size is part of the value, store it next to the digest if it is not the default.
+	*/
+
+	export constexpr u64 tree_leaf_size = 1024 * 1024;
+
+	namespace detail
+	{
+		struct tree_xxh64_traits
+		{
+			using digest = u64;
+
+			static digest leaf(std::span<const u8> data) { return xxh64(data, 0); }
+
+			static digest node(const digest& left, const digest& right)
+			{
+				std::array<u8, 16> pair{};
+				for (u32 i = 0; i < 8; ++i)
+				{
+					pair[i]     = static_cast<u8>(left >> (i * 8));
+					pair[i + 8] = static_cast<u8>(right >> (i * 8));
+				}
+				return xxh64(pair, 1);
+			}
+		};
+
+		struct tree_sha256_traits
+		{
+			using digest = sha256::digest;
+
+			static digest leaf(std::span<const u8> data)
+			{
+				sha256::hasher hasher;
+				hasher.update(std::array<u8, 1>{0x00});
+				hasher.update(data);
+				return hasher.finalize();
+			}
+
+			static digest node(const digest& left, const digest& right)
+			{
+				sha256::hasher hasher;
+				hasher.update(std::array<u8, 1>{0x01});
+				hasher.update(left.data());
+				hasher.update(right.data());
+				return hasher.finalize();
+			}
+		};
+
+		[[nodiscard]] inline u64 leaf_count(u64 size, u64 leaf_size) { return std::max<u64>(1, (size + leaf_size - 1) / leaf_size); }
+
+		template<typename Traits>
+		typename Traits::digest combine(std::vector<typename Traits::digest>& level)
+		{
+			while (level.size() > 1)
+			{
+				const u64 pairs = level.size() / 2;
+				for (u64 i = 0; i < pairs; ++i)
+					level[i] = Traits::node(level[2 * i], level[2 * i + 1]);
+
+				if (level.size() % 2 == 1)
+				{
+					level[pairs] = level.back();
+					level.resize(pairs + 1);
+				}
+				else
+					level.resize(pairs);
+			}
+			return level.front();
+		}
+
+		template<typename Traits>
+		typename Traits::digest tree_hash(std::span<const u8> data, taskpool::taskpool* pool, u64 leaf_size)
+		{
+			assert::check(leaf_size > 0, "tree hash leaf size must be non-zero");
+
+			const u64                            count = leaf_count(data.size(), leaf_size);
+			std::vector<typename Traits::digest> level(count);
+
+			auto hash_leaf = [&](u64 i)
+			{
+				const u64 offset = i * leaf_size;
+				level[i]         = Traits::leaf(data.subspan(offset, std::min(leaf_size, data.size() - offset)));
+			};
+
+			if (pool != nullptr and count > 1)
+				taskpool::parallel_for(*pool, u64{0}, count, hash_leaf, 1);
+			else
+				for (u64 i = 0; i < count; ++i)
+					hash_leaf(i);
+
+			return combine<Traits>(level);
+		}
+	} // namespace detail
+
+	export [[nodiscard]] u64 tree_xxh64(std::span<const u8> data, taskpool::taskpool& pool, u64 leaf_size = tree_leaf_size)
+	{
+		return detail::tree_hash<detail::tree_xxh64_traits>(data, &pool, leaf_size);
+	}
+
+	export [[nodiscard]] u64 tree_xxh64(std::span<const u8> data, u64 leaf_size = tree_leaf_size)
+	{
+		return detail::tree_hash<detail::tree_xxh64_traits>(data, nullptr, leaf_size);
+	}
+
+	export [[nodiscard]] sha256::digest tree_sha256(std::span<const u8> data, taskpool::taskpool& pool, u64 leaf_size = tree_leaf_size)
+	{
+		return detail::tree_hash<detail::tree_sha256_traits>(data, &pool, leaf_size);
+	}
+
+	export [[nodiscard]] sha256::digest tree_sha256(std::span<const u8> data, u64 leaf_size = tree_leaf_size)
+	{
+		return detail::tree_hash<detail::tree_sha256_traits>(data, nullptr, leaf_size);
+	}
+
+} // namespace deckard::utils